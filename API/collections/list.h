@@ -20,6 +20,10 @@
 #include <stdbool.h>
 #include "common/object.h"
 
+/* Macro definitions ---------------------------------------------------------*/
+/* lists served from a pool, the others come from the heap */
+#define LIST_POOL_SIZE		(8)
+
 /* Types ---------------------------------------------------------------------*/
 typedef struct
 {
@@ -33,6 +33,11 @@
  */
 uint32_t		umin			(uint32_t a,
 						 uint32_t b);
+/**
+ * Returns the greater from a or b.
+ */
+uint32_t		umax			(uint32_t a,
+						 uint32_t b);
 char *			bool_to_string		(bool val);
 void			die			(const char *reason);
 
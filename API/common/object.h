@@ -20,13 +20,17 @@
 /* Public forward declarations -----------------------------------------------*/
 /* Includes ------------------------------------------------------------------*/
 /* Public types --------------------------------------------------------------*/
+struct mm_arena;
 typedef struct object	object_t;
 typedef void		(*object_delete_f)			(object_t *);
 typedef char *		(*object_to_string_f)			(object_t *);
+typedef char *		(*object_to_string_arena_f)		(object_t *,
+								 struct mm_arena *);
 typedef struct object_ops
 {
-	object_delete_f		delete;
-	object_to_string_f	to_string;
+	object_delete_f			delete;
+	object_to_string_f		to_string;
+	object_to_string_arena_f	to_string_arena;
 }			object_ops_t;
 
 struct object
@@ -44,11 +48,21 @@ struct object
 void		object_delete				(object_t *self);
 
 /**
- *
- * @param self
- * @return Dynamically allocated
+ * Describe this object. Every to_string allocates with mm_alloc, the
+ * to_string_arena fallback relies on it.
+ * @param self	this object.
+ * @return Allocated with mm_alloc, released with mm_free.
  */
 char *		object_to_string			(object_t *self);
 
+/**
+ * Same as object_to_string but the string lives in arena.
+ * @param self	this object.
+ * @param arena	arena holding the result.
+ * @return Allocated from arena, released with it.
+ */
+char *		object_to_string_arena			(object_t *self,
+							 struct mm_arena *arena);
+
 #endif
 
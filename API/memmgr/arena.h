@@ -0,0 +1,73 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_ARENA_H__
+#define __MEMMGR_ARENA_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define	mm_arena_declare(var_name, size) \
+		mm_arena_t var_name = { .current = NULL, .block_size = (size) }
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct mm_arena_block mm_arena_block_t;
+
+typedef struct mm_arena
+{
+	mm_arena_block_t	*current;
+	uint32_t		block_size;
+} mm_arena_t;
+
+typedef struct
+{
+	mm_arena_block_t	*block;
+	uint32_t		used;
+} mm_arena_mark_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Prepare an empty arena.
+ * @param	block_size	Payload of each chunk taken from the heap. Bigger
+ *				requests get a chunk of their own.
+ */
+void			mm_arena_init		(mm_arena_t *this,
+						 uint32_t block_size);
+/**
+ * Bump-allocate from the arena. Blocks are never freed individually.
+ * @return	NULL if no memory is available.
+ */
+void *			mm_arena_alloc		(mm_arena_t *this,
+						 uint32_t size);
+void *			mm_arena_zalloc		(mm_arena_t *this,
+						 uint32_t size);
+/**
+ * Remember the current fill level of the arena.
+ */
+mm_arena_mark_t		mm_arena_mark		(mm_arena_t *this);
+/**
+ * Release everything allocated since mark was taken. Marks taken after it
+ * become invalid.
+ */
+void			mm_arena_restore	(mm_arena_t *this,
+						 mm_arena_mark_t mark);
+/**
+ * Release everything allocated from the arena.
+ */
+void			mm_arena_reset		(mm_arena_t *this);
+
+#endif
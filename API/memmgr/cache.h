@@ -0,0 +1,72 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_CACHE_H__
+#define __MEMMGR_CACHE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "memmgr_conf.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+/* payload size served by the smallest class, each next class doubles it */
+#define MM_CACHE_MIN_PAYLOAD	(8)
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct
+{
+	void *		first;
+	uint32_t	count;
+} mm_cache_bin_t;
+
+typedef struct
+{
+	mm_cache_bin_t	bins[MM_CFG_CACHE_CLASSES];
+} mm_cache_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Prepare an empty cache.
+ */
+void			mm_cache_init		(mm_cache_t *this);
+/**
+ * Serve a small allocation from the cache, refilling it by batch if needed.
+ * @param	size	Requested size in byte.
+ * @param	lr	Call site recorded on refilled chunks.
+ * @return	NULL if the request is not cacheable or the heap is exhausted.
+ */
+void *			mm_cache_alloc		(mm_cache_t *this,
+						 uint32_t size,
+						 void *lr);
+/**
+ * Keep a chunk in the cache, flushing a batch back to the heap if full.
+ * @return	false if the chunk is not cacheable and must go back to the heap.
+ */
+bool			mm_cache_free		(mm_cache_t *this,
+						 void *ptr);
+/**
+ * @return	true if the chunk was freed into the cache and not handed out since.
+ */
+bool			mm_cache_holds		(mm_cache_t *this,
+						 void *ptr);
+/**
+ * Give every cached chunk back to the heap.
+ */
+void			mm_cache_drain		(mm_cache_t *this);
+
+#endif
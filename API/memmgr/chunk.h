@@ -21,11 +21,54 @@
 #include <stdbool.h>
 
 #include "common/mockable.h"
+#include "memmgr_conf.h"
 
 /* Macro definitions ---------------------------------------------------------*/
-#define CSIZE_MAX		(32767)
+#if MM_CFG_WIDE_HEADER
+#define CSIZE_BITS		(30)
+#else
+#define CSIZE_BITS		(15)
+#endif
+#define CSIZE_MAX		((1 << CSIZE_BITS) - 1)
+
+/* MM_CFG_INTEGRITY levels, each one checks everything the previous does */
+#define MM_INTEGRITY_OFF	(0)	/* pointer alignment and bounds only */
+#define MM_INTEGRITY_CHECKSUM	(1)	/* + header xorsum */
+#define MM_INTEGRITY_CANARY	(2)	/* + MM_CFG_GUARD_SIZE canary past the payload */
+#define MM_INTEGRITY_FULL	(3)	/* + whole unused tail of the chunk */
+
+/* space reserved after each payload, only worth it when something checks it */
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CANARY
+#define MM_GUARD_CSIZE		(MM_CFG_GUARD_SIZE)
+#else
+#define MM_GUARD_CSIZE		(0)
+#endif
+
+/* free index geometry: MM_SL_COUNT linear sub-classes per power of two */
+#define MM_SL_LOG2		(3)
+#define MM_SL_COUNT		(1 << MM_SL_LOG2)
+#define MM_FL_COUNT		(CSIZE_BITS - MM_SL_LOG2 + 1)
 
 /* Types ---------------------------------------------------------------------*/
+#if MM_CFG_WIDE_HEADER
+typedef uint32_t	mm_csize_t;
+
+typedef struct
+{
+	/* previous chunk size. used to find previous chunk in chain */
+	uint32_t	prev_size:31;
+	bool		allocated:1;
+	uint32_t	csize;
+	uint32_t	guard_offset;
+	uint16_t	xorsum;
+
+#if !MM_CFG_COMPACT_HEADER
+	void *		allocator;
+#endif
+} mm_chunk_t;
+#else
+typedef uint16_t	mm_csize_t;
+
 typedef struct
 {
 	/* previous chunk size. used to find previous chunk in chain */
@@ -36,50 +79,217 @@ typedef struct
 	uint16_t	csize:15;
 	uint32_t	guard_offset:17;
 
+#if !MM_CFG_COMPACT_HEADER
 	void *		allocator;
+#endif
 } mm_chunk_t;
+#endif
 
 typedef struct
 {
 	uint32_t	size;
-	uint16_t	csize;
+	mm_csize_t	csize;
 	bool		allocated;
 	void *		allocator;
 } mm_cinfo_t;
 
-typedef mm_chunk_t *	(*mm_find_first_free_f)		(uint16_t wanted_csize);
+typedef struct
+{
+	mm_chunk_t	*first;
+	mm_chunk_t	*last;
+} mm_region_t;
+
+typedef struct
+{
+	/* first chunk of the first region, free list links count from there */
+	mm_chunk_t	*first;
+	/* last chunk of the last region */
+	mm_chunk_t	*last;
+	uint32_t	count;
+
+	/* regions in the order they were added, the first one included */
+	mm_region_t	regions[MM_CFG_REGION_COUNT];
+	uint32_t	region_count;
+} mm_boundary_t;
+
+/* Two-level segregated fit index of free chunks. */
+typedef struct
+{
+	uint32_t	fl_bitmap;
+	uint32_t	sl_bitmap[MM_FL_COUNT];
+	mm_chunk_t	*heads[MM_FL_COUNT][MM_SL_COUNT];
+} mm_free_index_t;
+
+/* Call site of an allocated chunk, out of its compact header. */
+typedef struct
+{
+	/* offset from the first chunk in MM_CFG_ALIGNMENT units, plus one */
+	uint32_t	key;
+	void *		site;
+} mm_callsite_t;
+
+/* Open addressing hash of the chunks that have a call site. */
+typedef struct
+{
+	mm_callsite_t	*slots;
+	uint32_t	mask;
+	uint32_t	count;
+	/* call sites not recorded because the table was full */
+	uint32_t	dropped;
+} mm_callsite_table_t;
+
+/* Free space figures, in MM_CFG_ALIGNMENT units, kept up to date by every
+ * free list insertion and removal. */
+typedef struct
+{
+	uint32_t	total_csize;
+	uint32_t	free_csize;
+	uint32_t	free_count;
+	uint32_t	largest_csize;
+	uint32_t	peak_used_csize;
+} mm_chunk_stats_t;
+
+/* Everything the chunk functions know about one heap. */
+typedef struct
+{
+	mm_boundary_t	boundary;
+	mm_free_index_t	index;
+	mm_chunk_stats_t stats;
+	/* next chunk the scrubber visits, moved back when merged away */
+	mm_chunk_t	*cursor;
+#if MM_CFG_COMPACT_HEADER
+	/* no slots: call sites are not tracked */
+	mm_callsite_table_t callsites;
+#endif
+} mm_chunk_ctx_t;
+
+typedef mm_chunk_t *	(*mm_find_first_free_f)		(mm_csize_t wanted_csize);
 typedef void		(*mm_chunk_merge_f)		(mm_chunk_t *this);
 typedef mm_chunk_t *	(*mm_chunk_split_f)		(mm_chunk_t *this,
-						 	 uint16_t csize);
-typedef bool		(*mm_validate_csize_f)		(uint16_t min_csize,
+						 	 mm_csize_t csize);
+typedef bool		(*mm_validate_csize_f)		(mm_csize_t min_csize,
 							 uint32_t wanted_csize);
 
 /* Functions prototypes ------------------------------------------------------*/
+/**
+ * Select the heap the chunk functions work on, for the calling thread only.
+ * @param	ctx	NULL selects the default heap.
+ */
+void			mm_chunk_ctx_set	(mm_chunk_ctx_t *ctx);
+mm_chunk_ctx_t *	mm_chunk_ctx_get	(void);
+mm_chunk_ctx_t *	mm_chunk_ctx_default	(void);
 void			mm_chunk_boundary_set	(mm_chunk_t *first,
 						 mm_chunk_t *last,
 						 uint32_t count);
+/**
+ * Take over the chunks a previous mm_chunk_boundary_set left in a buffer,
+ * possibly mapped elsewhere since.
+ * @param	heap_csize	Buffer size in MM_CFG_ALIGNMENT units.
+ * @param	origin		Address of first when the chunks were laid out.
+ * @return	false, leaving everything as is, if a header does not check out.
+ */
+bool			mm_chunk_attach		(mm_chunk_t *first,
+						 uint32_t heap_csize,
+						 const void *origin);
 void			mm_chunk_init		(mm_chunk_t *this,
 						 mm_chunk_t *prev,
-						 uint16_t csize);
+						 mm_csize_t csize);
 mm_chunk_t *		mm_compute_next		(mm_chunk_t *this,
-						 uint16_t csize);
+						 mm_csize_t csize);
 mm_chunk_t *		mm_chunk_prev_get	(mm_chunk_t *this);
+/**
+ * Chunk right after this one in memory, NULL at the end of a region.
+ */
 mm_chunk_t *		mm_chunk_next_get	(mm_chunk_t *this);
+/**
+ * Same as mm_chunk_next_get but goes on with the first chunk of the next
+ * region, to walk the whole heap. The chunk returned is not validated.
+ */
+mm_chunk_t *		mm_chunk_walk_next	(mm_chunk_t *this);
+/**
+ * Lay out free chunks in buffer and add them to the current heap.
+ * buffer must lie above the first chunk, within 2^31 MM_CFG_ALIGNMENT units
+ * of it, and must not overlap another region.
+ * @param	csize	Buffer size in MM_CFG_ALIGNMENT units.
+ * @param	zeroed	buffer reads zero, its chunks are known to be zero.
+ * @return	false if the buffer is unsuitable or no region is left.
+ */
+bool			mm_chunk_region_add	(void *buffer,
+						 uint32_t csize,
+						 bool zeroed);
 
 uint32_t		mm_guard_size		(mm_chunk_t *this);
 bool			mm_chunk_guard_get	(mm_chunk_t *this);
 void			mm_chunk_guard_set	(mm_chunk_t *this,
 						 uint32_t offset);
+/**
+ * Header checksum: a 16 bits xor of the fields, or a CRC32C of them folded
+ * to 16 bits with MM_CFG_CRC32C.
+ */
 uint16_t		mm_chunk_xorsum		(mm_chunk_t *this);
+/**
+ * Call site of a chunk, kept in the header or, with MM_CFG_COMPACT_HEADER,
+ * in the call site table of the current heap. The header checksum is not
+ * updated.
+ */
+void *			mm_chunk_allocator_get	(mm_chunk_t *this);
+void			mm_chunk_allocator_set	(mm_chunk_t *this,
+						 void *allocator);
+/**
+ * CRC32C (Castagnoli) of a buffer, with SSE4.2 when the CPU has it.
+ */
+uint32_t		mm_crc32c		(const void *data,
+						 uint32_t len);
 void			mm_chunk_validate	(mm_chunk_t *this);
+void			mm_chunk_allocated_set	(mm_chunk_t *this,
+						 bool allocated);
+/**
+ * Known zero free chunks: their payload reads zero but for the guard pad
+ * and the free list link. Splits keep the mark, merges keep it when both
+ * chunks have it, frees drop it.
+ */
+bool			mm_chunk_zeroed_get	(mm_chunk_t *this);
+/**
+ * Clear the payload of a free chunk and mark it known zero.
+ */
+void			mm_chunk_zero		(mm_chunk_t *this);
+/**
+ * Clear the first size bytes of a chunk just allocated, before its guard is
+ * set.
+ * @param	zeroed	mm_chunk_zeroed_get() of the chunk while it was free,
+ *			only the guard pad and link bytes are cleared then.
+ */
+void			mm_chunk_clear		(mm_chunk_t *this,
+						 uint32_t size,
+						 bool zeroed);
+/**
+ * Raise the high-water mark of the current heap to what is in use now. Done
+ * once an allocation settled: the splits and merges on the way would
+ * overshoot it.
+ */
+void			mm_chunk_stats_peak	(void);
 bool			mm_chunk_is_available	(mm_chunk_t *this);
-uint16_t		mm_chunk_available_csize(mm_chunk_t *this);
+mm_csize_t		mm_chunk_available_csize(mm_chunk_t *this);
 
 MOCKABLE mm_chunk_merge_f mm_chunk_merge;
 MOCKABLE mm_chunk_split_f mm_chunk_split;
+/**
+ * Free the chunks of ptrs that follow each other in memory, starting with
+ * ptrs[0], as a single chunk merged with its free neighbours.
+ * @param	ptrs	Payloads sorted by address.
+ * @return	Number of entries of ptrs consumed, at least 1.
+ */
+uint32_t		mm_chunk_free_run	(void **ptrs,
+						 uint32_t n);
 
 void *			mm_toptr		(mm_chunk_t *this);
 mm_chunk_t *		mm_tochunk		(void *ptr);
+/**
+ * Header of a block its owner hands back without the heap lock. Only the
+ * alignment and the allocated flag are checked, the header is validated in
+ * full once the block is freed under the lock.
+ */
+mm_chunk_t *		mm_chunk_owned		(void *ptr);
 
 MOCKABLE mm_find_first_free_f mm_find_first_free;
 uint32_t		mm_chunk_count		(void);
@@ -87,8 +297,8 @@ void			mm_chunk_info		(mm_cinfo_t *infos,
 						 uint32_t size);
 
 uint32_t 		mm_to_csize		(uint32_t size);
-uint16_t		mm_min_csize		(void);
-uint16_t		mm_header_csize		(void);
+mm_csize_t		mm_min_csize		(void);
+mm_csize_t		mm_header_csize		(void);
 MOCKABLE mm_validate_csize_f mm_validate_csize;
 
 #endif
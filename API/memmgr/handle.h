@@ -0,0 +1,56 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_HANDLE_H__
+#define __MEMMGR_HANDLE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "os/memmgr.h"
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct mm_handle mm_handle_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Allocate a movable block. Its address is only known, and stable, between
+ * mm_hlock() and mm_hunlock(); mm_compact() may move it at any other time.
+ * @param	heap	NULL selects the default heap.
+ * @return	NULL if no handle or no memory is available.
+ */
+mm_handle_t *		mm_halloc		(uint32_t size);
+mm_handle_t *		mm_heap_halloc		(mm_heap_t *heap,
+						 uint32_t size);
+/**
+ * Pin the block of a handle. Locks nest.
+ * @return	Current address of the block.
+ */
+void *			mm_hlock		(mm_handle_t *this);
+void			mm_hunlock		(mm_handle_t *this);
+/**
+ * Free the block of a handle, locked or not, and the handle itself.
+ */
+void			mm_hfree		(mm_handle_t *this);
+/**
+ * Slide the unlocked handle blocks of a heap towards its start so that free
+ * chunks coalesce. Locked blocks and plain allocations stay where they are.
+ * @param	heap	NULL selects the default heap.
+ * @return	Size of the largest block mm_alloc can now return.
+ */
+uint32_t		mm_compact		(mm_heap_t *heap);
+
+#endif
@@ -0,0 +1,103 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_HEAP_H__
+#define __MEMMGR_HEAP_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#include "os/memmgr.h"
+#include "os/mutex.h"
+#include "os/task.h"
+#include "memmgr/chunk.h"
+#include "memmgr/latency.h"
+#include "memmgr/remote.h"
+
+/* Types ---------------------------------------------------------------------*/
+struct mm_heap
+{
+	uint8_t		*heap;
+	mutex_t		*mtx;
+	mm_chunk_ctx_t	*ctx;
+
+	/* chunk context to restore when the outermost lock is released */
+	mm_chunk_ctx_t	*saved;
+	uint32_t	depth;
+
+	/* frees from other tasks, or while the lock is taken, wait here */
+	task_t		*owner;
+	mm_remote_t	remote;
+
+	/* task whose nested mm_alloc/mm_free must not be traced */
+	task_t		*untraced;
+
+	/* set by a zeroing allocation while it holds the lock, the next chunk
+	 * taken from the heap is cleared and its payload left in zeroed */
+	bool		zero;
+	void		*zeroed;
+
+#if MM_CFG_LATENCY
+	mm_latency_t	latency;
+#endif
+};
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Serialise accesses to a heap and point the chunk functions at it for the
+ * calling thread. The lock is recursive.
+ */
+void			mm_heap_lock		(mm_heap_t *this);
+void			mm_heap_unlock		(mm_heap_t *this);
+/**
+ * Same as mm_heap_lock but gives up at once if another task holds the lock.
+ * @return	true if the lock was taken.
+ */
+bool			mm_heap_trylock		(mm_heap_t *this);
+/**
+ * Queue an allocated block on the remote free list of its heap, lock-free.
+ * Only a block already freed is caught here, see mm_chunk_owned(); the rest
+ * of its header is validated by mm_heap_remote_drain.
+ * @return	false if the block is too small to hold the link.
+ */
+bool			mm_heap_remote_push	(mm_heap_t *this,
+						 void *ptr);
+/**
+ * Validate and free every block queued on the remote free list. The lock
+ * must be held.
+ */
+void			mm_heap_remote_drain	(mm_heap_t *this);
+/**
+ * Allocate straight from a heap, bypassing any cache.
+ * @param	lr	Call site recorded on the chunk.
+ */
+void *			mm_heap_alloc_uncached	(mm_heap_t *this,
+						 uint32_t size,
+						 void *lr);
+/**
+ * Free straight to a heap, bypassing any cache.
+ */
+void			mm_heap_free_uncached	(mm_heap_t *this,
+						 void *ptr);
+
+/* Same as above, on the default heap */
+void			mm_lock			(void);
+void			mm_unlock		(void);
+void *			mm_alloc_uncached	(uint32_t size,
+						 void *lr);
+void			mm_free_uncached	(void *ptr);
+
+#endif
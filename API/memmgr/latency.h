@@ -0,0 +1,115 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+#ifndef __MEMMGR_LATENCY_H__
+#define __MEMMGR_LATENCY_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "memmgr_conf.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+/* each power of two of nanoseconds is split in 1 << MM_LATENCY_SUB_BITS */
+#define MM_LATENCY_SUB_BITS	(2)
+#define MM_LATENCY_SUBS		(1 << MM_LATENCY_SUB_BITS)
+
+#if MM_CFG_LATENCY
+#define MM_LATENCY_START(start)			\
+	uint32_t start = mm_latency_start()
+#define MM_LATENCY_END(latency, kind, start)	\
+	mm_latency_end((latency), (kind), (start))
+#else
+#define MM_LATENCY_START(start)
+#define MM_LATENCY_END(latency, kind, start)
+#endif
+
+/* Types ---------------------------------------------------------------------*/
+/* mm_heap_t, os/memmgr.h includes this header through os/task.h */
+struct mm_heap;
+
+typedef enum
+{
+	MM_LATENCY_ALLOC,
+	MM_LATENCY_REALLOC,
+	MM_LATENCY_FREE,
+	/* time spent taking the heap lock, whatever the operation */
+	MM_LATENCY_WAIT,
+	MM_LATENCY_KINDS
+} mm_latency_kind_t;
+
+typedef struct
+{
+	uint32_t	count;
+	uint32_t	max_ns;
+	/* see mm_latency_bucket(), the last one takes everything above */
+	uint32_t	buckets[MM_CFG_LATENCY_BUCKETS];
+} mm_latency_hist_t;
+
+typedef struct
+{
+	mm_latency_hist_t	hist[MM_LATENCY_KINDS];
+} mm_latency_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Empty every histogram.
+ */
+void			mm_latency_init		(mm_latency_t *this);
+/**
+ * Bucket of a duration in ns: one per nanosecond below MM_LATENCY_SUBS,
+ * then MM_LATENCY_SUBS per power of two.
+ */
+uint32_t		mm_latency_bucket	(uint32_t ns);
+/**
+ * Shortest duration falling in a bucket.
+ */
+uint32_t		mm_latency_bucket_floor	(uint32_t bucket);
+/**
+ * Count a duration, lock-free so the histograms can be read at any time.
+ */
+void			mm_latency_record	(mm_latency_t *this,
+						 mm_latency_kind_t kind,
+						 uint32_t ns);
+uint32_t		mm_latency_start	(void);
+/**
+ * Count the time elapsed since start in this and in the calling task.
+ * Durations are taken from system_time_ns(), above ~4 seconds they wrap.
+ */
+void			mm_latency_end		(mm_latency_t *this,
+						 mm_latency_kind_t kind,
+						 uint32_t start);
+/**
+ * Copy a histogram while operations go on, the copy may miss the ones
+ * recorded meanwhile.
+ * @param	reset	Empty the histogram, an operation is never lost
+ *			between two reads.
+ * @return	Number of operations copied.
+ */
+uint32_t		mm_latency_read		(mm_latency_t *this,
+						 mm_latency_kind_t kind,
+						 mm_latency_hist_t *out,
+						 bool reset);
+/**
+ * Histograms of the operations on a heap, mm_alloc family included for the
+ * default one. A moving realloc only counts as a realloc, zalloc and calloc
+ * count as the mm_alloc they make.
+ */
+mm_latency_t *		mm_heap_latency_get	(struct mm_heap *this);
+
+#endif
@@ -0,0 +1,115 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+#ifndef __MEMMGR_LEAK_H__
+#define __MEMMGR_LEAK_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "os/task.h"
+#include "memmgr_conf.h"
+
+/* Types ---------------------------------------------------------------------*/
+/* blocks of one task still allocated from the same call site with one size */
+typedef struct
+{
+	void *		site;
+	uint32_t	size;
+	uint32_t	count;
+} mm_leak_t;
+
+/**
+ * Sink of mm_leak_dump(), one line of text per call.
+ * @return	false to abort the dump.
+ */
+typedef bool		(*mm_leak_write_f)	(void *arg,
+						 const char *line,
+						 uint32_t len);
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Forget every block. mm_init and mm_attach do it.
+ */
+void			mm_leak_reset		(void);
+/**
+ * Tag a block of the mm_alloc family with the calling task, NULL outside of
+ * a task. Tagging an address again replaces its previous tag.
+ * @param	site	Call site reported for the block.
+ */
+void			mm_leak_alloc		(void *ptr,
+						 uint32_t size,
+						 void *site);
+/**
+ * Untag a block, blocks the table never saw are ignored.
+ * @param	tag	Gets the call site and size of the block, may be NULL.
+ * @return	false if the block was not tagged.
+ */
+bool			mm_leak_free		(void *ptr,
+						 mm_leak_t *tag);
+/**
+ * Change the call site reported for a block.
+ */
+void			mm_leak_site_set	(void *ptr,
+						 void *site);
+/**
+ * Make the calling task the owner of a block another task handed over.
+ * Otherwise it is reported as a leak of the task that allocated it.
+ */
+void			mm_leak_adopt		(void *ptr);
+/**
+ * Blocks not tagged because the table was full, it holds
+ * MM_CFG_LEAK_BLOCKS - 1 of them.
+ */
+uint32_t		mm_leak_dropped		(void);
+/**
+ * Count the blocks a task did not free.
+ * @param	bytes	Their requested size summed, may be NULL.
+ */
+uint32_t		mm_leak_count		(task_t *task,
+						 uint32_t *bytes);
+/**
+ * Group the blocks a task did not free by call site and size, most bytes
+ * first. Groups found once out is full are left out.
+ * @return	Number of groups copied.
+ */
+uint32_t		mm_leak_report		(task_t *task,
+						 mm_leak_t *out,
+						 uint32_t n);
+/**
+ * Write a summary line followed by the biggest groups of mm_leak_report(),
+ * a line each with its call site symbol when the system knows it.
+ * @return	Number of lines written.
+ */
+uint32_t		mm_leak_dump		(task_t *task,
+						 mm_leak_write_f write,
+						 void *arg);
+/**
+ * Sink of the reports written when a task ends with blocks left, NULL to
+ * stop writing them.
+ */
+void			mm_leak_hook_set	(mm_leak_write_f write,
+						 void *arg);
+/**
+ * Called by the task layer once a task returned and drained its cache:
+ * report its blocks through the hook then forget them, a later task may
+ * get the same address.
+ */
+void			mm_leak_task_exit	(task_t *task);
+
+#endif
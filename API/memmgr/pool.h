@@ -0,0 +1,101 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_POOL_H__
+#define __MEMMGR_POOL_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "memmgr_conf.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+#define MM_POOL_BLOCK_SIZE(size) \
+		(((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define	mm_pool_declare(var_name, size, n) \
+		mm_pool_t var_name = { .block_size = MM_POOL_BLOCK_SIZE(size), .count = (n) }
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct
+{
+	uint32_t	used;
+	uint32_t	peak;
+	uint32_t	allocs;
+	uint32_t	frees;
+	uint32_t	overflows;
+} mm_pool_stats_t;
+
+typedef struct mm_pool mm_pool_t;
+struct mm_pool
+{
+	uint32_t	block_size;
+	uint32_t	count;
+
+	uint8_t		*blocks;
+	void		*free;
+	uint32_t	carved;
+	uint32_t	used;
+	mm_pool_t	*next;
+#if MM_CFG_POOL_STATS
+	mm_pool_stats_t	stats;
+#endif
+};
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Prepare a pool of count blocks of block_size bytes.
+ * Blocks are carved from a single heap chunk on first allocation. The chunk
+ * stays with the pool until mm_pool_deinit, or until the default heap runs
+ * out of room while no block of the pool is in use.
+ */
+void			mm_pool_init		(mm_pool_t *this,
+						 uint32_t block_size,
+						 uint32_t count);
+/**
+ * Get a block. Falls back to the heap when every block is in use.
+ * @return	NULL if no memory is available.
+ */
+void *			mm_pool_alloc		(mm_pool_t *this);
+void *			mm_pool_zalloc		(mm_pool_t *this);
+/**
+ * Give a block obtained from mm_pool_alloc back.
+ */
+void			mm_pool_free		(mm_pool_t *this,
+						 void *ptr);
+bool			mm_pool_owns		(mm_pool_t *this,
+						 void *ptr);
+/**
+ * Give the chunk of a pool back to the heap, blocks still in use included.
+ * The pool may be used again, it is carved anew.
+ */
+void			mm_pool_deinit		(mm_pool_t *this);
+#if MM_CFG_POOL_STATS
+void			mm_pool_stats_get	(mm_pool_t *this,
+						 mm_pool_stats_t *stats);
+#endif
+/**
+ * Drop every carved pool, their chunks belong to a heap that is being
+ * re-initialised.
+ */
+void			mm_pool_forget_all	(void);
+/**
+ * Give the chunk of every carved pool back to the heap, blocks still in use
+ * included. Nothing may use those blocks afterwards.
+ */
+void			mm_pool_release_all	(void);
+
+#endif
@@ -0,0 +1,87 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_PROFILE_H__
+#define __MEMMGR_PROFILE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "memmgr_conf.h"
+
+/* Types ---------------------------------------------------------------------*/
+typedef enum
+{
+	MM_PROFILE_BY_LIVE,
+	MM_PROFILE_BY_ALLOCS,
+	MM_PROFILE_BY_PEAK
+} mm_profile_order_t;
+
+typedef struct
+{
+	void *		site;
+	/* requested bytes and blocks not freed yet */
+	uint32_t	live_bytes;
+	uint32_t	live_count;
+	uint32_t	allocs;
+	uint32_t	peak_bytes;
+} mm_profile_site_t;
+
+/**
+ * Sink of mm_profile_dump(), one line of text per call.
+ * @return	false to abort the dump.
+ */
+typedef bool		(*mm_profile_write_f)	(void *arg,
+						 const char *line,
+						 uint32_t len);
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Forget every call site. mm_init and mm_attach do it. Freeing a block the
+ * profile did not see allocated is ignored, unless its call site has blocks
+ * allocated since.
+ */
+void			mm_profile_reset	(void);
+/**
+ * Account a block of the mm_alloc family to the call site its chunk
+ * records. Blocks out of the task cache count with the payload size of their
+ * class. The heap lock must be held.
+ */
+void			mm_profile_alloc	(void *site,
+						 uint32_t size);
+void			mm_profile_free		(void *site,
+						 uint32_t size);
+/**
+ * Copy the n call sites coming first in order, biggest first.
+ * @return	Number of sites copied.
+ */
+uint32_t		mm_profile_top		(mm_profile_site_t *out,
+						 uint32_t n,
+						 mm_profile_order_t order);
+/**
+ * Call sites not accounted because the table was full.
+ */
+uint32_t		mm_profile_dropped	(void);
+/**
+ * Write one line per call site, its symbol when the system knows it,
+ * followed by its live bytes, live count, allocations and peak.
+ * @return	Number of lines written.
+ */
+uint32_t		mm_profile_dump		(mm_profile_write_f write,
+						 void *arg);
+
+#endif
@@ -0,0 +1,102 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+#ifndef __MEMMGR_RECLAIM_H__
+#define __MEMMGR_RECLAIM_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "memmgr/chunk.h"
+#include "memmgr_conf.h"
+
+/* Types ---------------------------------------------------------------------*/
+/**
+ * Give memory back to the default heap when it has no room left.
+ * Shrinkers run with the heap lock held: they may free but must neither
+ * allocate nor wait on a lock whose holder may be allocating, a trylock that
+ * gives up is fine.
+ * @param	size	Bytes the failing allocation needs.
+ * @return	Bytes given back, an estimate, 0 if there was nothing to give.
+ */
+typedef uint32_t	(*mm_shrink_f)		(void *arg,
+						 uint32_t size);
+
+/* Registration of a shrinker, owned by its subsystem */
+typedef struct mm_shrinker
+{
+	mm_shrink_f		shrink;
+	void *			arg;
+	/* lowest first: the caches that are the cheapest to rebuild */
+	uint32_t		priority;
+	struct mm_shrinker *	next;
+} mm_shrinker_t;
+
+typedef struct
+{
+	/* allocations that found no room in the heap */
+	uint32_t	runs;
+	/* runs that found room in the end */
+	uint32_t	rescued;
+	/* runs of critical callers that spent the reserve */
+	uint32_t	reserve_used;
+} mm_reclaim_stats_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Have shrink called before an allocation of the default heap fails. Among
+ * shrinkers of the same priority, the first registered runs first.
+ * @param	this	Must stay valid until unregistered.
+ */
+void			mm_shrinker_register	(mm_shrinker_t *this,
+						 mm_shrink_f shrink,
+						 void *arg,
+						 uint32_t priority);
+void			mm_shrinker_unregister	(mm_shrinker_t *this);
+/**
+ * Keep size bytes of the default heap aside for mm_alloc_critical, once the
+ * shrinkers gave up. A spent reserve is taken again by the first free that
+ * leaves room for it. mm_init reserves MM_CFG_RECLAIM_RESERVE bytes and
+ * mm_detach gives them back. mm_attach cannot tell a reserve a crash left
+ * from a block, it takes none.
+ * The reserve counts as used in mm_stats_get.
+ * @param	size	0 gives the reserve back to the heap.
+ * @return	false if there is no room for it yet.
+ */
+bool			mm_reserve_set		(uint32_t size);
+/**
+ * Bytes the reserve holds, 0 once spent.
+ */
+uint32_t		mm_reserve_get		(void);
+/**
+ * mm_alloc that may spend the reserve.
+ */
+void *			mm_alloc_critical	(uint32_t size);
+void			mm_reclaim_stats_get	(mm_reclaim_stats_t *stats);
+
+/**
+ * Bookkeeping of the default heap. mm_reclaim_run is called with the heap
+ * lock held when no free chunk of csize is left, after the heap tried to
+ * grow, and returns one if the shrinkers or the reserve made room.
+ * mm_reclaim_rearm is called after frees.
+ */
+void			mm_reclaim_reset	(void);
+mm_chunk_t *		mm_reclaim_run		(uint32_t csize);
+void			mm_reclaim_rearm	(void);
+
+#endif
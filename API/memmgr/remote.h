@@ -0,0 +1,53 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_REMOTE_H__
+#define __MEMMGR_REMOTE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct _mm_remote_node_t	mm_remote_node_t;
+
+/* lives in the first word of the payload of a block waiting to be freed */
+struct _mm_remote_node_t
+{
+	mm_remote_node_t	*next;
+};
+
+/* Lock-free multiple producers, single consumer stack of blocks. */
+typedef struct
+{
+	mm_remote_node_t	*head;
+} mm_remote_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+void			mm_remote_init		(mm_remote_t *this);
+/**
+ * Push a chain of nodes already linked from first to last. Safe from any
+ * task, without any lock.
+ */
+void			mm_remote_push		(mm_remote_t *this,
+						 mm_remote_node_t *first,
+						 mm_remote_node_t *last);
+/**
+ * Detach every pushed node at once.
+ * @return	Chain of nodes, most recently pushed first, or NULL.
+ */
+mm_remote_node_t *	mm_remote_take		(mm_remote_t *this);
+
+#endif
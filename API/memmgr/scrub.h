@@ -0,0 +1,69 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_SCRUB_H__
+#define __MEMMGR_SCRUB_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "os/memmgr.h"
+#include "os/task.h"
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct
+{
+	mm_heap_t	*heap;
+	uint32_t	chunks;
+	uint32_t	period_ms;
+	task_t		*task;
+	/* clear the free chunks walked, zeroing allocations then skip them */
+	bool		zero_free;
+
+	uint32_t	steps;
+	uint32_t	passes;
+} mm_scrub_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Prepare a scrubber for a heap.
+ * @param	heap	NULL selects the default heap.
+ * @param	chunks	Chunks validated per step, the heap stays locked for
+ *			that long only.
+ */
+void			mm_scrub_init		(mm_scrub_t *this,
+						 mm_heap_t *heap,
+						 uint32_t chunks);
+/**
+ * Validate the next chunks of the heap, resuming where the previous step
+ * stopped, and clear its free chunks when zero_free is set. Corruption leads
+ * to death.
+ * @return	true when this step completed a pass over the whole heap.
+ */
+bool			mm_scrub_step		(mm_scrub_t *this);
+/**
+ * Run mm_scrub_step() every period_ms from a task of its own.
+ * @param	period_ms	At least 1, the task sleeps that long between steps.
+ * @return	false if period_ms is 0 or the task could not be created or
+ *		started.
+ */
+bool			mm_scrub_start		(mm_scrub_t *this,
+						 uint32_t period_ms,
+						 uint32_t priority);
+void			mm_scrub_stop		(mm_scrub_t *this);
+
+#endif
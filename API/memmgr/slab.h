@@ -0,0 +1,75 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_SLAB_H__
+#define __MEMMGR_SLAB_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "memmgr_conf.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+/* slots per slab, one bit each in its occupancy map */
+#define MM_SLAB_SLOTS		(32)
+/* one class per MM_CFG_ALIGNMENT step up to MM_CFG_SLAB_MAX_PAYLOAD */
+#define MM_SLAB_CLASSES		(MM_CFG_SLAB_MAX_PAYLOAD / MM_CFG_ALIGNMENT)
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct mm_slab mm_slab_t;
+struct mm_slab
+{
+	/* next slab of the same class with a free slot */
+	mm_slab_t	*next;
+	uint32_t	magic;
+	uint32_t	slot_size;
+	/* bit n set: slot n is free */
+	uint32_t	free_map;
+};
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Serve a request of MM_CFG_SLAB_MAX_PAYLOAD bytes or less from a slot of
+ * the default heap's slabs, carving a new slab from the heap when needed.
+ * @param	lr	Call site recorded on a newly carved slab.
+ * @return	NULL if the request is too big, no slab is left in the
+ *		MM_CFG_SLAB_COUNT registry or the heap is exhausted.
+ */
+void *			mm_slab_alloc		(uint32_t size,
+						 void *lr);
+/**
+ * Give a slot back. A slab left empty goes back to the heap unless it is the
+ * last one of its class with a free slot.
+ * @return	false if ptr is not a slot, it must go back to the heap.
+ */
+bool			mm_slab_free		(void *ptr);
+/**
+ * @return	Size of the slot ptr is, 0 if it is not a slot.
+ */
+uint32_t		mm_slab_size		(void *ptr);
+/**
+ * Drop every slab, their chunks belong to a heap that is being
+ * re-initialised.
+ */
+void			mm_slab_forget_all	(void);
+/**
+ * Find the slabs of a heap mm_attach took over again. The heap lock must be
+ * held.
+ */
+void			mm_slab_adopt_all	(void);
+
+#endif
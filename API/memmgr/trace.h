@@ -0,0 +1,106 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_TRACE_H__
+#define __MEMMGR_TRACE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "memmgr_conf.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+#define MM_TRACE_MAGIC		(0x52544d4d)	/* "MMTR" */
+#define MM_TRACE_VERSION	(2)
+
+#define MM_TRACE_ALLOC		(1)
+#define MM_TRACE_REALLOC	(2)
+#define MM_TRACE_FREE		(3)
+
+/* fields packed in mm_trace_record_t.time_op */
+#define MM_TRACE_OP(rec)	((rec)->time_op >> 30)
+#define MM_TRACE_TIME_US(rec)	((rec)->time_op & 0x3FFFFFFF)
+
+#if MM_CFG_TRACE
+#define MM_TRACE(op, ptr, old_ptr, size, lr)	\
+	mm_trace_record((op), (ptr), (old_ptr), (size), (lr))
+#else
+#define MM_TRACE(op, ptr, old_ptr, size, lr)
+#endif
+
+/* Types ---------------------------------------------------------------------*/
+/* A flushed trace is this header followed by count records, oldest first.
+ * Fields have the same width on every target. */
+typedef struct
+{
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	record_size;
+	uint32_t	count;
+	/* records overwritten before they could be flushed */
+	uint32_t	dropped;
+	/* address block offsets count from */
+	uint64_t	heap;
+} mm_trace_header_t;
+
+typedef struct
+{
+	uint64_t	caller;
+	uint64_t	task;
+	/* microseconds in the 30 low bits, wrapping, the op in the 2 top ones */
+	uint32_t	time_op;
+	/* requested size, 0 for frees */
+	uint32_t	size;
+	/* MM_CFG_ALIGNMENT units past heap, 0 for NULL */
+	uint32_t	ptr;
+	/* block given to mm_realloc */
+	uint32_t	old_ptr;
+} mm_trace_record_t;
+
+/**
+ * Sink of mm_trace_flush().
+ * @return	false to abort the flush.
+ */
+typedef bool		(*mm_trace_write_f)	(void *arg,
+						 const void *data,
+						 uint32_t len);
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Start or stop recording the default heap operations. Stopped at boot.
+ */
+void			mm_trace_start		(void);
+void			mm_trace_stop		(void);
+/**
+ * Append a record to the ring, overwriting the oldest one once full.
+ * Frees of NULL are not recorded.
+ */
+void			mm_trace_record		(uint8_t op,
+						 void *ptr,
+						 void *old_ptr,
+						 uint32_t size,
+						 void *caller);
+/**
+ * Write the header and every record to write() then empty the ring.
+ * Records added during the flush may be lost, stop the trace first for a
+ * consistent dump.
+ * @return	Number of records written.
+ */
+uint32_t		mm_trace_flush		(mm_trace_write_f write,
+						 void *arg);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+#ifndef __MEMMGR_ZONE_H__
+#define __MEMMGR_ZONE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "memmgr_conf.h"
+
+/* Types ---------------------------------------------------------------------*/
+/* Budget of one subsystem on the default heap. Sizes are the requested ones,
+ * a quota of 0 does not limit anything. */
+typedef struct mm_zone
+{
+	const char *	name;
+	uint32_t	byte_quota;
+	uint32_t	count_quota;
+
+	uint32_t	bytes;
+	uint32_t	count;
+	uint32_t	peak_bytes;
+	uint32_t	peak_count;
+	/* allocations refused for going over a quota */
+	uint32_t	failures;
+} mm_zone_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+/**
+ * Prepare an empty zone. It must outlive the blocks allocated in it.
+ */
+void			mm_zone_init		(mm_zone_t *this,
+						 const char *name,
+						 uint32_t byte_quota,
+						 uint32_t count_quota);
+/**
+ * Change the quotas, blocks already allocated are kept even above them.
+ */
+void			mm_zone_quota_set	(mm_zone_t *this,
+						 uint32_t byte_quota,
+						 uint32_t count_quota);
+/**
+ * Copy the usage of a zone, consistent with itself.
+ */
+void			mm_zone_stats_get	(mm_zone_t *this,
+						 mm_zone_t *stats);
+/**
+ * Make a zone the default one of the calling task, NULL for none. Outside of
+ * tasks, one default is shared.
+ * @return	The previous default zone.
+ */
+mm_zone_t *		mm_zone_enter		(mm_zone_t *zone);
+mm_zone_t *		mm_zone_current		(void);
+/**
+ * mm_alloc in a given zone, whatever the default one.
+ */
+void *			mm_zone_alloc		(mm_zone_t *zone,
+						 uint32_t size);
+/**
+ * Zone a block of the mm_alloc family was charged to, NULL if none.
+ */
+mm_zone_t *		mm_zone_of		(void *ptr);
+
+/**
+ * Bookkeeping of the mm_alloc family. A block is charged to its zone before
+ * it is allocated, fast failing when a quota or the table of
+ * MM_CFG_ZONE_BLOCKS is full. It is tagged once allocated, and untagged
+ * before it is freed or moved so that its address can be tagged again.
+ */
+void			mm_zone_reset		(void);
+bool			mm_zone_charge		(mm_zone_t *zone,
+						 uint32_t bytes,
+						 uint32_t count);
+void			mm_zone_cancel		(mm_zone_t *zone,
+						 uint32_t bytes,
+						 uint32_t count);
+void			mm_zone_tag		(mm_zone_t *zone,
+						 void *ptr,
+						 uint32_t size);
+mm_zone_t *		mm_zone_untag		(void *ptr,
+						 uint32_t *size);
+/* untag and cancel the charge of a block about to be freed */
+void			mm_zone_release		(void *ptr);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __OS_HEAP_FILE_H__
+#define __OS_HEAP_FILE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Public prototypes ---------------------------------------------------------*/
+/**
+ * Map a file as the heap of the memory manager, in place of the one mm_init
+ * set up. A heap a previous run left in the file is attached to as is, once
+ * its headers checked out; otherwise the file is (re)formatted.
+ * Only the blocks reachable from the root survive a restart: handles, pools
+ * and call sites do not.
+ * @param	size	Heap size in byte, a different size formats the file.
+ * @return	false if the file cannot be mapped.
+ */
+bool		heap_file_open		(const char *path,
+					 uint32_t size);
+/**
+ * @return	true if heap_file_open kept the heap of a previous run.
+ */
+bool		heap_file_reopened	(void);
+/**
+ * Block to find again after a restart, NULL if none. It is kept as an offset
+ * in the heap, the file may be mapped elsewhere next time.
+ */
+void		heap_file_root_set	(void *ptr);
+void *		heap_file_root_get	(void);
+/**
+ * Write the heap back to the file.
+ * @return	false on I/O error.
+ */
+bool		heap_file_sync		(void);
+/**
+ * Detach the memory manager from the heap, sync and unmap it. The memory
+ * manager must not be used again before mm_init or heap_file_open.
+ */
+void		heap_file_close		(void);
+
+#endif
@@ -22,6 +22,8 @@
 #include <stdbool.h>
 
 #include "common/mockable.h"
+#include "os/task.h"
+#include "memmgr_conf.h"
 
 /* macros --------------------------------------------------------------------*/
 #define mm_allocator_update(this)	mm_allocator_set(this, __builtin_return_address(0))
@@ -33,15 +35,39 @@ typedef void *		(* mm_calloc_f)			(uint32_t n,
 typedef void *		(* mm_realloc_f)		(void *old_ptr,
 							 uint32_t total_csize);
 typedef void		(* mm_free_f)			(void *ptr);
+typedef void *		(* mm_region_get_f)		(void *hint,
+							 uint32_t *size);
+typedef void		(* mm_region_put_f)		(void *region,
+							 uint32_t size);
+
+typedef struct mm_heap	mm_heap_t;
 
 typedef struct
 {
 	uint32_t size;
+#if MM_CFG_WIDE_HEADER
+	uint32_t csize;
+#else
 	uint16_t csize;
+#endif
 	bool	 allocated;
 	void	 *allocator;
 } mm_info_t;
 
+/* Sizes are in byte, chunk headers included. Blocks held by task caches,
+ * pools or slabs count as used. */
+typedef struct
+{
+	uint32_t heap_size;
+	uint32_t free_size;
+	uint32_t largest_free;
+	uint32_t free_count;
+	/* share of free_size outside the largest free chunk, in per mille */
+	uint32_t fragmentation;
+	/* most heap_size - free_size ever reached */
+	uint32_t peak_used;
+} mm_stats_t;
+
 
 /* Public functions ----------------------------------------------------------*/
 /**
@@ -52,6 +78,44 @@ typedef struct
  */
 void			mm_init				(uint8_t *heap,
 							 uint32_t size);
+/**
+ * Give the memory manager one more buffer to allocate from.
+ * @param	region	Must be aligned according to MM_CFG_ALIGNMENT, above
+ *			the mm_init heap and within 2^31 MM_CFG_ALIGNMENT units
+ *			of it. Chunks never span two regions.
+ * @return	false if the region is unsuitable or MM_CFG_REGION_COUNT is
+ *		reached.
+ */
+bool			mm_add_region			(uint8_t *region,
+							 uint32_t size);
+/**
+ * Let the memory manager grow on demand: when no free chunk fits, get is
+ * asked for a region of at least *size byte (MM_CFG_REGION_SIZE or more),
+ * close to hint, and updates *size. Regions mm_add_region refuses go back
+ * through put. NULL hooks disable growth.
+ * Regions get returns must read zero, as fresh mmap pages or .bss do: zeroing
+ * allocations served from them skip their memset.
+ */
+void			mm_region_hooks_set		(mm_region_get_f get,
+							 mm_region_put_f put);
+/**
+ * Initialise the memory manager on a heap a previous mm_init left, keeping
+ * its allocations. Every header is checked, free lists are rebuilt and call
+ * sites are forgotten.
+ * @param	origin	Address heap had when it was laid out, NULL if the same.
+ * @return	false if the heap does not check out, mm_init must be used then.
+ */
+bool			mm_attach			(uint8_t *heap,
+							 uint32_t size,
+							 const uint8_t *origin);
+/**
+ * Leave the heap so that a later mm_attach finds only the blocks the program
+ * allocated: pool chunks, the reserve of memmgr/reclaim.h and the cache of the
+ * calling task go back to it.
+ * No other task may use the memory manager any more, nor anything allocated
+ * from a pool.
+ */
+void			mm_detach			(void);
 /**
  * Check heap integrity.
  */
@@ -69,6 +133,69 @@ void			mm_allocator_set		(void *ptr,
  * @return	Table of mm_info_t.
  */
 mm_info_t *		mm_info_get			(void);
+/**
+ * Free space figures of the heap, kept up to date as chunks come and go so
+ * that reading them costs no walk.
+ */
+void			mm_stats_get			(mm_stats_t *stats);
+
+/**
+ * Allocate n buffers at once, from a single free chunk when possible.
+ * Buffers bypass the task cache.
+ * @param	sizes	Size of each buffer, 0 gives NULL.
+ * @param	out	Receives the n buffers, NULL for the ones that failed.
+ * @return	Number of buffers allocated.
+ */
+uint32_t		mm_alloc_batch			(uint32_t n,
+							 const uint32_t *sizes,
+							 void **out);
+/**
+ * Free n buffers at once, neighbours are coalesced in a single pass.
+ * @param	ptrs	Buffers to free, NULL entries are skipped. ptrs is
+ *			sorted in place.
+ */
+void			mm_free_batch			(void **ptrs,
+							 uint32_t n);
+
+/**
+ * Create an independent heap, with its own lock, in buffer.
+ * The heap descriptor is placed at the start of buffer.
+ * @param	buffer	Heap buffer.
+ *			Must be aligned according to MM_CFG_ALIGNMENT;
+ * @param	size	Heap buffer size in byte.
+ * @return	Heap handle or NULL if buffer is too small.
+ */
+mm_heap_t *		mm_heap_init			(uint8_t *buffer,
+							 uint32_t size);
+/**
+ * Release the lock of a heap created by mm_heap_init. Its buffer may then be
+ * reused.
+ */
+void			mm_heap_release			(mm_heap_t *this);
+/**
+ * Give a heap to a task. Frees from any other task are then queued without
+ * locking and performed by the owner on its next allocation.
+ * mm_heap_init gives the heap to the calling task.
+ * @param	owner	NULL makes every task free directly.
+ */
+void			mm_heap_owner_set		(mm_heap_t *this,
+							 task_t *owner);
+/**
+ * The heap mm_init sets up and the mm_alloc family works on.
+ */
+mm_heap_t *		mm_heap_default			(void);
+void *			mm_heap_alloc			(mm_heap_t *this,
+							 uint32_t size);
+void *			mm_heap_zalloc			(mm_heap_t *this,
+							 uint32_t size);
+void *			mm_heap_realloc			(mm_heap_t *this,
+							 void *ptr,
+							 uint32_t size);
+void			mm_heap_free			(mm_heap_t *this,
+							 void *ptr);
+void			mm_heap_check			(mm_heap_t *this);
+void			mm_heap_stats_get		(mm_heap_t *this,
+							 mm_stats_t *stats);
 
 MOCKABLE mm_alloc_f	mm_alloc;
 MOCKABLE mm_alloc_f	mm_zalloc;
@@ -17,6 +17,7 @@
 #ifndef __OS_SYSTEM_H__
 #define __OS_SYSTEM_H__
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef void	(*system_entry_f)	(void);
@@ -28,5 +29,18 @@ typedef struct
 }	system_entry_t;
 
 void		system_boot		(system_entry_t *entry);
+/* monotonic, wraps every ~71 minutes */
+uint32_t	system_time_us		(void);
+/* monotonic, wraps every ~4 seconds, for short durations */
+uint32_t	system_time_ns		(void);
+/* memory for mm_region_hooks_set, as close above hint as possible */
+void *		system_region_get	(void *hint,
+					 uint32_t *size);
+void		system_region_put	(void *region,
+					 uint32_t size);
+/* function addr lies in and how far in it, false if it can not be told */
+bool		system_symbol_get	(const void *addr,
+					 const char **name,
+					 uintptr_t *offset);
 
 #endif
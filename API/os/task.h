@@ -18,10 +18,14 @@
 #define __OS_TASK_H__
 
 /* Public forward declarations -----------------------------------------------*/
+struct mm_zone;
+
 /* Includes ------------------------------------------------------------------*/
 #include "common/cexcept.h"
 #include "common/mockable.h"
 #include "common/object.h"
+#include "memmgr/cache.h"
+#include "memmgr/latency.h"
 
 /* Public types --------------------------------------------------------------*/
 typedef void		(*task_delay_ms_f)		(int32_t ms);
@@ -60,5 +64,26 @@ bool			task_start			(task_t *this);
 void			task_stop			(task_t *this);
 bool			task_must_stop			(task_t *this);
 uint32_t		task_running_count		(void);
+/**
+ * Get the calling task.
+ * @return NULL if the caller is not a task.
+ */
+task_t *		task_self			(void);
+/**
+ * Get the allocation cache of the calling task.
+ * @return NULL if the caller is not a task or caches are disabled.
+ */
+mm_cache_t *		task_mm_cache_get		(void);
+/**
+ * Get the allocation latency histograms of a task.
+ * @param	this	NULL for the calling task.
+ * @return NULL if there is no such task or latencies are not recorded.
+ */
+mm_latency_t *		task_mm_latency_get		(task_t *this);
+/**
+ * Get where the default allocation zone of the calling task is kept.
+ * @return NULL if the caller is not a task or zones are disabled.
+ */
+struct mm_zone **	task_mm_zone_get		(void);
 
 #endif
@@ -22,13 +22,13 @@
 
 void		mock_chunk_setup			(void);
 void		mock_chunk_verify			(void);
-void		mock_mm_find_first_free_ExpectAndReturn	(uint16_t wanted_csize,
+void		mock_mm_find_first_free_ExpectAndReturn	(mm_csize_t wanted_csize,
 							 mm_chunk_t *ret);
 void		mock_mm_chunk_split_ExpectAndReturn	(mm_chunk_t *this,
-							 uint16_t csize,
+							 mm_csize_t csize,
 							 bool do_ret);
 void		mock_mm_chunk_merge_Expect		(mm_chunk_t *this);
-void		mock_mm_validate_csize_ExpectAndReturn	(uint16_t min_csize,
+void		mock_mm_validate_csize_ExpectAndReturn	(mm_csize_t min_csize,
 							 uint32_t csize,
 							 bool then_return);
 
@@ -21,15 +21,20 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "memmgr/cache.h"
 #include "memmgr/chunk.h"
 
 /* Macros --------------------------------------------------------------------*/
 #define CHUNK_TEST_HEAP_SIZE	(1024)
+/* a payload no chunk can hold, whatever the header width */
+#define CHUNK_TEST_TOO_BIG	((uint32_t)CSIZE_MAX * MM_CFG_ALIGNMENT)
+/* a payload no task cache nor slab serves, mm_alloc takes it from the heap */
+#define CHUNK_TEST_UNCACHED	((MM_CACHE_MIN_PAYLOAD << (MM_CFG_CACHE_CLASSES - 1)) + 12)
 
 /* Types ---------------------------------------------------------------------*/
 typedef struct
 {
-	uint16_t size;
+	mm_csize_t size;
 	bool	 allocated;
 } chunk_test_state_t;
 
@@ -17,6 +17,8 @@
 #ifndef __UTILS_STRING_H__
 #define __UTILS_STRING_H__
 
+#include "memmgr/arena.h"
+
 /**
  * Duplicate the string.
  * @param	str	String to duplicate.
@@ -24,4 +26,13 @@
  */
 char *		cstring_dup		(const char *str);
 
+/**
+ * Duplicate the string into an arena.
+ * @param	str	String to duplicate.
+ * @param	arena	Arena holding the copy.
+ * @return	new string or NULL.
+ */
+char *		cstring_dup_arena	(const char *str,
+					 mm_arena_t *arena);
+
 #endif
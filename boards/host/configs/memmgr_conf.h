@@ -0,0 +1,89 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __MEMMGR_CONF_H__
+#define __MEMMGR_CONF_H__
+
+/* Public macros -------------------------------------------------------------*/
+#define		MM_CFG_ALIGNMENT	(4)
+#define		MM_CFG_MIN_PAYLOAD	(1)
+#define		MM_CFG_HEAP_SIZE	(1024*1024)
+/* regions added by mm_add_region or the growth hooks, first one included */
+#define		MM_CFG_REGION_COUNT	(16)
+#define		MM_CFG_REGION_SIZE	(1024*1024)
+/* 0: off, 1: header checksum, 2: + guard canary, 3: + full guard tail */
+#define		MM_CFG_INTEGRITY	(1)
+#define		MM_CFG_GUARD_SIZE	(1)
+/* header checksum: 0: 16 bits xor, 1: CRC32C, hardware assisted on x86 */
+#define		MM_CFG_CRC32C		(1)
+/* 32-bit chunk sizes: heaps and allocations above 128KiB, bigger headers */
+#define		MM_CFG_WIDE_HEADER	(1)
+/* 8 bytes narrow headers, call sites move to a table of MM_CFG_CALLSITE_SLOTS
+ * (power of two, 0: not tracked) */
+#define		MM_CFG_COMPACT_HEADER	(1)
+#define		MM_CFG_CALLSITE_SLOTS	(4096)
+#define		MM_CFG_POOL_STATS	(0)
+
+/* movable blocks handed out by mm_halloc, see memmgr/handle.h */
+#define		MM_CFG_HANDLE_COUNT	(256)
+
+/* per-task caches of small chunks in front of mm_alloc/mm_free */
+#define		MM_CFG_TASK_CACHE	(1)
+#define		MM_CFG_CACHE_CLASSES	(5)
+#define		MM_CFG_CACHE_DEPTH	(16)
+#define		MM_CFG_CACHE_BATCH	(8)
+
+/* slabs of MM_SLAB_SLOTS equal slots behind mm_alloc for requests of
+ * MM_CFG_SLAB_MAX_PAYLOAD bytes or less, MM_CFG_SLAB_COUNT slabs at most */
+#define		MM_CFG_SLAB		(1)
+#define		MM_CFG_SLAB_MAX_PAYLOAD	(16)
+#define		MM_CFG_SLAB_COUNT	(64)
+
+/* stack of the background heap scrubber task */
+#define		MM_CFG_SCRUB_STACK_SIZE	(512)
+
+/* ring of the last MM_CFG_TRACE_DEPTH alloc/realloc/free, see memmgr/trace.h */
+#define		MM_CFG_TRACE		(0)
+#define		MM_CFG_TRACE_DEPTH	(4096)
+
+/* live bytes, counts and peak per call site of the default heap in an
+ * MM_CFG_PROFILE_SITES table (a power of two), see memmgr/profile.h */
+#define		MM_CFG_PROFILE		(0)
+#define		MM_CFG_PROFILE_SITES	(256)
+
+/* log-linear histograms of the alloc/realloc/free and lock wait durations
+ * per heap and per task, MM_CFG_LATENCY_BUCKETS of them, see
+ * memmgr/latency.h. Bucket 4 * (n - 1) starts at 2^n ns */
+#define		MM_CFG_LATENCY		(0)
+#define		MM_CFG_LATENCY_BUCKETS	(96)
+
+/* tag the live blocks of the mm_alloc family with their task in a table of
+ * MM_CFG_LEAK_BLOCKS (a power of two), see memmgr/leak.h */
+#define		MM_CFG_LEAK		(0)
+#define		MM_CFG_LEAK_BLOCKS	(1024)
+
+/* byte and count budgets of named zones of the default heap, blocks found
+ * back in a table of MM_CFG_ZONE_BLOCKS (a power of two), see memmgr/zone.h */
+#define		MM_CFG_ZONE		(0)
+#define		MM_CFG_ZONE_BLOCKS	(1024)
+
+/* before an allocation of the default heap fails, shrinkers give memory back
+ * and critical callers may spend a reserve of MM_CFG_RECLAIM_RESERVE bytes,
+ * see memmgr/reclaim.h */
+#define		MM_CFG_RECLAIM		(1)
+#define		MM_CFG_RECLAIM_RESERVE	(1024)
+
+#endif
@@ -24,6 +24,10 @@
 #include "common/cexcept.h"
 #include "os/memmgr.h"
 #include "os/task.h"
+#include "memmgr/pool.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+#define CEXCEPT_POOL_SIZE	(4)
 
 /* Types definitions ---------------------------------------------------------*/
 struct cexcept_ctx
@@ -37,6 +41,9 @@ struct cexcept_ctx
 	bool		is_caught;
 };
 
+/* Variables -----------------------------------------------------------------*/
+static mm_pool_declare(gs_ctx_pool, sizeof(cexcept_ctx_t), CEXCEPT_POOL_SIZE);
+
 /* Public functions ----------------------------------------------------------*/
 void cexcept_throw(const char *type, char *message, bool is_dynamic)
 {
@@ -60,7 +67,7 @@ void cexcept_throw(const char *type, char *message, bool is_dynamic)
 
 void *cexcept_enter_ctx(void)
 {
-	cexcept_ctx_t *new = mm_zalloc(sizeof(cexcept_ctx_t));
+	cexcept_ctx_t *new = mm_pool_zalloc(&gs_ctx_pool);
 	if (new == NULL) {
 		cexcept_throw("NOMEM", "no memory available to enter cexcept ctx.", false);
 	}
@@ -102,7 +109,7 @@ void cexcept_exit_ctx(void)
 	}
 
 	ctx = *cur;
-	mm_free(cur);
+	mm_pool_free(&gs_ctx_pool, cur);
 	task_cexcept_set_ctx(ctx.prev);
 
 	if (ctx.is_set && !ctx.is_caught) {
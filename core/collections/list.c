@@ -21,6 +21,8 @@
 #include "common/common.h"
 #include "collections/list.h"
 #include "os/memmgr.h"
+#include "memmgr/arena.h"
+#include "memmgr/pool.h"
 
 /* Types ---------------------------------------------------------------------*/
 typedef struct
@@ -34,13 +36,17 @@ typedef struct
 
 /* Prototypes ----------------------------------------------------------------*/
 static char *		list_to_string		(object_t *this);
+static char *		list_to_string_arena	(object_t *this,
+						 mm_arena_t *arena);
 static void		list_delete		(object_t *this);
 
 /* Variables -----------------------------------------------------------------*/
 static const object_ops_t stack_obj_ops = {
 	.to_string = list_to_string,
+	.to_string_arena = list_to_string_arena,
 	.delete = list_delete
 };
+static mm_pool_declare(gs_list_pool, sizeof(list_internal_t), LIST_POOL_SIZE);
 
 
 /* Functions definitions -----------------------------------------------------*/
@@ -56,6 +62,18 @@ static char *list_to_string(object_t *this)
 
 	return string;
 }
+static char *list_to_string_arena(object_t *this, mm_arena_t *arena)
+{
+	list_t *self = base_of(this, list_t);
+	list_internal_t *self2 = base_of(self, list_internal_t);
+
+	char *string = mm_arena_alloc(arena, 11);
+	if (string != NULL) {
+		snprintf(string, 11, "list: %d", self2->cnt % 1000);
+	}
+
+	return string;
+}
 static void list_delete(object_t *this)
 {
 	list_t *self = base_of(this, list_t);
@@ -64,13 +82,13 @@ static void list_delete(object_t *this)
 		list_pop_front(self);
 	}
 
-	mm_free(this);
+	mm_pool_free(&gs_list_pool, self2);
 }
 
 /* Functions definitions -----------------------------------------------------*/
 list_t *list_create(void)
 {
-	list_internal_t *si = mm_zalloc(sizeof(list_internal_t));
+	list_internal_t *si = mm_pool_zalloc(&gs_list_pool);
 	if (si != NULL) {
 		si->base.base.ops = &stack_obj_ops;
 		return &si->base;
@@ -96,10 +96,21 @@ TEST_TEAR_DOWN(list)
 
 TEST(list, null_on_alloc_failure)
 {
+	/* gs_list and these fill the pool, the next list comes from the heap */
+	list_t *lists[LIST_POOL_SIZE - 1];
+	for (uint32_t i = 0; i < LIST_POOL_SIZE - 1; i++) {
+		lists[i] = list_create();
+		TEST_ASSERT_NOT_NULL(lists[i]);
+	}
+
 	mock_memmgr_setup();
 	mock_mm_alloc_IgnoreAndReturn(NULL);
 	TEST_ASSERT_NULL(list_create());
 	mock_memmgr_verify();
+
+	for (uint32_t i = 0; i < LIST_POOL_SIZE - 1; i++) {
+		object_delete(&lists[i]->base);
+	}
 }
 
 TEST(list, push_back_null_does_no_harm)
@@ -109,20 +109,18 @@ TEST(cexcept, Try_Fail_to_alloc)
 
 	VERIFY_FAILS_END("Throw without context");
 
+	/* nested contexts come from the pool carved by the first one */
 	UnityMalloc_MakeMallocFailAfterCount(1);
 	Try {
-		first_try = true;
 		Try {
-			TEST_FAIL_MESSAGE("Should not be reached.");
-		} Catch {
-
+			first_try = true;
 		}
 		EndTry
 	} Catch {
 		first_catch = true;
 	}
 	EndTry
-	TEST_ASSERT_TRUE_MESSAGE(first_try && first_catch, "First try should have passed");
+	TEST_ASSERT_TRUE_MESSAGE(first_try && !first_catch, "Nested try should have passed");
 }
 
 TEST(cexcept, Catch_without_ctx)
@@ -24,6 +24,11 @@ uint32_t umin(uint32_t a, uint32_t b)
 	return (a<b)? a : b;
 }
 
+uint32_t umax(uint32_t a, uint32_t b)
+{
+	return (a>b)? a : b;
+}
+
 char *bool_to_string(bool val)
 {
 	return val?"true":"false";
@@ -19,6 +19,8 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "common/object.h"
+#include "os/memmgr.h"
+#include "utils/cstring.h"
 
 /* Private prototypes --------------------------------------------------------*/
 static bool		object_is_valid			(object_t *self);
@@ -47,3 +49,18 @@ char *object_to_string(object_t *self)
 	}
 	return NULL;
 }
+
+char *object_to_string_arena(object_t *self, struct mm_arena *arena)
+{
+	char *res = NULL;
+	if (object_is_valid(self)) {
+		if (self->ops->to_string_arena != NULL) {
+			res = self->ops->to_string_arena(self, arena);
+		} else if (self->ops->to_string != NULL) {
+			char *str = self->ops->to_string(self);
+			res = cstring_dup_arena(str, arena);
+			mm_free(str);
+		}
+	}
+	return res;
+}
@@ -18,6 +18,7 @@
 #include <string.h>
 #include "unity_fixture.h"
 #include "common/object.h"
+#include "memmgr/arena.h"
 #include "os/memmgr.h"
 #include "tests/memmgr_unity.h"
 
@@ -25,6 +26,8 @@
 /* functions's declarations */
 static void 		test_object_delete		(object_t *self);
 static char *		test_object_to_string		(object_t *self);
+static char *		test_object_to_string_arena	(object_t *self,
+							 mm_arena_t *arena);
 
 /* variables's definitions  */
 static object_t *gs_obj = NULL;
@@ -49,6 +52,16 @@ static char *test_object_to_string(object_t *self)
 	return str;
 }
 
+static char *test_object_to_string_arena(object_t *self, mm_arena_t *arena)
+{
+	static const char to_string[] = "arena object";
+	char *str = mm_arena_alloc(arena, sizeof(to_string));
+	if (str != NULL) {
+		strcpy(str, to_string);
+	}
+	return str;
+}
+
 /* Test group ----------------------------------------------------------------*/
 TEST_GROUP(object);
 
@@ -59,6 +72,9 @@ TEST_GROUP_RUNNER(object)
 	RUN_TEST_CASE(object, null_ops_does_no_harm);
 	RUN_TEST_CASE(object, null_delete_does_no_harm);
 	RUN_TEST_CASE(object, null_to_string_does_no_harm);
+	RUN_TEST_CASE(object, to_string_arena_copies_to_string);
+	RUN_TEST_CASE(object, to_string_arena_prefers_arena_op);
+	RUN_TEST_CASE(object, null_to_string_arena_does_no_harm);
 }
 
 TEST_SETUP(object)
@@ -108,3 +124,31 @@ TEST(object, null_to_string_does_no_harm)
 	TEST_ASSERT_NULL(object_to_string(gs_obj));
 	gs_obj_opts.to_string = test_object_to_string;
 }
+
+TEST(object, to_string_arena_copies_to_string)
+{
+	mm_arena_declare(arena, 32);
+	char *str = object_to_string_arena(gs_obj, &arena);
+	TEST_ASSERT_EQUAL_STRING("object", str);
+	mm_arena_reset(&arena);
+}
+
+TEST(object, to_string_arena_prefers_arena_op)
+{
+	mm_arena_declare(arena, 32);
+	gs_obj_opts.to_string_arena = test_object_to_string_arena;
+	char *str = object_to_string_arena(gs_obj, &arena);
+	gs_obj_opts.to_string_arena = NULL;
+	TEST_ASSERT_EQUAL_STRING("arena object", str);
+	mm_arena_reset(&arena);
+}
+
+TEST(object, null_to_string_arena_does_no_harm)
+{
+	mm_arena_declare(arena, 32);
+	TEST_ASSERT_NULL(object_to_string_arena(NULL, &arena));
+	gs_obj_opts.to_string = NULL;
+	TEST_ASSERT_NULL(object_to_string_arena(gs_obj, &arena));
+	gs_obj_opts.to_string = test_object_to_string;
+	TEST_ASSERT_NULL(arena.current);
+}
@@ -15,36 +15,70 @@
 CORE_DIR = core
 
 CORE_SRCS = \
-	$(CORE_DIR)/collections/list_test.c \
 	$(CORE_DIR)/collections/list.c \
 	$(CORE_DIR)/common/common.c \
 	$(CORE_DIR)/common/object.c \
-	$(CORE_DIR)/common/object_test.c \
 	$(CORE_DIR)/common/stream.c \
-	$(CORE_DIR)/common/stream_test.c \
+	$(CORE_DIR)/memmgr/arena.c \
+	$(CORE_DIR)/memmgr/cache.c \
+	$(CORE_DIR)/memmgr/handle.c \
+	$(CORE_DIR)/memmgr/latency.c \
+	$(CORE_DIR)/memmgr/leak.c \
 	$(CORE_DIR)/memmgr/memmgr.c \
+	$(CORE_DIR)/memmgr/pool.c \
+	$(CORE_DIR)/memmgr/profile.c \
+	$(CORE_DIR)/memmgr/reclaim.c \
+	$(CORE_DIR)/memmgr/remote.c \
+	$(CORE_DIR)/memmgr/scrub.c \
+	$(CORE_DIR)/memmgr/slab.c \
+	$(CORE_DIR)/memmgr/trace.c \
+	$(CORE_DIR)/memmgr/zone.c \
+	$(CORE_DIR)/memmgr/chunk.c \
+	$(CORE_DIR)/common/cexcept.c \
+	$(CORE_DIR)/os/spinlock.c \
+	$(CORE_DIR)/utils/cstring.c
+
+CORE_TESTS_SRCS = \
+	$(CORE_DIR)/collections/list_test.c \
+	$(CORE_DIR)/common/object_test.c \
+	$(CORE_DIR)/common/stream_test.c \
+	$(CORE_DIR)/memmgr/arena_test.c \
+	$(CORE_DIR)/memmgr/cache_test.c \
+	$(CORE_DIR)/memmgr/handle_test.c \
+	$(CORE_DIR)/memmgr/latency_test.c \
+	$(CORE_DIR)/memmgr/leak_test.c \
+	$(CORE_DIR)/memmgr/pool_test.c \
+	$(CORE_DIR)/memmgr/profile_test.c \
+	$(CORE_DIR)/memmgr/reclaim_test.c \
+	$(CORE_DIR)/memmgr/remote_test.c \
+	$(CORE_DIR)/memmgr/scrub_test.c \
+	$(CORE_DIR)/memmgr/slab_test.c \
+	$(CORE_DIR)/memmgr/trace_test.c \
+	$(CORE_DIR)/memmgr/zone_test.c \
 	$(CORE_DIR)/memmgr/memmgr_mock.c \
 	$(CORE_DIR)/memmgr/memmgr_mock_test.c \
 	$(CORE_DIR)/memmgr/memmgr_unity.c \
 	$(CORE_DIR)/memmgr/memmgr_test.c \
 	$(CORE_DIR)/memmgr/memmgr_test_alloc.c \
+	$(CORE_DIR)/memmgr/memmgr_test_batch.c \
 	$(CORE_DIR)/memmgr/memmgr_test_free.c \
+	$(CORE_DIR)/memmgr/memmgr_test_heap.c \
 	$(CORE_DIR)/memmgr/memmgr_test_realloc.c \
-	$(CORE_DIR)/memmgr/chunk.c \
 	$(CORE_DIR)/memmgr/chunk_mock.c \
 	$(CORE_DIR)/memmgr/chunk_mock_test.c \
 	$(CORE_DIR)/memmgr/chunk_test.c \
 	$(CORE_DIR)/memmgr/chunk_test_tools.c \
 	$(CORE_DIR)/memmgr/chunk_test_validate.c \
-	$(CORE_DIR)/common/cexcept.c \
 	$(CORE_DIR)/common/cexcept_test.c \
-	$(CORE_DIR)/os/spinlock.c \
 	$(CORE_DIR)/os/spinlock_test.c \
 	$(CORE_DIR)/os/task_mock.c \
 	$(CORE_DIR)/os/task_mock_test.c \
-	$(CORE_DIR)/utils/cstring.c \
 	$(CORE_DIR)/utils/cstring_test.c
-	
+
+ifeq ($(TESTS),yes)
+CORE_SRCS += $(CORE_TESTS_SRCS)
+endif
+
 CORE_CFLAGS +=
 
 DEPS += $(call src_to_dep,$(CORE_SRCS))
@@ -0,0 +1,129 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "os/memmgr.h"
+#include "memmgr/arena.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+#define MM_ARENA_ROUND(size) \
+		(((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+/* Types ---------------------------------------------------------------------*/
+struct mm_arena_block
+{
+	mm_arena_block_t	*prev;
+	uint32_t		size;
+	uint32_t		used;
+};
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint8_t *	mm_arena_payload	(mm_arena_block_t *block);
+static bool		mm_arena_grow		(mm_arena_t *this,
+						 uint32_t size);
+
+/* Private functions definitions ---------------------------------------------*/
+static uint8_t *mm_arena_payload(mm_arena_block_t *block)
+{
+	return (uint8_t *)block + MM_ARENA_ROUND(sizeof(mm_arena_block_t));
+}
+
+static bool mm_arena_grow(mm_arena_t *this, uint32_t size)
+{
+	uint32_t payload = umax(size, this->block_size);
+	mm_arena_block_t *block = mm_alloc(MM_ARENA_ROUND(sizeof(mm_arena_block_t)) +
+					   payload);
+	if (block == NULL) {
+		return false;
+	}
+	block->prev = this->current;
+	block->size = payload;
+	block->used = 0;
+	this->current = block;
+	return true;
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_arena_init(mm_arena_t *this, uint32_t block_size)
+{
+	this->current = NULL;
+	this->block_size = MM_ARENA_ROUND(block_size);
+}
+
+void *mm_arena_alloc(mm_arena_t *this, uint32_t size)
+{
+	if (size == 0) {
+		return NULL;
+	}
+	size = MM_ARENA_ROUND(size);
+
+	mm_arena_block_t *block = this->current;
+	if ((block == NULL) || ((block->size - block->used) < size)) {
+		if (!mm_arena_grow(this, size)) {
+			return NULL;
+		}
+		block = this->current;
+	}
+
+	void *ptr = mm_arena_payload(block) + block->used;
+	block->used += size;
+	return ptr;
+}
+
+void *mm_arena_zalloc(mm_arena_t *this, uint32_t size)
+{
+	void *ptr = mm_arena_alloc(this, size);
+	if (ptr != NULL) {
+		memset(ptr, 0, size);
+	}
+	return ptr;
+}
+
+mm_arena_mark_t mm_arena_mark(mm_arena_t *this)
+{
+	mm_arena_mark_t mark = {
+		.block = this->current,
+		.used = (this->current != NULL) ? this->current->used : 0
+	};
+	return mark;
+}
+
+void mm_arena_restore(mm_arena_t *this, mm_arena_mark_t mark)
+{
+	while ((this->current != NULL) && (this->current != mark.block)) {
+		mm_arena_block_t *prev = this->current->prev;
+		mm_free(this->current);
+		this->current = prev;
+	}
+
+	if (this->current != mark.block) {
+		die("MM: arena mark");
+	}
+	if (this->current != NULL) {
+		this->current->used = mark.used;
+	}
+}
+
+void mm_arena_reset(mm_arena_t *this)
+{
+	mm_arena_mark_t empty = { .block = NULL, .used = 0 };
+	mm_arena_restore(this, empty);
+}
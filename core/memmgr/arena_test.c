@@ -0,0 +1,179 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/memmgr_unity.h"
+#include "memmgr/arena.h"
+#include "os/memmgr.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			BLOCK_SIZE		(64)
+
+static mm_arena_t gs_arena;
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_arena);
+
+TEST_GROUP_RUNNER(mm_arena)
+{
+	RUN_TEST_CASE(mm_arena, alloc_zero_returns_null);
+	RUN_TEST_CASE(mm_arena, alloc_fails_if_heap_is_exhausted);
+	RUN_TEST_CASE(mm_arena, alloc_bumps_within_a_block);
+	RUN_TEST_CASE(mm_arena, alloc_is_pointer_aligned);
+	RUN_TEST_CASE(mm_arena, alloc_chains_a_new_block);
+	RUN_TEST_CASE(mm_arena, big_alloc_gets_its_own_block);
+	RUN_TEST_CASE(mm_arena, zalloc_clears_memory);
+	RUN_TEST_CASE(mm_arena, restore_rewinds_current_block);
+	RUN_TEST_CASE(mm_arena, restore_releases_chained_blocks);
+	RUN_TEST_CASE(mm_arena, nested_marks);
+	RUN_TEST_CASE(mm_arena, restore_stale_mark_leads_to_death);
+	RUN_TEST_CASE(mm_arena, reset_releases_everything);
+}
+
+TEST_SETUP(mm_arena)
+{
+	unity_mock_setup();
+	mm_arena_init(&gs_arena, BLOCK_SIZE);
+}
+
+TEST_TEAR_DOWN(mm_arena)
+{
+	mm_arena_reset(&gs_arena);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_arena, alloc_zero_returns_null)
+{
+	TEST_ASSERT_NULL(mm_arena_alloc(&gs_arena, 0));
+	TEST_ASSERT_NULL(gs_arena.current);
+}
+
+TEST(mm_arena, alloc_fails_if_heap_is_exhausted)
+{
+	UnityMalloc_MakeMallocFailAfterCount(0);
+	TEST_ASSERT_NULL(mm_arena_alloc(&gs_arena, 8));
+	TEST_ASSERT_NULL(gs_arena.current);
+}
+
+TEST(mm_arena, alloc_bumps_within_a_block)
+{
+	uint8_t *a = mm_arena_alloc(&gs_arena, 8);
+	uint8_t *b = mm_arena_alloc(&gs_arena, 8);
+
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_EQUAL_PTR(a + 8, b);
+}
+
+TEST(mm_arena, alloc_is_pointer_aligned)
+{
+	uint8_t *a = mm_arena_alloc(&gs_arena, 3);
+	uint8_t *b = mm_arena_alloc(&gs_arena, 1);
+
+	TEST_ASSERT_EQUAL_PTR(a + sizeof(void *), b);
+	TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)b % sizeof(void *));
+}
+
+TEST(mm_arena, alloc_chains_a_new_block)
+{
+	mm_arena_alloc(&gs_arena, BLOCK_SIZE - 8);
+	mm_arena_block_t *first = gs_arena.current;
+
+	TEST_ASSERT_NOT_NULL(mm_arena_alloc(&gs_arena, 16));
+	TEST_ASSERT_TRUE(first != gs_arena.current);
+	TEST_ASSERT_NOT_NULL(mm_arena_alloc(&gs_arena, 8));
+}
+
+TEST(mm_arena, big_alloc_gets_its_own_block)
+{
+	uint8_t *big = mm_arena_alloc(&gs_arena, BLOCK_SIZE * 4);
+
+	TEST_ASSERT_NOT_NULL(big);
+	memset(big, 0xA5, BLOCK_SIZE * 4);
+}
+
+TEST(mm_arena, zalloc_clears_memory)
+{
+	mm_arena_mark_t mark = mm_arena_mark(&gs_arena);
+	uint8_t *a = mm_arena_alloc(&gs_arena, 16);
+	memset(a, 0xA5, 16);
+	mm_arena_restore(&gs_arena, mark);
+
+	a = mm_arena_zalloc(&gs_arena, 16);
+	for (uint32_t i = 0; i < 16; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, a[i]);
+	}
+}
+
+TEST(mm_arena, restore_rewinds_current_block)
+{
+	mm_arena_alloc(&gs_arena, 8);
+	mm_arena_mark_t mark = mm_arena_mark(&gs_arena);
+	uint8_t *a = mm_arena_alloc(&gs_arena, 8);
+
+	mm_arena_restore(&gs_arena, mark);
+	TEST_ASSERT_EQUAL_PTR(a, mm_arena_alloc(&gs_arena, 8));
+}
+
+TEST(mm_arena, restore_releases_chained_blocks)
+{
+	uint8_t *a = mm_arena_alloc(&gs_arena, 8);
+	mm_arena_mark_t mark = mm_arena_mark(&gs_arena);
+
+	mm_arena_alloc(&gs_arena, BLOCK_SIZE);
+	mm_arena_alloc(&gs_arena, BLOCK_SIZE);
+	mm_arena_restore(&gs_arena, mark);
+
+	TEST_ASSERT_EQUAL_PTR(mark.block, gs_arena.current);
+	TEST_ASSERT_EQUAL_PTR(a + 8, mm_arena_alloc(&gs_arena, 8));
+}
+
+TEST(mm_arena, nested_marks)
+{
+	mm_arena_mark_t outer = mm_arena_mark(&gs_arena);
+	uint8_t *a = mm_arena_alloc(&gs_arena, 8);
+	mm_arena_mark_t inner = mm_arena_mark(&gs_arena);
+	mm_arena_alloc(&gs_arena, BLOCK_SIZE);
+
+	mm_arena_restore(&gs_arena, inner);
+	TEST_ASSERT_EQUAL_PTR(a + 8, mm_arena_alloc(&gs_arena, 8));
+
+	mm_arena_restore(&gs_arena, outer);
+	TEST_ASSERT_NULL(gs_arena.current);
+}
+
+TEST(mm_arena, restore_stale_mark_leads_to_death)
+{
+	mm_arena_alloc(&gs_arena, 8);
+	mm_arena_mark_t mark = mm_arena_mark(&gs_arena);
+	mm_arena_reset(&gs_arena);
+
+	EXPECT_ABORT_BEGIN
+	mm_arena_restore(&gs_arena, mark);
+	VERIFY_FAILS_END("MM: arena mark");
+}
+
+TEST(mm_arena, reset_releases_everything)
+{
+	mm_arena_alloc(&gs_arena, 8);
+	mm_arena_alloc(&gs_arena, BLOCK_SIZE);
+	mm_arena_alloc(&gs_arena, BLOCK_SIZE * 2);
+
+	mm_arena_reset(&gs_arena);
+	TEST_ASSERT_NULL(gs_arena.current);
+}
@@ -0,0 +1,240 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "memmgr/cache.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/remote.h"
+#include "memmgr_conf.h"
+
+/*
+ * Cached chunks stay allocated in the heap. They are allocated with the full
+ * payload of their class so their header never has to change while they move
+ * in and out of the cache: neither path touches a header nor takes the lock.
+ * Cached chunks are linked through the first word of their payload. Without
+ * the lock only the fields the caller owns are checked, the heap validates a
+ * chunk in full once a flush gives it back.
+ *
+ * A task that only frees would otherwise fight for the lock with the task
+ * that only allocates. When the lock is taken, its flushes go to the remote
+ * free list of the heap instead, which refills recycle before locking.
+ */
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint32_t		mm_cache_payload		(uint32_t cls);
+static int32_t		mm_cache_class_of_size		(uint32_t size);
+static int32_t		mm_cache_class_of_ptr		(void *ptr);
+static void		mm_cache_push			(mm_cache_bin_t *bin,
+							 void *ptr);
+static void *		mm_cache_pop			(mm_cache_bin_t *bin);
+static void		mm_cache_recycle		(mm_cache_t *this);
+static void		mm_cache_refill			(mm_cache_bin_t *bin,
+							 uint32_t cls,
+							 void *lr);
+static void		mm_cache_flush			(mm_cache_bin_t *bin,
+							 uint32_t count);
+
+/* Private functions definitions ---------------------------------------------*/
+static uint32_t mm_cache_payload(uint32_t cls)
+{
+	return MM_CACHE_MIN_PAYLOAD << cls;
+}
+
+static int32_t mm_cache_class_of_size(uint32_t size)
+{
+	for (uint32_t cls = 0; cls < MM_CFG_CACHE_CLASSES; cls++) {
+		if (size <= mm_cache_payload(cls)) {
+			return cls;
+		}
+	}
+	return -1;
+}
+
+static int32_t mm_cache_class_of_ptr(void *ptr)
+{
+	mm_chunk_t *chnk = ptr - (mm_header_csize()*MM_CFG_ALIGNMENT);
+	for (uint32_t cls = 0; cls < MM_CFG_CACHE_CLASSES; cls++) {
+		if (chnk->guard_offset == mm_cache_payload(cls)) {
+			return cls;
+		}
+	}
+	return -1;
+}
+
+static void mm_cache_push(mm_cache_bin_t *bin, void *ptr)
+{
+	*(void **)ptr = bin->first;
+	bin->first = ptr;
+	bin->count++;
+}
+
+static void *mm_cache_pop(mm_cache_bin_t *bin)
+{
+	void *ptr = bin->first;
+	if (ptr != NULL) {
+		bin->first = *(void **)ptr;
+		bin->count--;
+	}
+	return ptr;
+}
+
+static void mm_cache_recycle(mm_cache_t *this)
+{
+	mm_heap_t *heap = mm_heap_default();
+	mm_remote_node_t *node = mm_remote_take(&heap->remote);
+	mm_remote_node_t *first = NULL;
+	mm_remote_node_t *last = NULL;
+
+	while (node != NULL) {
+		mm_remote_node_t *next = node->next;
+		int32_t cls = mm_cache_class_of_ptr(node);
+		if ((cls >= 0) && (this->bins[cls].count < MM_CFG_CACHE_DEPTH)) {
+			mm_cache_push(&this->bins[cls], node);
+		} else {
+			// not for us, the heap frees it on its next allocation
+			node->next = first;
+			first = node;
+			if (last == NULL) {
+				last = node;
+			}
+		}
+		node = next;
+	}
+	if (first != NULL) {
+		mm_remote_push(&heap->remote, first, last);
+	}
+}
+
+static void mm_cache_refill(mm_cache_bin_t *bin, uint32_t cls, void *lr)
+{
+	mm_lock();
+	for (uint32_t i = 0; i < MM_CFG_CACHE_BATCH; i++) {
+		void *ptr = mm_alloc_uncached(mm_cache_payload(cls), lr);
+		if (ptr == NULL) {
+			break;
+		}
+		mm_cache_push(bin, ptr);
+	}
+	mm_unlock();
+}
+
+static void mm_cache_flush(mm_cache_bin_t *bin, uint32_t count)
+{
+	mm_heap_t *heap = mm_heap_default();
+	if ((count == 0) || (bin->first == NULL)) {
+		return;
+	}
+
+	if (!mm_heap_trylock(heap)) {
+		mm_remote_node_t *first = bin->first;
+		mm_remote_node_t *last = first;
+		bin->count--;
+		while ((--count > 0) && (last->next != NULL)) {
+			last = last->next;
+			bin->count--;
+		}
+		bin->first = last->next;
+		mm_remote_push(&heap->remote, first, last);
+		return;
+	}
+	while ((count > 0) && (bin->first != NULL)) {
+		mm_free_uncached(mm_cache_pop(bin));
+		count--;
+	}
+	mm_heap_unlock(heap);
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_cache_init(mm_cache_t *this)
+{
+	memset(this, 0, sizeof(mm_cache_t));
+}
+
+void *mm_cache_alloc(mm_cache_t *this, uint32_t size, void *lr)
+{
+	if ((this == NULL) || (size == 0)) {
+		return NULL;
+	}
+	int32_t cls = mm_cache_class_of_size(size);
+	if (cls < 0) {
+		return NULL;
+	}
+
+	mm_cache_bin_t *bin = &this->bins[cls];
+	if (bin->first == NULL) {
+		mm_cache_recycle(this);
+	}
+	if (bin->first == NULL) {
+		mm_cache_refill(bin, cls, lr);
+	}
+	return mm_cache_pop(bin);
+}
+
+bool mm_cache_free(mm_cache_t *this, void *ptr)
+{
+	if ((this == NULL) || (ptr == NULL)) {
+		return false;
+	}
+	// the class comes from the header, do not trust it before this
+	mm_chunk_owned(ptr);
+	int32_t cls = mm_cache_class_of_ptr(ptr);
+	if (cls < 0) {
+		return false;
+	}
+	if (mm_cache_holds(this, ptr)) {
+		die("MM: double free");
+	}
+	mm_cache_bin_t *bin = &this->bins[cls];
+	if (bin->count >= MM_CFG_CACHE_DEPTH) {
+		mm_cache_flush(bin, MM_CFG_CACHE_BATCH);
+	}
+	mm_cache_push(bin, ptr);
+	return true;
+}
+
+bool mm_cache_holds(mm_cache_t *this, void *ptr)
+{
+	if ((this == NULL) || (ptr == NULL)) {
+		return false;
+	}
+	int32_t cls = mm_cache_class_of_ptr(ptr);
+	if (cls < 0) {
+		return false;
+	}
+	// cached chunks stay allocated, only their bin knows they were freed
+	for (void *it = this->bins[cls].first; it != NULL; it = *(void **)it) {
+		if (it == ptr) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void mm_cache_drain(mm_cache_t *this)
+{
+	if (this == NULL) {
+		return;
+	}
+	for (uint32_t cls = 0; cls < MM_CFG_CACHE_CLASSES; cls++) {
+		mm_cache_flush(&this->bins[cls], this->bins[cls].count);
+	}
+}
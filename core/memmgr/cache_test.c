@@ -0,0 +1,210 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/cache.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+static void		heap_validate		(void);
+
+static mm_cache_t gs_cache;
+
+static void heap_validate(void)
+{
+	mm_chunk_t *chnk = g_first;
+	mm_chunk_validate(chnk);
+	while (chnk != NULL) {
+		chnk = mm_chunk_next_get(chnk);
+	}
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_cache);
+
+TEST_GROUP_RUNNER(mm_cache)
+{
+	RUN_TEST_CASE(mm_cache, null_cache_does_not_cache);
+	RUN_TEST_CASE(mm_cache, alloc_too_big_is_not_cached);
+	RUN_TEST_CASE(mm_cache, alloc_refills_a_batch);
+	RUN_TEST_CASE(mm_cache, free_keeps_chunk_allocated);
+	RUN_TEST_CASE(mm_cache, free_rejects_uncached_size);
+	RUN_TEST_CASE(mm_cache, holds_only_freed_chunks);
+	RUN_TEST_CASE(mm_cache, double_free_leads_to_death);
+	RUN_TEST_CASE(mm_cache, misaligned_free_leads_to_death);
+	RUN_TEST_CASE(mm_cache, free_flushes_a_batch_when_full);
+	RUN_TEST_CASE(mm_cache, drain_gives_everything_back);
+	RUN_TEST_CASE(mm_cache, alloc_recycles_remote_frees);
+}
+
+TEST_SETUP(mm_cache)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_cache_init(&gs_cache);
+}
+
+TEST_TEAR_DOWN(mm_cache)
+{
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_cache, null_cache_does_not_cache)
+{
+	void *ptr = mm_alloc(8);
+
+	TEST_ASSERT_NULL(mm_cache_alloc(NULL, 8, NULL));
+	TEST_ASSERT_FALSE(mm_cache_free(NULL, ptr));
+	TEST_ASSERT_FALSE(mm_cache_free(&gs_cache, NULL));
+	mm_free(ptr);
+}
+
+TEST(mm_cache, alloc_too_big_is_not_cached)
+{
+	uint32_t max = MM_CACHE_MIN_PAYLOAD << (MM_CFG_CACHE_CLASSES - 1);
+
+	TEST_ASSERT_NULL(mm_cache_alloc(&gs_cache, 0, NULL));
+	TEST_ASSERT_NULL(mm_cache_alloc(&gs_cache, max + 1, NULL));
+	chunk_test_state_t a_expect[] = {{256, false}};
+	chunk_test_verify(a_expect, 1);
+}
+
+TEST(mm_cache, alloc_refills_a_batch)
+{
+	void *lr = __builtin_return_address(0);
+	void *ptr = mm_cache_alloc(&gs_cache, 10, lr);
+	mm_chunk_t *chnk = mm_tochunk(ptr);
+
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_TRUE(chnk->allocated);
+	TEST_ASSERT_EQUAL_UINT32(16, chnk->guard_offset);
+	TEST_ASSERT_EQUAL_PTR(lr, mm_chunk_allocator_get(chnk));
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_CACHE_BATCH - 1, gs_cache.bins[1].count);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_cache.bins[0].count);
+}
+
+TEST(mm_cache, free_keeps_chunk_allocated)
+{
+	void *ptr = mm_cache_alloc(&gs_cache, 16, NULL);
+
+	TEST_ASSERT_TRUE(mm_cache_free(&gs_cache, ptr));
+	TEST_ASSERT_TRUE(mm_tochunk(ptr)->allocated);
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_CACHE_BATCH, gs_cache.bins[1].count);
+	TEST_ASSERT_EQUAL_PTR(ptr, mm_cache_alloc(&gs_cache, 12, NULL));
+	heap_validate();
+}
+
+TEST(mm_cache, free_rejects_uncached_size)
+{
+	void *ptr = mm_alloc_uncached(10, NULL);
+
+	TEST_ASSERT_FALSE(mm_cache_free(&gs_cache, ptr));
+	mm_free_uncached(ptr);
+	chunk_test_state_t a_expect[] = {{256, false}};
+	chunk_test_verify(a_expect, 1);
+}
+
+TEST(mm_cache, holds_only_freed_chunks)
+{
+	void *ptr = mm_cache_alloc(&gs_cache, 16, NULL);
+
+	TEST_ASSERT_FALSE(mm_cache_holds(&gs_cache, ptr));
+	TEST_ASSERT_TRUE(mm_cache_free(&gs_cache, ptr));
+	TEST_ASSERT_TRUE(mm_cache_holds(&gs_cache, ptr));
+	TEST_ASSERT_FALSE(mm_cache_holds(NULL, ptr));
+}
+
+TEST(mm_cache, double_free_leads_to_death)
+{
+	void *ptr = mm_cache_alloc(&gs_cache, 16, NULL);
+	TEST_ASSERT_TRUE(mm_cache_free(&gs_cache, ptr));
+
+	EXPECT_ABORT_BEGIN
+	mm_cache_free(&gs_cache, ptr);
+	VERIFY_FAILS_END("MM: double free");
+}
+
+TEST(mm_cache, misaligned_free_leads_to_death)
+{
+	uint8_t *ptr = mm_cache_alloc(&gs_cache, 16, NULL);
+
+	EXPECT_ABORT_BEGIN
+	mm_cache_free(&gs_cache, ptr + 1);
+	VERIFY_FAILS_END("MM: alignment");
+}
+
+TEST(mm_cache, free_flushes_a_batch_when_full)
+{
+	mm_cache_t other;
+	void *ptrs[MM_CFG_CACHE_DEPTH + 1];
+
+	mm_cache_init(&other);
+	for (uint32_t i = 0; i < MM_CFG_CACHE_DEPTH + 1; i++) {
+		ptrs[i] = mm_cache_alloc(&other, 8, NULL);
+		TEST_ASSERT_NOT_NULL(ptrs[i]);
+	}
+	for (uint32_t i = 0; i < MM_CFG_CACHE_DEPTH; i++) {
+		TEST_ASSERT_TRUE(mm_cache_free(&gs_cache, ptrs[i]));
+	}
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_CACHE_DEPTH, gs_cache.bins[0].count);
+
+	TEST_ASSERT_TRUE(mm_cache_free(&gs_cache, ptrs[MM_CFG_CACHE_DEPTH]));
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_CACHE_DEPTH - MM_CFG_CACHE_BATCH + 1,
+				 gs_cache.bins[0].count);
+	TEST_ASSERT_FALSE(mm_tochunk(ptrs[MM_CFG_CACHE_DEPTH - 1])->allocated);
+	TEST_ASSERT_TRUE(mm_tochunk(ptrs[0])->allocated);
+	heap_validate();
+}
+
+TEST(mm_cache, drain_gives_everything_back)
+{
+	void *small = mm_cache_alloc(&gs_cache, 4, NULL);
+	void *big = mm_cache_alloc(&gs_cache, 40, NULL);
+
+	mm_cache_free(&gs_cache, small);
+	mm_cache_free(&gs_cache, big);
+	mm_cache_drain(&gs_cache);
+
+	for (uint32_t cls = 0; cls < MM_CFG_CACHE_CLASSES; cls++) {
+		TEST_ASSERT_EQUAL_UINT32(0, gs_cache.bins[cls].count);
+		TEST_ASSERT_NULL(gs_cache.bins[cls].first);
+	}
+	chunk_test_state_t a_expect[] = {{256, false}};
+	chunk_test_verify(a_expect, 1);
+}
+
+TEST(mm_cache, alloc_recycles_remote_frees)
+{
+	void *ptr = mm_alloc_uncached(MM_CACHE_MIN_PAYLOAD, NULL);
+	chunk_test_state_t a_expect[] = {
+		{mm_to_csize(MM_CACHE_MIN_PAYLOAD), true},
+		{256 - mm_to_csize(MM_CACHE_MIN_PAYLOAD), false}
+	};
+
+	TEST_ASSERT_TRUE(mm_heap_remote_push(mm_heap_default(), ptr));
+	TEST_ASSERT_EQUAL_PTR(ptr, mm_cache_alloc(&gs_cache, 1, NULL));
+	chunk_test_verify(a_expect, 2);
+}
@@ -24,28 +24,120 @@
 
 #include "memmgr_conf.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MM_X86_KERNELS		(1)
+#include <immintrin.h>
+#else
+#define MM_X86_KERNELS		(0)
+#endif
+
 /* Macro definitions ---------------------------------------------------------*/
+#if MM_CFG_COMPACT_HEADER && (MM_CFG_CALLSITE_SLOTS & (MM_CFG_CALLSITE_SLOTS - 1))
+#error "MM_CFG_CALLSITE_SLOTS must be a power of two"
+#endif
+
 #define MM_GUARD_PAD		(0x3E)
+#define MM_GUARD_WORD		(((uintptr_t)-1 / 0xFF) * MM_GUARD_PAD)
+#define MM_FREE_NIL		(0x7FFFFFFF)
 
 /* Type definitions ----------------------------------------------------------*/
+/* Stored in the last bytes of every free chunk's payload.
+ * Links are offsets from the first chunk, in MM_CFG_ALIGNMENT units. */
 typedef struct
 {
-	mm_chunk_t	*first;
-	mm_chunk_t	*last;
-	uint32_t	count;
-} mm_boundary_t;
+	uint32_t	prev:31;
+	/* the payload reads zero but for the guard pad and this link */
+	bool		zeroed:1;
+	uint32_t	next;
+} mm_free_link_t;
+
+typedef bool		(*mm_guard_check_f)		(const uint8_t *ptr,
+							 uint32_t size);
+typedef uint32_t	(*mm_crc32c_f)			(uint32_t crc,
+							 const uint8_t *data,
+							 uint32_t len);
 
 /* Prototypes ----------------------------------------------------------------*/
 static uint32_t		mm_to_aligned_csize		(uint32_t size);
+static uint32_t		mm_fls				(uint32_t val);
+static uint32_t		mm_guard_span			(mm_chunk_t *this);
+static uint16_t		mm_chunk_xorsum_at		(mm_chunk_t *this,
+							 uintptr_t self);
+static bool		mm_guard_check_word		(const uint8_t *ptr,
+							 uint32_t size);
+static bool		mm_guard_check_resolve		(const uint8_t *ptr,
+							 uint32_t size);
+static uint32_t		mm_crc32c_soft			(uint32_t crc,
+							 const uint8_t *data,
+							 uint32_t len);
+#if MM_CFG_COMPACT_HEADER
+static mm_callsite_t *	mm_callsite_find		(mm_callsite_table_t *table,
+							 mm_chunk_t *chnk,
+							 uint32_t *key);
+static void		mm_callsite_remove		(mm_callsite_table_t *table,
+							 mm_callsite_t *slot);
+#endif
+static uint32_t		mm_crc32c_resolve		(uint32_t crc,
+							 const uint8_t *data,
+							 uint32_t len);
+#if MM_X86_KERNELS
+static bool		mm_guard_check_sse2		(const uint8_t *ptr,
+							 uint32_t size)
+						__attribute__((target("sse2")));
+static bool		mm_guard_check_avx2		(const uint8_t *ptr,
+							 uint32_t size)
+						__attribute__((target("avx2")));
+static uint32_t		mm_crc32c_sse42			(uint32_t crc,
+							 const uint8_t *data,
+							 uint32_t len)
+						__attribute__((target("sse4.2")));
+#endif
+static void		mm_free_mapping			(uint32_t csize,
+							 uint32_t *fl,
+							 uint32_t *sl);
+static mm_free_link_t *	mm_free_link			(mm_chunk_t *this);
+static uint32_t		mm_free_offset			(mm_chunk_t *this);
+static mm_chunk_t *	mm_free_chunk			(uint32_t offset);
+static void		mm_free_insert			(mm_chunk_t *this,
+							 bool zeroed);
+static void		mm_free_remove			(mm_chunk_t *this);
+static void		mm_free_rebuild			(void);
+static uint32_t		mm_free_largest			(void);
+static mm_region_t *	mm_region_ending		(mm_chunk_t *this);
+static void		mm_region_last_set		(mm_region_t *region,
+							 mm_chunk_t *last);
 static void		mm_chunk_merge_impl		(mm_chunk_t *this);
 static mm_chunk_t *	mm_chunk_split_impl		(mm_chunk_t *this,
-							 uint16_t csize);
-static mm_chunk_t *	mm_find_first_free_impl		(uint16_t wanted_csize);
-static bool		mm_validate_csize_impl		(uint16_t min_csize,
+							 mm_csize_t csize);
+static mm_chunk_t *	mm_find_first_free_impl		(mm_csize_t wanted_csize);
+static bool		mm_validate_csize_impl		(mm_csize_t min_csize,
 							 uint32_t csize);
 
 /* Variables -----------------------------------------------------------------*/
-static mm_boundary_t gs_chunk_boundary = {NULL, NULL};
+#if MM_CFG_COMPACT_HEADER && (MM_CFG_CALLSITE_SLOTS > 0)
+static mm_callsite_t gs_callsites[MM_CFG_CALLSITE_SLOTS];
+static mm_chunk_ctx_t gs_default_ctx = {
+	.callsites = {
+		.slots = gs_callsites,
+		.mask = MM_CFG_CALLSITE_SLOTS - 1
+	}
+};
+#else
+static mm_chunk_ctx_t gs_default_ctx;
+#endif
+static __thread mm_chunk_ctx_t *gs_ctx = &gs_default_ctx;
+
+/* kernels are picked on first use, from the CPU features */
+static mm_guard_check_f gs_guard_check = mm_guard_check_resolve;
+static mm_crc32c_f gs_crc32c = mm_crc32c_resolve;
+
+/* CRC32C (reflected 0x82F63B78) of every nibble value */
+static const uint32_t gs_crc32c_nibble[16] = {
+	0x00000000, 0x105EC76F, 0x20BD8EDE, 0x30E349B1,
+	0x417B1DBC, 0x5125DAD3, 0x61C69362, 0x7198540D,
+	0x82F63B78, 0x92A8FC17, 0xA24BB5A6, 0xB21572C9,
+	0xC38D26C4, 0xD3D3E1AB, 0xE330A81A, 0xF36E6F75
+};
 
 MOCKABLE mm_find_first_free_f mm_find_first_free = mm_find_first_free_impl;
 MOCKABLE mm_chunk_merge_f mm_chunk_merge = mm_chunk_merge_impl;
@@ -58,6 +150,391 @@ static uint32_t mm_to_aligned_csize(uint32_t size)
 	return ((size + (MM_CFG_ALIGNMENT-1))/MM_CFG_ALIGNMENT);
 }
 
+static uint32_t mm_fls(uint32_t val)
+{
+	return 31 - __builtin_clz(val);
+}
+
+/* number of guard bytes, starting at guard_offset, the integrity level covers */
+static uint32_t mm_guard_span(mm_chunk_t *this)
+{
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CANARY
+	uint32_t size = mm_guard_size(this);
+	if (!this->allocated) {
+		// keep the free list link intact
+		size -= sizeof(mm_free_link_t);
+	}
+#if MM_CFG_INTEGRITY < MM_INTEGRITY_FULL
+	size = umin(size, MM_CFG_GUARD_SIZE*MM_CFG_ALIGNMENT);
+#endif
+	return size;
+#else
+	(void)this;
+	return 0;
+#endif
+}
+
+static bool mm_guard_check_word(const uint8_t *ptr, uint32_t size)
+{
+	while ((size != 0) && (((uintptr_t)ptr % sizeof(uintptr_t)) != 0)) {
+		if (*ptr != MM_GUARD_PAD) {
+			return false;
+		}
+		ptr++;
+		size--;
+	}
+	for (; size >= sizeof(uintptr_t); size -= sizeof(uintptr_t)) {
+		uintptr_t word;
+		memcpy(&word, ptr, sizeof(word));
+		if (word != MM_GUARD_WORD) {
+			return false;
+		}
+		ptr += sizeof(uintptr_t);
+	}
+	while (size-- != 0) {
+		if (*ptr++ != MM_GUARD_PAD) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#if MM_X86_KERNELS
+static bool mm_guard_check_sse2(const uint8_t *ptr, uint32_t size)
+{
+	const __m128i pad = _mm_set1_epi8(MM_GUARD_PAD);
+	for (; size >= sizeof(__m128i); size -= sizeof(__m128i)) {
+		__m128i v = _mm_loadu_si128((const __m128i *)ptr);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, pad)) != 0xFFFF) {
+			return false;
+		}
+		ptr += sizeof(__m128i);
+	}
+	return mm_guard_check_word(ptr, size);
+}
+
+static bool mm_guard_check_avx2(const uint8_t *ptr, uint32_t size)
+{
+	const __m256i pad = _mm256_set1_epi8(MM_GUARD_PAD);
+	for (; size >= sizeof(__m256i); size -= sizeof(__m256i)) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)ptr);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, pad)) != -1) {
+			return false;
+		}
+		ptr += sizeof(__m256i);
+	}
+	return mm_guard_check_word(ptr, size);
+}
+
+static uint32_t mm_crc32c_sse42(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+#if defined(__x86_64__)
+	for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, data, sizeof(word));
+		crc = _mm_crc32_u64(crc, word);
+		data += sizeof(uint64_t);
+	}
+#endif
+	for (; len >= sizeof(uint32_t); len -= sizeof(uint32_t)) {
+		uint32_t word;
+		memcpy(&word, data, sizeof(word));
+		crc = _mm_crc32_u32(crc, word);
+		data += sizeof(uint32_t);
+	}
+	while (len-- != 0) {
+		crc = _mm_crc32_u8(crc, *data++);
+	}
+	return crc;
+}
+#endif
+
+static bool mm_guard_check_resolve(const uint8_t *ptr, uint32_t size)
+{
+	mm_guard_check_f check = mm_guard_check_word;
+#if MM_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		check = mm_guard_check_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		check = mm_guard_check_sse2;
+	}
+#endif
+	gs_guard_check = check;
+	return check(ptr, size);
+}
+
+static uint32_t mm_crc32c_soft(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+	while (len-- != 0) {
+		crc ^= *data++;
+		crc = (crc >> 4) ^ gs_crc32c_nibble[crc & 0xF];
+		crc = (crc >> 4) ^ gs_crc32c_nibble[crc & 0xF];
+	}
+	return crc;
+}
+
+static uint32_t mm_crc32c_resolve(uint32_t crc, const uint8_t *data,
+				  uint32_t len)
+{
+	mm_crc32c_f kernel = mm_crc32c_soft;
+#if MM_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2")) {
+		kernel = mm_crc32c_sse42;
+	}
+#endif
+	gs_crc32c = kernel;
+	return kernel(crc, data, len);
+}
+
+/* checksum of a header as if it lived at self */
+static uint16_t mm_chunk_xorsum_at(mm_chunk_t *this, uintptr_t self)
+{
+#if MM_CFG_INTEGRITY < MM_INTEGRITY_CHECKSUM
+	// nobody checks it, keep the headers stable
+	(void)this;
+	(void)self;
+	return 0;
+#elif MM_CFG_CRC32C
+	// every field is hashed on its own, corruptions cannot cancel out
+	struct {
+		uintptr_t	self;
+		uintptr_t	allocator;
+		uint32_t	prev_size;
+		uint32_t	csize;
+		uint32_t	guard_offset;
+		uint32_t	allocated;
+	} fields = {
+		.self = self,
+#if !MM_CFG_COMPACT_HEADER
+		.allocator = (uintptr_t)this->allocator,
+#endif
+		.prev_size = this->prev_size,
+		.csize = this->csize,
+		.guard_offset = this->guard_offset,
+		.allocated = this->allocated
+	};
+	uint32_t crc = mm_crc32c(&fields, sizeof(fields));
+	return (crc >> 16) ^ (crc & 0xFFFF);
+#else
+	uint32_t sizes = this->guard_offset ^ this->prev_size ^ this->csize;
+#if MM_CFG_WIDE_HEADER
+	sizes ^= (sizes >> 16);
+#endif
+#if MM_CFG_COMPACT_HEADER
+	uintptr_t allocator = 0;
+#else
+	uintptr_t allocator = (uintptr_t)this->allocator;
+#endif
+	// a heap moved by a multiple of 64KiB must not check out
+	uint64_t at = self;
+	at ^= at >> 32;
+	at ^= at >> 16;
+	return	this->allocated ^
+		sizes ^
+		(at & 0xFFFF) ^
+		((allocator >> 16) & 0xFFFF) ^
+		(allocator & 0xFFFF);
+#endif
+}
+
+#if MM_CFG_COMPACT_HEADER
+/* slot holding chnk, or the empty one ending its probe sequence */
+static mm_callsite_t *mm_callsite_find(mm_callsite_table_t *table,
+				       mm_chunk_t *chnk, uint32_t *key)
+{
+	*key = (((uintptr_t)chnk - (uintptr_t)gs_ctx->boundary.first) /
+		MM_CFG_ALIGNMENT) + 1;
+	uint32_t i = *key * 2654435761u;
+	for (uint32_t n = 0; n <= table->mask; n++, i++) {
+		mm_callsite_t *slot = &table->slots[i & table->mask];
+		if ((slot->key == *key) || (slot->key == 0)) {
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+/* backward shift deletion, probe sequences stay free of holes */
+static void mm_callsite_remove(mm_callsite_table_t *table, mm_callsite_t *slot)
+{
+	uint32_t hole = slot - table->slots;
+	uint32_t i = hole;
+	for (;;) {
+		i = (i + 1) & table->mask;
+		mm_callsite_t *it = &table->slots[i];
+		if (it->key == 0) {
+			break;
+		}
+		uint32_t home = (it->key * 2654435761u) & table->mask;
+		// move it back unless its home lies cyclically in (hole, i]
+		if (((i - home) & table->mask) >= ((i - hole) & table->mask)) {
+			table->slots[hole] = *it;
+			hole = i;
+		}
+	}
+	table->slots[hole].key = 0;
+	table->slots[hole].site = NULL;
+	table->count--;
+}
+#endif
+
+static void mm_free_mapping(uint32_t csize, uint32_t *fl, uint32_t *sl)
+{
+	if (csize < MM_SL_COUNT) {
+		*fl = 0;
+		*sl = csize;
+	} else {
+		uint32_t msb = mm_fls(csize);
+		*fl = msb - MM_SL_LOG2 + 1;
+		*sl = (csize >> (msb - MM_SL_LOG2)) ^ MM_SL_COUNT;
+	}
+}
+
+static mm_free_link_t *mm_free_link(mm_chunk_t *this)
+{
+	return (mm_free_link_t *)((uintptr_t)mm_compute_next(this, this->csize) - sizeof(mm_free_link_t));
+}
+
+static uint32_t mm_free_offset(mm_chunk_t *this)
+{
+	if (this == NULL) {
+		return MM_FREE_NIL;
+	}
+	return ((uintptr_t)this - (uintptr_t)gs_ctx->boundary.first) / MM_CFG_ALIGNMENT;
+}
+
+static mm_chunk_t *mm_free_chunk(uint32_t offset)
+{
+	if (offset == MM_FREE_NIL) {
+		return NULL;
+	}
+	return (mm_chunk_t *)((uintptr_t)gs_ctx->boundary.first + offset * MM_CFG_ALIGNMENT);
+}
+
+static void mm_free_insert(mm_chunk_t *this, bool zeroed)
+{
+	uint32_t fl = 0, sl = 0;
+	mm_free_mapping(this->csize, &fl, &sl);
+
+	mm_chunk_t *head = gs_ctx->index.heads[fl][sl];
+	mm_free_link_t *link = mm_free_link(this);
+	link->prev = MM_FREE_NIL;
+	link->zeroed = zeroed;
+	link->next = mm_free_offset(head);
+	if (head != NULL) {
+		mm_free_link(head)->prev = mm_free_offset(this);
+	}
+
+	gs_ctx->index.heads[fl][sl] = this;
+	gs_ctx->index.fl_bitmap |= (1U << fl);
+	gs_ctx->index.sl_bitmap[fl] |= (1U << sl);
+
+	mm_chunk_stats_t *stats = &gs_ctx->stats;
+	stats->free_csize += this->csize;
+	stats->free_count ++;
+	if (this->csize > stats->largest_csize) {
+		stats->largest_csize = this->csize;
+	}
+}
+
+static void mm_free_remove(mm_chunk_t *this)
+{
+	uint32_t fl = 0, sl = 0;
+	mm_free_mapping(this->csize, &fl, &sl);
+
+	mm_free_link_t *link = mm_free_link(this);
+	mm_chunk_t *prev = mm_free_chunk(link->prev);
+	mm_chunk_t *next = mm_free_chunk(link->next);
+
+	if (next != NULL) {
+		mm_free_link(next)->prev = link->prev;
+	}
+	if (prev != NULL) {
+		mm_free_link(prev)->next = link->next;
+	} else {
+		gs_ctx->index.heads[fl][sl] = next;
+		if (next == NULL) {
+			gs_ctx->index.sl_bitmap[fl] &= ~(1U << sl);
+			if (gs_ctx->index.sl_bitmap[fl] == 0) {
+				gs_ctx->index.fl_bitmap &= ~(1U << fl);
+			}
+		}
+	}
+
+	// give the link area back to the guard pad
+	memset(link, MM_GUARD_PAD, sizeof(mm_free_link_t));
+
+	mm_chunk_stats_t *stats = &gs_ctx->stats;
+	stats->free_csize -= this->csize;
+	stats->free_count --;
+	if (this->csize == stats->largest_csize) {
+		stats->largest_csize = mm_free_largest();
+	}
+}
+
+/* biggest free chunk, only the highest non empty class needs a look */
+static uint32_t mm_free_largest(void)
+{
+	if (gs_ctx->index.fl_bitmap == 0) {
+		return 0;
+	}
+	uint32_t fl = mm_fls(gs_ctx->index.fl_bitmap);
+	uint32_t sl = mm_fls(gs_ctx->index.sl_bitmap[fl]);
+	uint32_t largest = 0;
+
+	mm_chunk_t *chnk = gs_ctx->index.heads[fl][sl];
+	while (chnk != NULL) {
+		largest = umax(largest, chnk->csize);
+		chnk = mm_free_chunk(mm_free_link(chnk)->next);
+	}
+	return largest;
+}
+
+static void mm_free_rebuild(void)
+{
+	memset(&gs_ctx->index, 0, sizeof(gs_ctx->index));
+	memset(&gs_ctx->stats, 0, sizeof(gs_ctx->stats));
+
+	// walk backward so that the lowest addresses end up at each list's head
+	for (uint32_t i = gs_ctx->boundary.region_count; i-- > 0; ) {
+		mm_region_t *region = &gs_ctx->boundary.regions[i];
+		mm_chunk_t *chnk = region->last;
+		while (chnk != NULL) {
+			if (!chnk->allocated) {
+				mm_free_insert(chnk, false);
+			}
+			gs_ctx->stats.total_csize += chnk->csize;
+			if (chnk == region->first) {
+				break;
+			}
+			chnk = mm_chunk_prev_get(chnk);
+		}
+	}
+	mm_chunk_stats_peak();
+}
+
+/* region this chunk is the last one of, NULL if there is a chunk after it */
+static mm_region_t *mm_region_ending(mm_chunk_t *this)
+{
+	mm_boundary_t *boundary = &gs_ctx->boundary;
+	for (uint32_t i = boundary->region_count; i-- > 0; ) {
+		if (boundary->regions[i].last == this) {
+			return &boundary->regions[i];
+		}
+	}
+	return NULL;
+}
+
+static void mm_region_last_set(mm_region_t *region, mm_chunk_t *last)
+{
+	if (gs_ctx->boundary.last == region->last) {
+		gs_ctx->boundary.last = last;
+	}
+	region->last = last;
+}
+
 static void mm_chunk_merge_impl(mm_chunk_t *this)
 {
 	mm_chunk_t *next = mm_chunk_next_get(this);
@@ -73,8 +550,23 @@ static void mm_chunk_merge_impl(mm_chunk_t *this)
 	if (size > CSIZE_MAX) {
 		return;
 	}
-	gs_chunk_boundary.count --;
+
+	// the link of this, the header of next and its guard pad join the payload
+	bool zeroed = mm_chunk_zeroed_get(this) && mm_chunk_zeroed_get(next);
+	uint8_t *seam = (uint8_t *)mm_free_link(this);
+	uint8_t *seam_end = mm_toptr(next) + mm_guard_span(next);
+	if (!this->allocated) {
+		mm_free_remove(this);
+	}
+	if (!next->allocated) {
+		mm_free_remove(next);
+	}
+	gs_ctx->boundary.count --;
+	mm_chunk_allocator_set(next, NULL);
 	this->csize = size;
+	if (gs_ctx->cursor == next) {
+		gs_ctx->cursor = this;
+	}
 
 	if (next->allocated) {
 		this->allocated = true;
@@ -86,9 +578,23 @@ static void mm_chunk_merge_impl(mm_chunk_t *this)
 
 	mm_chunk_guard_set(this, guard_offset);
 	this->xorsum = mm_chunk_xorsum(this);
+	if (zeroed) {
+		// what the guard pad of the merged chunk does not cover yet
+		uint8_t *pad_end = mm_toptr(this) + mm_guard_span(this);
+		if (seam < pad_end) {
+			seam = pad_end;
+		}
+		if (seam < seam_end) {
+			memset(seam, 0, seam_end - seam);
+		}
+	}
+	if (!this->allocated) {
+		mm_free_insert(this, zeroed);
+	}
 
-	if (gs_chunk_boundary.last == next) {
-		gs_chunk_boundary.last = this;
+	mm_region_t *region = mm_region_ending(next);
+	if (region != NULL) {
+		mm_region_last_set(region, this);
 	} else {
 		next = mm_chunk_next_get(this);
 		next->prev_size = this->csize;
@@ -96,7 +602,7 @@ static void mm_chunk_merge_impl(mm_chunk_t *this)
 	}
 }
 
-static mm_chunk_t *mm_chunk_split_impl(mm_chunk_t *this, uint16_t csize)
+static mm_chunk_t *mm_chunk_split_impl(mm_chunk_t *this, mm_csize_t csize)
 {
 	mm_chunk_t *next = mm_chunk_next_get(this);
 
@@ -105,54 +611,171 @@ static mm_chunk_t *mm_chunk_split_impl(mm_chunk_t *this, uint16_t csize)
 		return NULL;
 	}
 
+	// both halves of a zeroed chunk stay zeroed
+	bool zeroed = mm_chunk_zeroed_get(this);
+	if (!this->allocated) {
+		mm_free_remove(this);
+	}
 	this->csize = csize;
 	this->xorsum = mm_chunk_xorsum(this);
+	if (!this->allocated) {
+		mm_free_insert(this, zeroed);
+	}
 	mm_chunk_t *new = mm_compute_next(this, csize);
 
 	mm_chunk_init(new, this, new_size);
-	gs_chunk_boundary.count ++;
+	mm_free_insert(new, zeroed);
+	gs_ctx->boundary.count ++;
 
 	if (next != NULL) {
 		next->prev_size = new_size;
 		next->xorsum = mm_chunk_xorsum(next);
 	} else {
-		gs_chunk_boundary.last = new;
+		mm_region_last_set(mm_region_ending(this), new);
 	}
 
 	return new;
 }
-static mm_chunk_t *mm_find_first_free_impl(uint16_t wanted_csize)
+static mm_chunk_t *mm_find_first_free_impl(mm_csize_t wanted_csize)
 {
-	mm_chunk_t *chnk = gs_chunk_boundary.first;
-	mm_chunk_validate(chnk);
+	mm_chunk_t *chnk = NULL;
+	uint32_t fl = 0, sl = 0;
+	uint32_t csize = wanted_csize;
 
-	while ((chnk != NULL) &&
-	       ((chnk->csize < wanted_csize) || chnk->allocated))
-	{
-		chnk = mm_chunk_next_get(chnk);
+	// round up to the next class so that any chunk found there fits
+	if (csize >= MM_SL_COUNT) {
+		csize += (1U << (mm_fls(csize) - MM_SL_LOG2)) - 1;
 	}
+	mm_free_mapping(csize, &fl, &sl);
 
+	if (fl < MM_FL_COUNT) {
+		uint32_t sl_map = gs_ctx->index.sl_bitmap[fl] & (~0U << sl);
+		if (sl_map == 0) {
+			uint32_t fl_map = gs_ctx->index.fl_bitmap & (~0U << (fl + 1));
+			if (fl_map != 0) {
+				fl = __builtin_ctz(fl_map);
+				sl_map = gs_ctx->index.sl_bitmap[fl];
+			}
+		}
+		if (sl_map != 0) {
+			chnk = gs_ctx->index.heads[fl][__builtin_ctz(sl_map)];
+		}
+	}
+
+	if (chnk == NULL) {
+		// last resort: chunks sharing the wanted class may still be big enough
+		mm_free_mapping(wanted_csize, &fl, &sl);
+		chnk = gs_ctx->index.heads[fl][sl];
+		while ((chnk != NULL) && (chnk->csize < wanted_csize)) {
+			chnk = mm_free_chunk(mm_free_link(chnk)->next);
+		}
+	}
+
+	if (chnk != NULL) {
+		mm_chunk_validate(chnk);
+		if (chnk->allocated) {
+			die("MM: free list");
+		}
+	}
 	return chnk;
 }
 
-static bool mm_validate_csize_impl(uint16_t min_csize, uint32_t csize)
+static bool mm_validate_csize_impl(mm_csize_t min_csize, uint32_t csize)
 {
 	return (min_csize <= csize) && (csize <= CSIZE_MAX);
 }
 
 /* Functions' definitions ----------------------------------------------------*/
+void mm_chunk_ctx_set(mm_chunk_ctx_t *ctx)
+{
+	gs_ctx = (ctx != NULL) ? ctx : &gs_default_ctx;
+}
+
+mm_chunk_ctx_t *mm_chunk_ctx_get(void)
+{
+	return gs_ctx;
+}
+
+mm_chunk_ctx_t *mm_chunk_ctx_default(void)
+{
+	return &gs_default_ctx;
+}
+
 void mm_chunk_boundary_set(mm_chunk_t *first, mm_chunk_t *last, uint32_t count)
 {
-	gs_chunk_boundary.first = first;
-	gs_chunk_boundary.last = last;
-	gs_chunk_boundary.count = count;
+	gs_ctx->boundary.first = first;
+	gs_ctx->boundary.last = last;
+	gs_ctx->boundary.count = count;
+	gs_ctx->boundary.regions[0].first = first;
+	gs_ctx->boundary.regions[0].last = last;
+	gs_ctx->boundary.region_count = 1;
+	gs_ctx->cursor = NULL;
+#if MM_CFG_COMPACT_HEADER
+	mm_callsite_table_t *table = &gs_ctx->callsites;
+	if (table->slots != NULL) {
+		memset(table->slots, 0, (table->mask + 1) * sizeof(mm_callsite_t));
+	}
+	table->count = 0;
+	table->dropped = 0;
+#endif
+	mm_free_rebuild();
+}
+
+bool mm_chunk_attach(mm_chunk_t *first, uint32_t heap_csize, const void *origin)
+{
+	mm_chunk_t *prev = NULL;
+	mm_chunk_t *chnk = first;
+	uint32_t count = 0;
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CHECKSUM
+	uintptr_t shift = (uintptr_t)origin - (uintptr_t)first;
+#else
+	// only the checksums know where the headers were written
+	(void)origin;
+#endif
+
+	// nothing is touched until every header checks out
+	while (heap_csize >= mm_min_csize()) {
+		if ((chnk->csize < mm_min_csize()) || (chnk->csize > heap_csize) ||
+		    (chnk->prev_size != ((prev != NULL) ? prev->csize : 0)) ||
+		    (chnk->guard_offset > (chnk->csize - mm_header_csize()) * MM_CFG_ALIGNMENT)) {
+			return false;
+		}
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CHECKSUM
+		if (mm_chunk_xorsum_at(chnk, (uintptr_t)chnk + shift) != chnk->xorsum) {
+			return false;
+		}
+#endif
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CANARY
+		if (!mm_chunk_guard_get(chnk)) {
+			return false;
+		}
+#endif
+		heap_csize -= chnk->csize;
+		count++;
+		prev = chnk;
+		chnk = mm_compute_next(chnk, chnk->csize);
+	}
+	if (count == 0) {
+		return false;
+	}
+
+	mm_chunk_boundary_set(first, prev, count);
+	for (chnk = first; ; chnk = mm_compute_next(chnk, chnk->csize)) {
+		// call sites belong to the previous run of the program
+		mm_chunk_allocator_set(chnk, NULL);
+		chnk->xorsum = mm_chunk_xorsum(chnk);
+		if (chnk == prev) {
+			break;
+		}
+	}
+	return true;
 }
 
-void mm_chunk_init(mm_chunk_t *this, mm_chunk_t *prev, uint16_t csize)
+void mm_chunk_init(mm_chunk_t *this, mm_chunk_t *prev, mm_csize_t csize)
 {
 	this->csize = csize;
 	this->allocated = false;
-	this->allocator = NULL;
+	mm_chunk_allocator_set(this, NULL);
 	mm_chunk_guard_set(this, 0);
 	if (prev != NULL) {
 		this->prev_size = prev->csize;
@@ -162,14 +785,14 @@ void mm_chunk_init(mm_chunk_t *this, mm_chunk_t *prev, uint16_t csize)
 	this->xorsum = mm_chunk_xorsum(this);
 }
 
-mm_chunk_t *mm_compute_next(mm_chunk_t *this, uint16_t csize)
+mm_chunk_t *mm_compute_next(mm_chunk_t *this, mm_csize_t csize)
 {
 	return (mm_chunk_t *)(((uintptr_t)this) + (csize * MM_CFG_ALIGNMENT));
 }
 
 mm_chunk_t *mm_chunk_next_get(mm_chunk_t *this)
 {
-	if (this == gs_chunk_boundary.last) {
+	if ((this == gs_ctx->boundary.last) || (mm_region_ending(this) != NULL)) {
 		return NULL;
 	}
 	mm_chunk_t *next = mm_compute_next(this, this->csize);
@@ -177,6 +800,62 @@ mm_chunk_t *mm_chunk_next_get(mm_chunk_t *this)
 	return next;
 }
 
+mm_chunk_t *mm_chunk_walk_next(mm_chunk_t *this)
+{
+	mm_boundary_t *boundary = &gs_ctx->boundary;
+	if (this == boundary->last) {
+		return NULL;
+	}
+	for (uint32_t i = 0; i + 1 < boundary->region_count; i++) {
+		if (boundary->regions[i].last == this) {
+			return boundary->regions[i + 1].first;
+		}
+	}
+	return mm_compute_next(this, this->csize);
+}
+
+bool mm_chunk_region_add(void *buffer, uint32_t csize, bool zeroed)
+{
+	mm_boundary_t *boundary = &gs_ctx->boundary;
+	uintptr_t start = (uintptr_t)buffer;
+	uintptr_t end = start + ((uintptr_t)csize * MM_CFG_ALIGNMENT);
+	if ((boundary->region_count == MM_CFG_REGION_COUNT) ||
+	    (csize < mm_min_csize()) || ((start % MM_CFG_ALIGNMENT) != 0) ||
+	    (start < (uintptr_t)boundary->first) ||
+	    // free list links are 31 bits offsets
+	    (((end - (uintptr_t)boundary->first) / MM_CFG_ALIGNMENT) >= MM_FREE_NIL)) {
+		return false;
+	}
+	for (uint32_t i = 0; i < boundary->region_count; i++) {
+		mm_region_t *region = &boundary->regions[i];
+		uintptr_t region_end = (uintptr_t)mm_compute_next(region->last, region->last->csize);
+		if ((start < region_end) && ((uintptr_t)region->first < end)) {
+			return false;
+		}
+	}
+
+	mm_region_t *region = &boundary->regions[boundary->region_count];
+	mm_chunk_t *chnk = buffer;
+	mm_chunk_t *prev = NULL;
+	region->first = chnk;
+	while (csize >= mm_min_csize()) {
+		mm_csize_t size = umin(csize, CSIZE_MAX);
+		csize -= size;
+
+		mm_chunk_init(chnk, prev, size);
+		mm_free_insert(chnk, zeroed);
+		boundary->count ++;
+		gs_ctx->stats.total_csize += size;
+
+		prev = chnk;
+		chnk = mm_compute_next(chnk, size);
+	}
+	region->last = prev;
+	boundary->region_count ++;
+	boundary->last = prev;
+	return true;
+}
+
 mm_chunk_t *mm_chunk_prev_get(mm_chunk_t *this)
 {
 	if (this->prev_size == 0) {
@@ -192,33 +871,67 @@ uint32_t mm_guard_size(mm_chunk_t *this)
 
 bool mm_chunk_guard_get(mm_chunk_t *this)
 {
-	uint8_t *ptr = mm_toptr(this) + this->guard_offset;
-
-	for (uint32_t i = 0; i < (MM_CFG_GUARD_SIZE*MM_CFG_ALIGNMENT); i++) {
-		if (ptr[i] != MM_GUARD_PAD) {
-			return false;
-		}
-	}
-	return true;
+	return gs_guard_check(mm_toptr(this) + this->guard_offset,
+			      mm_guard_span(this));
 }
 
 void mm_chunk_guard_set(mm_chunk_t *this, uint32_t offset)
 {
 	this->guard_offset = offset;
-	uint8_t *ptr = mm_toptr(this) + offset;
-	uint32_t size = ((this->csize-mm_header_csize()) * MM_CFG_ALIGNMENT)-offset;
-	memset(ptr, MM_GUARD_PAD, size);
+	memset(mm_toptr(this) + offset, MM_GUARD_PAD, mm_guard_span(this));
 }
 
 uint16_t mm_chunk_xorsum(mm_chunk_t *this)
 {
-	return	this->allocated ^
-		this->guard_offset ^
-		this->prev_size ^
-		this->csize ^
-		(((uintptr_t)this) & 0xFFFF) ^
-		(((uintptr_t)this->allocator >> 16) & 0xFFFF) ^
-		((uintptr_t)this->allocator & 0xFFFF);
+	return mm_chunk_xorsum_at(this, (uintptr_t)this);
+}
+
+void *mm_chunk_allocator_get(mm_chunk_t *this)
+{
+#if MM_CFG_COMPACT_HEADER
+	mm_callsite_table_t *table = &gs_ctx->callsites;
+	uint32_t key = 0;
+	mm_callsite_t *slot = NULL;
+	if (table->slots != NULL) {
+		slot = mm_callsite_find(table, this, &key);
+	}
+	return (slot != NULL) ? slot->site : NULL;
+#else
+	return this->allocator;
+#endif
+}
+
+void mm_chunk_allocator_set(mm_chunk_t *this, void *allocator)
+{
+#if MM_CFG_COMPACT_HEADER
+	mm_callsite_table_t *table = &gs_ctx->callsites;
+	uint32_t key = 0;
+	if (table->slots == NULL) {
+		return;
+	}
+	mm_callsite_t *slot = mm_callsite_find(table, this, &key);
+	if (allocator == NULL) {
+		if ((slot != NULL) && (slot->key != 0)) {
+			mm_callsite_remove(table, slot);
+		}
+	} else if ((slot != NULL) && (slot->key != 0)) {
+		slot->site = allocator;
+	} else if ((slot != NULL) && (table->count < (table->mask + 1) / 4 * 3)) {
+		// empty slots must remain to end the probe sequences
+		slot->key = key;
+		slot->site = allocator;
+		table->count++;
+	} else {
+		table->dropped++;
+	}
+#else
+	this->allocator = allocator;
+#endif
+}
+
+uint32_t mm_crc32c(const void *data, uint32_t len)
+{
+	return ~gs_crc32c(0xFFFFFFFF, data, len);
 }
 
 void mm_chunk_validate(mm_chunk_t *this)
@@ -229,20 +942,155 @@ void mm_chunk_validate(mm_chunk_t *this)
 		die("MM: alignment");
 	}
 	
-	if ((this < gs_chunk_boundary.first) ||
-	    (gs_chunk_boundary.last < this)) {
+	mm_boundary_t *boundary = &gs_ctx->boundary;
+	uint32_t i = 0;
+	while ((i < boundary->region_count) &&
+	       ((this < boundary->regions[i].first) || (boundary->regions[i].last < this))) {
+		i++;
+	}
+	if (i == boundary->region_count) {
 		die("MM: out of bound");
 	}
 
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CHECKSUM
 	// have a valid header chksum
 	if (mm_chunk_xorsum(this) != this->xorsum) {
 		die("MM: xorsum");
 	}
+#endif
 	
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CANARY
 	// have not overflowed
 	if (!mm_chunk_guard_get(this)) {
 		die("MM: overflowed");
 	}
+#endif
+}
+
+void mm_chunk_allocated_set(mm_chunk_t *this, bool allocated)
+{
+	if (this->allocated == allocated) {
+		return;
+	}
+	this->allocated = allocated;
+	if (allocated) {
+		mm_free_remove(this);
+		mm_chunk_stats_peak();
+	} else {
+		mm_free_insert(this, false);
+	}
+}
+
+uint32_t mm_chunk_free_run(void **ptrs, uint32_t n)
+{
+	mm_chunk_t *first = mm_tochunk(ptrs[0]);
+	mm_chunk_t *last = first;
+	uint32_t csize = first->csize;
+	uint32_t used = 1;
+	uint32_t merged = 1;
+
+	if (!first->allocated) {
+		die("MM: double free");
+	}
+	mm_chunk_allocator_set(first, NULL);
+	while ((used < n) && (mm_region_ending(last) == NULL)) {
+		mm_chunk_t *next = mm_compute_next(last, last->csize);
+		if ((ptrs[used] != mm_toptr(next)) ||
+		    (csize + next->csize > CSIZE_MAX)) {
+			break;
+		}
+		mm_chunk_validate(next);
+		if (!next->allocated) {
+			die("MM: double free");
+		}
+		mm_chunk_allocator_set(next, NULL);
+		csize += next->csize;
+		last = next;
+		used ++;
+	}
+	merged = used;
+
+	mm_chunk_t *prev = mm_chunk_prev_get(first);
+	if (prev != NULL) {
+		mm_chunk_validate(prev);
+		if (!prev->allocated && (csize + prev->csize <= CSIZE_MAX)) {
+			mm_free_remove(prev);
+			csize += prev->csize;
+			first = prev;
+			merged ++;
+		}
+	}
+	mm_chunk_t *next = mm_chunk_next_get(last);
+	if (mm_chunk_is_available(next) && (csize + next->csize <= CSIZE_MAX)) {
+		mm_free_remove(next);
+		csize += next->csize;
+		last = next;
+		merged ++;
+	}
+
+	if ((first < gs_ctx->cursor) && (gs_ctx->cursor <= last)) {
+		gs_ctx->cursor = first;
+	}
+	gs_ctx->boundary.count -= merged - 1;
+	first->csize = csize;
+	first->allocated = false;
+	mm_chunk_allocator_set(first, NULL);
+	mm_chunk_guard_set(first, 0);
+	first->xorsum = mm_chunk_xorsum(first);
+	mm_free_insert(first, false);
+
+	mm_region_t *region = mm_region_ending(last);
+	if (region != NULL) {
+		mm_region_last_set(region, first);
+	} else {
+		next = mm_compute_next(first, csize);
+		next->prev_size = csize;
+		next->xorsum = mm_chunk_xorsum(next);
+	}
+	return used;
+}
+
+bool mm_chunk_zeroed_get(mm_chunk_t *this)
+{
+	return !this->allocated && mm_free_link(this)->zeroed;
+}
+
+void mm_chunk_zero(mm_chunk_t *this)
+{
+	if (this->allocated) {
+		die("MM: zero allocated");
+	}
+	mm_free_link_t *link = mm_free_link(this);
+	uint8_t *start = mm_toptr(this) + mm_guard_span(this);
+	if (start < (uint8_t *)link) {
+		memset(start, 0, (uint8_t *)link - start);
+	}
+	link->zeroed = true;
+}
+
+void mm_chunk_clear(mm_chunk_t *this, uint32_t size, bool zeroed)
+{
+	uint8_t *ptr = mm_toptr(this);
+	if (!zeroed) {
+		memset(ptr, 0, size);
+		return;
+	}
+
+	// only the guard pad and the free list link are left to clear
+	uint32_t link = (uint8_t *)mm_free_link(this) - ptr;
+	memset(ptr, 0, umin(size, mm_guard_span(this)));
+	if (size > link) {
+		memset(ptr + link, 0, size - link);
+	}
+}
+
+void mm_chunk_stats_peak(void)
+{
+	mm_chunk_stats_t *stats = &gs_ctx->stats;
+	uint32_t used = stats->total_csize - stats->free_csize;
+	if (used > stats->peak_used_csize) {
+		stats->peak_used_csize = used;
+	}
 }
 
 bool mm_chunk_is_available(mm_chunk_t *this)
@@ -250,7 +1098,7 @@ bool mm_chunk_is_available(mm_chunk_t *this)
 	return (this != NULL) && (!this->allocated);
 }
 
-uint16_t mm_chunk_available_csize(mm_chunk_t *this)
+mm_csize_t mm_chunk_available_csize(mm_chunk_t *this)
 {
 	if (!mm_chunk_is_available(this)) {
 		return 0;
@@ -271,42 +1119,61 @@ mm_chunk_t *mm_tochunk(void *ptr)
 	return chunk;
 }
 
+mm_chunk_t *mm_chunk_owned(void *ptr)
+{
+	// the neighbours and the regions may be changing under another task
+	if (((uintptr_t)ptr % MM_CFG_ALIGNMENT) != 0) {
+		die("MM: alignment");
+	}
+	mm_chunk_t *chunk = ptr - (mm_header_csize()*MM_CFG_ALIGNMENT);
+	if (!chunk->allocated) {
+		die("MM: double free");
+	}
+	return chunk;
+}
+
 uint32_t mm_chunk_count(void)
 {
-	return gs_chunk_boundary.count;
+	return gs_ctx->boundary.count;
 }
 
 void mm_chunk_info(mm_cinfo_t *infos, uint32_t size)
 {
 	uint32_t cnt = 0;
 
-	mm_chunk_t *chnk = gs_chunk_boundary.first;
+	mm_chunk_t *chnk = gs_ctx->boundary.first;
 	mm_chunk_validate(chnk);
 
 	while ((chnk != NULL) && (cnt < size)) {
 		infos[cnt].allocated = chnk->allocated;
-		infos[cnt].allocator = chnk->allocator;
+		infos[cnt].allocator = mm_chunk_allocator_get(chnk);
 		infos[cnt].size = chnk->guard_offset;
 		infos[cnt].csize = chnk->csize;
 
 		cnt ++;
-		chnk = mm_chunk_next_get(chnk);
+		chnk = mm_chunk_walk_next(chnk);
+		if (chnk != NULL) {
+			mm_chunk_validate(chnk);
+		}
 	}
 }
 
 uint32_t mm_to_csize(uint32_t size)
 {
 	int32_t wanted_csize = mm_to_aligned_csize(size);
-	wanted_csize += mm_header_csize() + MM_CFG_GUARD_SIZE;
-	return wanted_csize;
+	wanted_csize += mm_header_csize() + MM_GUARD_CSIZE;
+	// once freed, the chunk must be able to hold its free list link
+	return umax(wanted_csize, mm_min_csize());
 }
 
-uint16_t mm_min_csize(void)
+mm_csize_t mm_min_csize(void)
 {
-	return mm_header_csize() + MM_CFG_MIN_PAYLOAD + MM_CFG_GUARD_SIZE;
+	// a free chunk must hold its free list link besides the guard
+	uint32_t payload = umax(MM_CFG_MIN_PAYLOAD, mm_to_aligned_csize(sizeof(mm_free_link_t)));
+	return mm_header_csize() + payload + MM_GUARD_CSIZE;
 }
 
-uint16_t mm_header_csize(void)
+mm_csize_t mm_header_csize(void)
 {
 	return mm_to_aligned_csize(sizeof(mm_chunk_t));
 }
@@ -44,17 +44,17 @@ struct _mock_call
 		struct
 		{
 			mm_chunk_t	*expect_this;
-			uint16_t	expect_csize;
+			mm_csize_t	expect_csize;
 			bool		then_return_null;
 		} split;
 		struct
 		{
-			uint16_t	expect_csize;
+			mm_csize_t	expect_csize;
 			mm_chunk_t	*then_return;
 		} find_first_free;
 		struct
 		{
-			uint16_t	expect_min_csize;
+			mm_csize_t	expect_min_csize;
 			uint32_t	expect_csize;
 			bool		then_return;
 		} validate_csize;
@@ -65,11 +65,11 @@ struct _mock_call
 void *			unity_malloc				(size_t size);
 void			unity_free				(void *ptr);
 
-static mm_chunk_t *	mock_mm_find_first_free			(uint16_t wanted_csize);
+static mm_chunk_t *	mock_mm_find_first_free			(mm_csize_t wanted_csize);
 static mm_chunk_t *	mock_mm_chunk_split			(mm_chunk_t *this,
-								 uint16_t csize);
+								 mm_csize_t csize);
 static void		mock_mm_chunk_merge			(mm_chunk_t *this);
-static bool		mock_mm_validate_csize			(uint16_t min_csize,
+static bool		mock_mm_validate_csize			(mm_csize_t min_csize,
 								 uint32_t csize);
 
 static mock_call_type_e mock_expect				(void);
@@ -85,7 +85,7 @@ static mm_chunk_split_f gs_chunk_split = NULL;
 static mm_chunk_merge_f gs_chunk_merge = NULL;
 
 /* Private definitions -------------------------------------------------------*/
-static mm_chunk_t *mock_mm_find_first_free(uint16_t wanted_csize)
+static mm_chunk_t *mock_mm_find_first_free(mm_csize_t wanted_csize)
 {
 	TEST_ASSERT_MESSAGE(mock_expect() == mock_call_type_find_first_free,
 			    "Unexpected call to mm_find_first_free.");
@@ -96,7 +96,7 @@ static mm_chunk_t *mock_mm_find_first_free(uint16_t wanted_csize)
 	return ret;
 }
 
-static mm_chunk_t *mock_mm_chunk_split(mm_chunk_t *this, uint16_t csize)
+static mm_chunk_t *mock_mm_chunk_split(mm_chunk_t *this, mm_csize_t csize)
 {
 	TEST_ASSERT_MESSAGE(mock_expect() == mock_call_type_split,
 			    "Unexpected call to mm_chunk_split.");
@@ -123,7 +123,7 @@ static void mock_mm_chunk_merge(mm_chunk_t *this)
 	gs_chunk_merge(this);
 }
 
-static bool mock_mm_validate_csize(uint16_t min_csize, uint32_t csize)
+static bool mock_mm_validate_csize(mm_csize_t min_csize, uint32_t csize)
 {
 	TEST_ASSERT_MESSAGE(mock_expect() == mock_call_type_validate_csize,
 			    "Unexpected call to mm_validate_csize.");
@@ -189,7 +189,7 @@ void mock_chunk_verify(void)
 	TEST_ASSERT_MESSAGE(success, "Calls were still expected");
 }
 
-void mock_mm_find_first_free_ExpectAndReturn(uint16_t wanted_csize, mm_chunk_t *ret)
+void mock_mm_find_first_free_ExpectAndReturn(mm_csize_t wanted_csize, mm_chunk_t *ret)
 {
 	mock_call_t *new = unity_malloc(sizeof(mock_call_t));
 	if (new == NULL) {
@@ -203,7 +203,7 @@ void mock_mm_find_first_free_ExpectAndReturn(uint16_t wanted_csize, mm_chunk_t *
 	mock_push(new);
 }
 
-void mock_mm_chunk_split_ExpectAndReturn(mm_chunk_t *this, uint16_t csize, bool return_null)
+void mock_mm_chunk_split_ExpectAndReturn(mm_chunk_t *this, mm_csize_t csize, bool return_null)
 {
 	mock_call_t *new = unity_malloc(sizeof(mock_call_t));
 	if (new == NULL) {
@@ -231,7 +231,7 @@ void mock_mm_chunk_merge_Expect(mm_chunk_t *this)
 	mock_push(new);
 }
 
-void mock_mm_validate_csize_ExpectAndReturn(uint16_t min_csize, uint32_t csize, bool then_return)
+void mock_mm_validate_csize_ExpectAndReturn(mm_csize_t min_csize, uint32_t csize, bool then_return)
 {
 	mock_call_t *new = unity_malloc(sizeof(mock_call_t));
 	if (new == NULL) {
@@ -30,10 +30,31 @@
 #include "memmgr_conf.h"
 
 /* helpers -------------------------------------------------------------------*/
+/* biggest chunk the big block tests lay out: with wide headers, past the
+ * 15-bit limit of narrow ones yet small enough to be allocated */
+#if MM_CFG_WIDE_HEADER
+#define BIG_CSIZE	((1 << 17) - 1)
+#else
+#define BIG_CSIZE	(CSIZE_MAX)
+#endif
 
 /* functions' prototypes */
 void *			unity_malloc				(size_t size);
 void			unity_free				(void *ptr);
+static void		info_verify				(mm_cinfo_t *expect,
+								 mm_cinfo_t *out,
+								 uint32_t count);
+
+/* field by field, the padding of mm_cinfo_t depends on the header width */
+static void info_verify(mm_cinfo_t *expect, mm_cinfo_t *out, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		TEST_ASSERT_EQUAL_UINT32(expect[i].size, out[i].size);
+		TEST_ASSERT_EQUAL_UINT32(expect[i].csize, out[i].csize);
+		TEST_ASSERT_EQUAL(expect[i].allocated, out[i].allocated);
+		TEST_ASSERT_EQUAL_PTR(expect[i].allocator, out[i].allocator);
+	}
+}
 
 /* variables */
 
@@ -58,8 +79,30 @@ TEST_GROUP_RUNNER(mm_chunk)
 	RUN_TEST_CASE(mm_chunk, split_too_small);
 	
 	RUN_TEST_CASE(mm_chunk, find_first_free);
+	RUN_TEST_CASE(mm_chunk, find_first_free_prefers_smallest_class);
+	RUN_TEST_CASE(mm_chunk, find_first_free_scans_wanted_class);
+	RUN_TEST_CASE(mm_chunk, find_first_free_follows_allocated_set);
+	RUN_TEST_CASE(mm_chunk, find_first_free_after_split_and_merge);
 	
 	RUN_TEST_CASE(mm_chunk, info);
+	RUN_TEST_CASE(mm_chunk, allocator_set_get);
+	RUN_TEST_CASE(mm_chunk, allocator_dropped_by_merge);
+
+	RUN_TEST_CASE(mm_chunk, region_add);
+	RUN_TEST_CASE(mm_chunk, region_add_refuses);
+	RUN_TEST_CASE(mm_chunk, region_merge_stops_at_region_end);
+	RUN_TEST_CASE(mm_chunk, region_split_moves_region_end);
+	RUN_TEST_CASE(mm_chunk, region_gap_is_out_of_bound);
+
+	RUN_TEST_CASE(mm_chunk, zeroed_region_add);
+	RUN_TEST_CASE(mm_chunk, zeroed_kept_by_split);
+	RUN_TEST_CASE(mm_chunk, zeroed_merge_needs_both);
+	RUN_TEST_CASE(mm_chunk, zeroed_dropped_by_free);
+	RUN_TEST_CASE(mm_chunk, zero_marks_free_chunk);
+	RUN_TEST_CASE(mm_chunk, zero_allocated_leads_to_death);
+	RUN_TEST_CASE(mm_chunk, clear_payload);
+	RUN_TEST_CASE(mm_chunk, stats_follow_free_chunks);
+	RUN_TEST_CASE(mm_chunk, stats_largest_found_again);
 
 	RUN_TEST_CASE(mm_chunk, valid_between_included_wanted_csize_and_csize_max);
 	RUN_TEST_CASE(mm_chunk, when_not_available_then_it_should_return_0);
@@ -170,19 +213,25 @@ TEST(mm_chunk, merge_alloc_alloc)
 
 TEST(mm_chunk, merge_bigblocks)
 {
-	mm_chunk_t *gigablock = (mm_chunk_t *)unity_malloc(2*CSIZE_MAX*MM_CFG_ALIGNMENT);
+	mm_chunk_t *gigablock = (mm_chunk_t *)unity_malloc(2*BIG_CSIZE*MM_CFG_ALIGNMENT);
 
 	UT_PTR_SET(g_first, gigablock);
 
-	chunk_test_state_t a_state[] = {{CSIZE_MAX/2, false}, {CSIZE_MAX/2 +1 , false}, {mm_min_csize(), false}};
-	chunk_test_state_t a_expect[] = {{CSIZE_MAX, false}, {mm_min_csize(), false}};
+	chunk_test_state_t a_state[] = {{BIG_CSIZE/2, false}, {BIG_CSIZE/2 +1 , false}, {mm_min_csize(), false}};
+	chunk_test_state_t a_expect[] = {{BIG_CSIZE, false}, {mm_min_csize(), false}};
 	chunk_test_prepare(a_state, 3);
 
 	mm_chunk_merge(g_first);
 	chunk_test_verify(a_expect, 2);
 
 	mm_chunk_merge(g_first);
+#if MM_CFG_WIDE_HEADER
+	chunk_test_state_t a_wide[] = {{BIG_CSIZE + mm_min_csize(), false}};
+	chunk_test_verify(a_wide, 1);
+#else
+	// a merge never goes past CSIZE_MAX
 	chunk_test_verify(a_expect, 2);
+#endif
 
 	unity_free(gigablock);
 }
@@ -230,6 +279,63 @@ TEST(mm_chunk, find_first_free)
 	chunk_test_verify(a_state, 3);
 }
 
+TEST(mm_chunk, find_first_free_prefers_smallest_class)
+{
+	chunk_test_state_t a_state[] = {{128, false}, {64, true}, {32, false}, {32, true}};
+	chunk_test_prepare(a_state, 4);
+
+	mm_chunk_t *expect_ptr = mm_compute_next(g_first, 128 + 64);
+
+	TEST_ASSERT_EQUAL_PTR(expect_ptr, mm_find_first_free(20));
+	TEST_ASSERT_EQUAL_PTR(expect_ptr, mm_find_first_free(32));
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(33));
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(128));
+	TEST_ASSERT_NULL(mm_find_first_free(129));
+
+	chunk_test_verify(a_state, 4);
+}
+
+TEST(mm_chunk, find_first_free_scans_wanted_class)
+{
+	chunk_test_state_t a_state[] = {{70, false}, {64, true}};
+	chunk_test_prepare(a_state, 2);
+
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(65));
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(70));
+	TEST_ASSERT_NULL(mm_find_first_free(71));
+}
+
+TEST(mm_chunk, find_first_free_follows_allocated_set)
+{
+	chunk_test_state_t a_state[] = {{64, false}, {64, false}};
+	chunk_test_prepare(a_state, 2);
+
+	mm_chunk_t *second = mm_chunk_next_get(g_first);
+
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(10));
+	chunk_test_allocated_set(g_first, true);
+	TEST_ASSERT_EQUAL_PTR(second, mm_find_first_free(10));
+	chunk_test_allocated_set(second, true);
+	TEST_ASSERT_NULL(mm_find_first_free(10));
+	chunk_test_allocated_set(g_first, false);
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(10));
+}
+
+TEST(mm_chunk, find_first_free_after_split_and_merge)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+
+	mm_chunk_t *new = mm_chunk_split(g_first, 32);
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(32));
+	TEST_ASSERT_EQUAL_PTR(new, mm_find_first_free(33));
+	TEST_ASSERT_NULL(mm_find_first_free(225));
+
+	mm_chunk_merge(g_first);
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(256));
+	chunk_test_verify(a_state, 1);
+}
+
 TEST(mm_chunk, info)
 {
 	chunk_test_state_t a_state[] = {{64, true}, {64, false}, {128, true}};
@@ -241,11 +347,303 @@ TEST(mm_chunk, info)
 	memset(a_out, 0, sizeof(a_out));
 	
 	mm_chunk_info(a_out, 4);
-	TEST_ASSERT_EQUAL_MEMORY(a_expect, a_out, sizeof(a_expect));
+	info_verify(a_expect, a_out, 4);
 	
 	memset(a_out, 0, sizeof(a_out));
 	mm_chunk_info(a_out, 2);
-	TEST_ASSERT_EQUAL_MEMORY(a_expect_2, a_out, sizeof(a_expect_2));
+	info_verify(a_expect_2, a_out, 4);
+}
+
+TEST(mm_chunk, allocator_set_get)
+{
+	chunk_test_state_t a_state[16];
+	mm_chunk_t *a_chnk[16];
+	for (uint32_t i = 0; i < 16; i++) {
+		a_state[i].size = 16;
+		a_state[i].allocated = true;
+	}
+	chunk_test_prepare(a_state, 16);
+
+	mm_chunk_t *chnk = g_first;
+	for (uint32_t i = 0; i < 16; i++, chnk = mm_chunk_next_get(chnk)) {
+		a_chnk[i] = chnk;
+		mm_chunk_allocator_set(chnk, (void *)(uintptr_t)(0x1000 + i));
+		chnk->xorsum = mm_chunk_xorsum(chnk);
+	}
+	for (uint32_t i = 0; i < 16; i += 2) {
+		mm_chunk_allocator_set(a_chnk[i], NULL);
+		a_chnk[i]->xorsum = mm_chunk_xorsum(a_chnk[i]);
+	}
+	for (uint32_t i = 0; i < 16; i++) {
+		void *expect = (i & 1) ? (void *)(uintptr_t)(0x1000 + i) : NULL;
+		TEST_ASSERT_EQUAL_PTR(expect, mm_chunk_allocator_get(a_chnk[i]));
+	}
+	chunk_test_verify(a_state, 16);
+}
+
+TEST(mm_chunk, allocator_dropped_by_merge)
+{
+	chunk_test_state_t a_state[] = {{128, false}, {128, false}};
+	chunk_test_state_t a_expect[] = {{256, false}};
+	chunk_test_prepare(a_state, 2);
+
+	mm_chunk_t *second = mm_chunk_next_get(g_first);
+	mm_chunk_allocator_set(second, (void *)0x1234);
+	second->xorsum = mm_chunk_xorsum(second);
+	mm_chunk_merge(g_first);
+	chunk_test_verify(a_expect, 1);
+#if MM_CFG_COMPACT_HEADER
+	/* a stale entry would be reported for whatever ends up there */
+	TEST_ASSERT_NULL(mm_chunk_allocator_get(second));
+#endif
+}
+
+TEST(mm_chunk, region_add)
+{
+	chunk_test_state_t a_state[] = {{64, true}, {64, true}};
+	chunk_test_prepare(a_state, 2);
+	mm_chunk_t *second = mm_chunk_next_get(g_first);
+	mm_chunk_t *region = mm_compute_next(g_first, 160);
+
+	TEST_ASSERT_NULL(mm_find_first_free(64));
+	TEST_ASSERT_TRUE(mm_chunk_region_add(region, 96, false));
+	TEST_ASSERT_EQUAL_UINT32(3, mm_chunk_count());
+
+	TEST_ASSERT_NULL(mm_chunk_next_get(second));
+	TEST_ASSERT_EQUAL_PTR(region, mm_chunk_walk_next(second));
+	TEST_ASSERT_NULL(mm_chunk_walk_next(region));
+	TEST_ASSERT_NULL(mm_chunk_prev_get(region));
+	mm_chunk_validate(region);
+	TEST_ASSERT_EQUAL_PTR(region, mm_find_first_free(64));
+}
+
+TEST(mm_chunk, region_add_refuses)
+{
+	chunk_test_state_t a_state[] = {{128, false}};
+	chunk_test_prepare(a_state, 1);
+
+	/* below the first chunk, overlapping, too small, misaligned */
+	TEST_ASSERT_FALSE(mm_chunk_region_add((uint8_t *)g_first - 64, 8, false));
+	TEST_ASSERT_FALSE(mm_chunk_region_add(mm_compute_next(g_first, 64), 96, false));
+	TEST_ASSERT_FALSE(mm_chunk_region_add(mm_compute_next(g_first, 128),
+					      mm_min_csize() - 1, false));
+	TEST_ASSERT_FALSE(mm_chunk_region_add((uint8_t *)mm_compute_next(g_first, 128) + 1, 32, false));
+
+	uint32_t i = 1;
+	for (; i < MM_CFG_REGION_COUNT; i++) {
+		TEST_ASSERT_TRUE(mm_chunk_region_add(mm_compute_next(g_first, 128 + (i - 1) * 32), 32, false));
+	}
+	/* no region left */
+	TEST_ASSERT_FALSE(mm_chunk_region_add(mm_compute_next(g_first, 128 + (i - 1) * 32), 32, false));
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_REGION_COUNT, mm_chunk_count());
+}
+
+TEST(mm_chunk, region_merge_stops_at_region_end)
+{
+	chunk_test_state_t a_state[] = {{128, false}};
+	chunk_test_prepare(a_state, 1);
+	/* right after the first region, still a region of its own */
+	mm_chunk_t *region = mm_compute_next(g_first, 128);
+	TEST_ASSERT_TRUE(mm_chunk_region_add(region, 64, false));
+
+	mm_chunk_merge(g_first);
+	TEST_ASSERT_EQUAL_UINT32(2, mm_chunk_count());
+	TEST_ASSERT_EQUAL_UINT16(128, g_first->csize);
+	TEST_ASSERT_EQUAL_UINT16(64, region->csize);
+}
+
+TEST(mm_chunk, region_split_moves_region_end)
+{
+	chunk_test_state_t a_state[] = {{64, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_chunk_t *region = mm_compute_next(g_first, 96);
+	TEST_ASSERT_TRUE(mm_chunk_region_add(region, 128, false));
+
+	/* ends of both regions move */
+	mm_chunk_t *tail = mm_chunk_split(g_first, 32);
+	mm_chunk_t *region_tail = mm_chunk_split(region, 64);
+	TEST_ASSERT_NULL(mm_chunk_next_get(tail));
+	TEST_ASSERT_EQUAL_PTR(region, mm_chunk_walk_next(tail));
+	TEST_ASSERT_NULL(mm_chunk_walk_next(region_tail));
+
+	/* and come back */
+	mm_chunk_merge(region);
+	mm_chunk_merge(g_first);
+	TEST_ASSERT_EQUAL_UINT32(2, mm_chunk_count());
+	TEST_ASSERT_EQUAL_PTR(region, mm_chunk_walk_next(g_first));
+	TEST_ASSERT_NULL(mm_chunk_walk_next(region));
+}
+
+TEST(mm_chunk, region_gap_is_out_of_bound)
+{
+	chunk_test_state_t a_state[] = {{64, false}};
+	chunk_test_prepare(a_state, 1);
+	TEST_ASSERT_TRUE(mm_chunk_region_add(mm_compute_next(g_first, 128), 64, false));
+
+	mm_chunk_t *gap = mm_compute_next(g_first, 64);
+	mm_chunk_init(gap, NULL, 32);
+	EXPECT_ABORT_BEGIN
+	mm_chunk_validate(gap);
+	VERIFY_FAILS_END("MM: out of bound");
+}
+
+TEST(mm_chunk, zeroed_region_add)
+{
+	chunk_test_state_t a_state[] = {{64, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_chunk_t *dirty = mm_compute_next(g_first, 64);
+	mm_chunk_t *zeroed = mm_compute_next(g_first, 128);
+	memset(zeroed, 0, 64 * MM_CFG_ALIGNMENT);
+
+	TEST_ASSERT_TRUE(mm_chunk_region_add(dirty, 64, false));
+	TEST_ASSERT_TRUE(mm_chunk_region_add(zeroed, 64, true));
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(g_first));
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(dirty));
+	TEST_ASSERT_TRUE(mm_chunk_zeroed_get(zeroed));
+	mm_chunk_validate(zeroed);
+}
+
+TEST(mm_chunk, zeroed_kept_by_split)
+{
+	chunk_test_state_t a_state[] = {{64, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_chunk_t *region = mm_compute_next(g_first, 64);
+	memset(region, 0, 128 * MM_CFG_ALIGNMENT);
+	TEST_ASSERT_TRUE(mm_chunk_region_add(region, 128, true));
+
+	mm_chunk_t *tail = mm_chunk_split(region, 32);
+	TEST_ASSERT_NOT_NULL(tail);
+	TEST_ASSERT_TRUE(mm_chunk_zeroed_get(region));
+	TEST_ASSERT_TRUE(mm_chunk_zeroed_get(tail));
+
+	mm_chunk_allocated_set(region, true);
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(region));
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(mm_chunk_split(region, 16)));
+}
+
+TEST(mm_chunk, zeroed_merge_needs_both)
+{
+	chunk_test_state_t a_state[] = {{64, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_chunk_t *region = mm_compute_next(g_first, 64);
+	memset(region, 0, 128 * MM_CFG_ALIGNMENT);
+	TEST_ASSERT_TRUE(mm_chunk_region_add(region, 128, true));
+	mm_chunk_t *mid = mm_chunk_split(region, 32);
+	mm_chunk_t *tail = mm_chunk_split(mid, 32);
+
+	mm_chunk_merge(region);
+	TEST_ASSERT_EQUAL_UINT16(64, region->csize);
+	TEST_ASSERT_TRUE(mm_chunk_zeroed_get(region));
+
+	// a dirty neighbour
+	mm_chunk_allocated_set(tail, true);
+	mm_chunk_allocated_set(tail, false);
+	mm_chunk_merge(region);
+	TEST_ASSERT_EQUAL_UINT16(128, region->csize);
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(region));
+}
+
+TEST(mm_chunk, zeroed_dropped_by_free)
+{
+	chunk_test_state_t a_state[] = {{64, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_chunk_t *region = mm_compute_next(g_first, 64);
+	memset(region, 0, 64 * MM_CFG_ALIGNMENT);
+	TEST_ASSERT_TRUE(mm_chunk_region_add(region, 64, true));
+
+	mm_chunk_allocated_set(region, true);
+	mm_chunk_allocated_set(region, false);
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(region));
+}
+
+TEST(mm_chunk, zero_marks_free_chunk)
+{
+	chunk_test_state_t a_state[] = {{64, false}, {64, true}};
+	chunk_test_prepare(a_state, 2);
+
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(g_first));
+	mm_chunk_zero(g_first);
+	TEST_ASSERT_TRUE(mm_chunk_zeroed_get(g_first));
+	mm_chunk_validate(g_first);
+	TEST_ASSERT_EQUAL_PTR(g_first, mm_find_first_free(32));
+}
+
+TEST(mm_chunk, zero_allocated_leads_to_death)
+{
+	chunk_test_state_t a_state[] = {{64, true}};
+	chunk_test_prepare(a_state, 1);
+
+	EXPECT_ABORT_BEGIN
+	mm_chunk_zero(g_first);
+	VERIFY_FAILS_END("MM: zero allocated");
+}
+
+TEST(mm_chunk, clear_payload)
+{
+	chunk_test_state_t a_state[] = {{64, false}, {64, false}};
+	chunk_test_prepare(a_state, 2);
+	mm_chunk_t *second = mm_chunk_next_get(g_first);
+	uint32_t size = (64 - mm_header_csize() - MM_GUARD_CSIZE) * MM_CFG_ALIGNMENT;
+
+	mm_chunk_zero(second);
+	mm_chunk_allocated_set(g_first, true);
+	mm_chunk_allocated_set(second, true);
+	memset(mm_toptr(g_first), 0xAA, size);
+
+	mm_chunk_clear(g_first, size, false);
+	mm_chunk_clear(second, size, true);
+	for (uint32_t i = 0; i < size; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, ((uint8_t *)mm_toptr(g_first))[i]);
+		TEST_ASSERT_EQUAL_UINT8(0, ((uint8_t *)mm_toptr(second))[i]);
+	}
+}
+
+TEST(mm_chunk, stats_follow_free_chunks)
+{
+	chunk_test_state_t a_state[] = {{64, false}, {128, true}, {32, false}};
+	chunk_test_prepare(a_state, 3);
+	mm_chunk_stats_t *stats = &mm_chunk_ctx_get()->stats;
+	mm_chunk_t *second = mm_chunk_next_get(g_first);
+
+	TEST_ASSERT_EQUAL_UINT32(224, stats->total_csize);
+	TEST_ASSERT_EQUAL_UINT32(96, stats->free_csize);
+	TEST_ASSERT_EQUAL_UINT32(2, stats->free_count);
+	TEST_ASSERT_EQUAL_UINT32(64, stats->largest_csize);
+	TEST_ASSERT_EQUAL_UINT32(128, stats->peak_used_csize);
+
+	mm_chunk_t *rest = mm_chunk_split(g_first, 16);
+	chunk_test_allocated_set(g_first, true);
+	TEST_ASSERT_EQUAL_UINT32(80, stats->free_csize);
+	TEST_ASSERT_EQUAL_UINT32(2, stats->free_count);
+	TEST_ASSERT_EQUAL_UINT32(48, stats->largest_csize);
+	TEST_ASSERT_EQUAL_UINT32(144, stats->peak_used_csize);
+
+	chunk_test_allocated_set(second, false);
+	mm_chunk_merge(rest);
+	mm_chunk_validate(rest);
+	TEST_ASSERT_EQUAL_UINT32(208, stats->free_csize);
+	TEST_ASSERT_EQUAL_UINT32(2, stats->free_count);
+	TEST_ASSERT_EQUAL_UINT32(176, stats->largest_csize);
+	TEST_ASSERT_EQUAL_UINT32(144, stats->peak_used_csize);
+	TEST_ASSERT_EQUAL_UINT32(224, stats->total_csize);
+}
+
+TEST(mm_chunk, stats_largest_found_again)
+{
+	chunk_test_state_t a_state[] = {{40, false}, {40, true}, {24, false},
+					{40, true}, {32, false}};
+	chunk_test_prepare(a_state, 5);
+	mm_chunk_stats_t *stats = &mm_chunk_ctx_get()->stats;
+
+	chunk_test_allocated_set(g_first, true);
+	TEST_ASSERT_EQUAL_UINT32(32, stats->largest_csize);
+
+	// the region still lies in the test heap
+	mm_chunk_t *region = mm_compute_next(g_first, 176);
+	TEST_ASSERT_TRUE(mm_chunk_region_add(region, 64, false));
+	TEST_ASSERT_EQUAL_UINT32(240, stats->total_csize);
+	TEST_ASSERT_EQUAL_UINT32(64, stats->largest_csize);
+	TEST_ASSERT_EQUAL_UINT32(3, stats->free_count);
 }
 
 TEST(mm_chunk, valid_between_included_wanted_csize_and_csize_max)
@@ -258,11 +656,11 @@ TEST(mm_chunk, valid_between_included_wanted_csize_and_csize_max)
 	TEST_ASSERT_TRUE(mm_validate_csize(10, CSIZE_MAX));
 
 	TEST_ASSERT_FALSE(mm_validate_csize(10, CSIZE_MAX + 1));
-	TEST_ASSERT_FALSE(mm_validate_csize(10, CSIZE_MAX * CSIZE_MAX));
+	TEST_ASSERT_FALSE(mm_validate_csize(10, (CSIZE_MAX << 1) | 1));
 
 	TEST_ASSERT_TRUE(mm_validate_csize(CSIZE_MAX, CSIZE_MAX));
 	TEST_ASSERT_FALSE(mm_validate_csize(CSIZE_MAX, 10));
-	TEST_ASSERT_FALSE(mm_validate_csize(CSIZE_MAX, CSIZE_MAX * CSIZE_MAX));
+	TEST_ASSERT_FALSE(mm_validate_csize(CSIZE_MAX, (CSIZE_MAX << 1) | 1));
 }
 
 TEST(mm_chunk, when_not_available_then_it_should_return_0)
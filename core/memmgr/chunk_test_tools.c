@@ -21,6 +21,9 @@
 #include "common/common.h"
 #include "unity_fixture.h"
 #include "tests/chunk_test_tools.h"
+#include "memmgr/cache.h"
+#include "memmgr/slab.h"
+#include "os/task.h"
 #include "memmgr_conf.h"
 
 /* Variables -----------------------------------------------------------------*/
@@ -33,17 +36,31 @@ void chunk_test_prepare(chunk_test_state_t *array, uint32_t array_len)
 {
 	mm_chunk_t *prev =  NULL;
 	mm_chunk_t *chnk = g_first;
+	// what the running task cached and the slabs lived in the replaced heap
+#if MM_CFG_TASK_CACHE
+	if (task_mm_cache_get() != NULL) {
+		mm_cache_init(task_mm_cache_get());
+	}
+#endif
+	mm_slab_forget_all();
+
 	for (uint32_t i = 0; i < array_len; i++)
 	{
-		uint16_t csize = array[i].size;
+		mm_csize_t csize = array[i].size;
 
 		mm_chunk_init(chnk, prev, csize);
-		chunk_test_allocated_set(chnk, array[i].allocated);
 
 		prev = chnk;
 		chnk = mm_compute_next(chnk, csize);
 	}
 	mm_chunk_boundary_set(g_first, prev, array_len);
+
+	chnk = g_first;
+	for (uint32_t i = 0; i < array_len; i++)
+	{
+		chunk_test_allocated_set(chnk, array[i].allocated);
+		chnk = mm_compute_next(chnk, chnk->csize);
+	}
 }
 
 void chunk_test_verify(chunk_test_state_t *array, uint32_t array_len)
@@ -55,7 +72,7 @@ void chunk_test_verify(chunk_test_state_t *array, uint32_t array_len)
 	mm_chunk_validate(chnk);
 	for (i = 0; (i < array_len) && (chnk != NULL); i++, chnk = mm_chunk_next_get(chnk))
 	{
-		TEST_ASSERT_EQUAL_UINT16(array[i].size, chnk->csize);
+		TEST_ASSERT_EQUAL_UINT32(array[i].size, chnk->csize);
 		TEST_ASSERT_EQUAL_STRING(bool_to_string(array[i].allocated), bool_to_string(chnk->allocated));
 	}
 	TEST_ASSERT_NULL_MESSAGE(chnk, "more chunk than expected");
@@ -64,13 +81,13 @@ void chunk_test_verify(chunk_test_state_t *array, uint32_t array_len)
 
 void chunk_test_allocated_set(mm_chunk_t *this, bool val)
 {
-	this->allocated = val;
+	mm_chunk_allocated_set(this, val);
 	this->xorsum = mm_chunk_xorsum(this);
 }
 
 uint32_t chunk_test_fill_with_prepare(mm_chunk_t *this, char val)
 {
-	uint32_t payload_size = mm_guard_size(this) - (MM_CFG_GUARD_SIZE*MM_CFG_ALIGNMENT);
+	uint32_t payload_size = mm_guard_size(this) - (MM_GUARD_CSIZE*MM_CFG_ALIGNMENT);
 
 	mm_chunk_guard_set(this, payload_size);
 	this->xorsum = mm_chunk_xorsum(this);
@@ -37,9 +37,11 @@ static mm_chunk_t *gs_chnk = (mm_chunk_t *)gs_raw;
 /* functions's definitions */
 static void eval_validate_xorsum(void)
 {
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CHECKSUM
 	EXPECT_ABORT_BEGIN
 	mm_chunk_validate(gs_chnk);
 	VERIFY_FAILS_END("MM: xorsum");
+#endif
 }
 
 /* Test group definitions ----------------------------------------------------*/
@@ -50,12 +52,17 @@ TEST_GROUP_RUNNER(mm_chunk_validate)
 	RUN_TEST_CASE(mm_chunk_validate, validate_alignment);
 	RUN_TEST_CASE(mm_chunk_validate, validate_out_of_bound);
 	RUN_TEST_CASE(mm_chunk_validate, validate_overflow);
+	RUN_TEST_CASE(mm_chunk_validate, validate_overflow_tail);
 	RUN_TEST_CASE(mm_chunk_validate, validate_corruption_prev_size);
 	RUN_TEST_CASE(mm_chunk_validate, validate_corruption_allocated);
 	RUN_TEST_CASE(mm_chunk_validate, validate_corruption_xorsum);
 	RUN_TEST_CASE(mm_chunk_validate, validate_corruption_size);
 	RUN_TEST_CASE(mm_chunk_validate, validate_corruption_guard_offset);
 	RUN_TEST_CASE(mm_chunk_validate, validate_corruption_allocator);
+	RUN_TEST_CASE(mm_chunk_validate, validate_corruption_double_bit);
+	RUN_TEST_CASE(mm_chunk_validate, guard_catches_every_byte);
+	RUN_TEST_CASE(mm_chunk_validate, crc32c_check_value);
+	RUN_TEST_CASE(mm_chunk_validate, crc32c_any_alignment);
 }
 TEST_SETUP(mm_chunk_validate)
 {
@@ -93,10 +100,27 @@ TEST(mm_chunk_validate, validate_out_of_bound)
 
 TEST(mm_chunk_validate, validate_overflow)
 {
-	EXPECT_ABORT_BEGIN
 	memset(mm_toptr(gs_chnk), 0, 1);
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CANARY
+	EXPECT_ABORT_BEGIN
+	mm_chunk_validate(gs_chnk);
+	VERIFY_FAILS_END("MM: overflowed");
+#else
+	mm_chunk_validate(gs_chnk);
+#endif
+}
+
+TEST(mm_chunk_validate, validate_overflow_tail)
+{
+	uint8_t *tail = mm_toptr(gs_chnk) + MM_CFG_GUARD_SIZE*MM_CFG_ALIGNMENT;
+	tail[0] = 0;
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_FULL
+	EXPECT_ABORT_BEGIN
 	mm_chunk_validate(gs_chnk);
 	VERIFY_FAILS_END("MM: overflowed");
+#else
+	mm_chunk_validate(gs_chnk);
+#endif
 }
 
 TEST(mm_chunk_validate, validate_corruption_prev_size)
@@ -131,7 +155,64 @@ TEST(mm_chunk_validate, validate_corruption_guard_offset)
 
 TEST(mm_chunk_validate, validate_corruption_allocator)
 {
+#if !MM_CFG_COMPACT_HEADER
 	gs_chnk->allocator = __builtin_return_address(0);
 	eval_validate_xorsum();
+#endif
 }
 
+TEST(mm_chunk_validate, validate_corruption_double_bit)
+{
+	/* the same bit flipped in two sizes cancels out in a xor */
+	gs_chnk->prev_size ^= 1;
+	gs_chnk->csize ^= 1;
+#if MM_CFG_CRC32C || (MM_CFG_INTEGRITY < MM_INTEGRITY_CHECKSUM)
+	eval_validate_xorsum();
+#else
+	mm_chunk_validate(gs_chnk);
+#endif
+}
+
+TEST(mm_chunk_validate, guard_catches_every_byte)
+{
+	mm_chunk_guard_set(gs_chnk, 3);
+	uint8_t *guard = mm_toptr(gs_chnk) + 3;
+	uint32_t span = 0;
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_FULL
+	span = mm_guard_size(gs_chnk) - 2*sizeof(uint32_t);
+#elif MM_CFG_INTEGRITY >= MM_INTEGRITY_CANARY
+	span = MM_CFG_GUARD_SIZE*MM_CFG_ALIGNMENT;
+#endif
+
+	TEST_ASSERT_TRUE(mm_chunk_guard_get(gs_chnk));
+	for (uint32_t i = 0; i < span; i++) {
+		uint8_t saved = guard[i];
+		guard[i] ^= 0x80;
+		TEST_ASSERT_FALSE(mm_chunk_guard_get(gs_chnk));
+		guard[i] = saved;
+	}
+	TEST_ASSERT_TRUE(mm_chunk_guard_get(gs_chnk));
+}
+
+TEST(mm_chunk_validate, crc32c_check_value)
+{
+	TEST_ASSERT_EQUAL_UINT32(0xE3069283, mm_crc32c("123456789", 9));
+	TEST_ASSERT_EQUAL_UINT32(0, mm_crc32c(NULL, 0));
+}
+
+TEST(mm_chunk_validate, crc32c_any_alignment)
+{
+	uint32_t ref[16];
+	uint8_t buf[sizeof(ref) + 8];
+	for (uint32_t i = 0; i < 16; i++) {
+		ref[i] = i * 0x01030507;
+	}
+
+	for (uint32_t len = 0; len <= sizeof(ref); len++) {
+		uint32_t expect = mm_crc32c(ref, len);
+		for (uint32_t shift = 1; shift < 8; shift++) {
+			memcpy(buf + shift, ref, len);
+			TEST_ASSERT_EQUAL_UINT32(expect, mm_crc32c(buf + shift, len));
+		}
+	}
+}
@@ -0,0 +1,227 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "memmgr/chunk.h"
+#include "memmgr/handle.h"
+#include "memmgr/heap.h"
+
+#include "memmgr_conf.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+/* room ahead of the payload for the back pointer to the handle */
+#define MM_HANDLE_PREFIX \
+		((sizeof(mm_handle_t *) + MM_CFG_ALIGNMENT - 1) & ~(MM_CFG_ALIGNMENT - 1))
+
+/* Types ---------------------------------------------------------------------*/
+struct mm_handle
+{
+	/* NULL while the handle is unused */
+	mm_heap_t	*heap;
+	/* payload of the chunk, starting with the back pointer */
+	uint8_t		*block;
+	uint32_t	locks;
+};
+
+/* Prototypes ----------------------------------------------------------------*/
+static mm_handle_t *	mm_handle_claim		(mm_heap_t *heap);
+static void		mm_handle_release	(mm_handle_t *this);
+static mm_handle_t *	mm_handle_of		(mm_chunk_t *chnk);
+static bool		mm_handle_slide		(mm_handle_t *this,
+						 mm_chunk_t *hole);
+
+/* Variables -----------------------------------------------------------------*/
+static mm_handle_t	gs_handles[MM_CFG_HANDLE_COUNT];
+
+/* Private functions definitions ---------------------------------------------*/
+static mm_handle_t *mm_handle_claim(mm_heap_t *heap)
+{
+	for (uint32_t i = 0; i < MM_CFG_HANDLE_COUNT; i++) {
+		mm_heap_t *expected = NULL;
+		if (__atomic_compare_exchange_n(&gs_handles[i].heap, &expected, heap,
+						false, __ATOMIC_ACQUIRE,
+						__ATOMIC_RELAXED)) {
+			return &gs_handles[i];
+		}
+	}
+	return NULL;
+}
+
+static void mm_handle_release(mm_handle_t *this)
+{
+	this->block = NULL;
+	this->locks = 0;
+	__atomic_store_n(&this->heap, NULL, __ATOMIC_RELEASE);
+}
+
+/* handle owning an allocated chunk, NULL for plain allocations */
+static mm_handle_t *mm_handle_of(mm_chunk_t *chnk)
+{
+	if ((chnk == NULL) || !chnk->allocated ||
+	    (chnk->guard_offset < MM_HANDLE_PREFIX)) {
+		return NULL;
+	}
+
+	mm_handle_t *handle = NULL;
+	uint8_t *block = mm_toptr(chnk);
+	memcpy(&handle, block, sizeof(handle));
+
+	uintptr_t offset = (uintptr_t)handle - (uintptr_t)gs_handles;
+	if ((offset >= sizeof(gs_handles)) || ((offset % sizeof(mm_handle_t)) != 0)) {
+		return NULL;
+	}
+	// any payload may look like a back pointer, the handle must agree
+	if (handle->block != block) {
+		return NULL;
+	}
+	return handle;
+}
+
+/* move the block of a handle down into the free chunk right before it */
+static bool mm_handle_slide(mm_handle_t *this, mm_chunk_t *hole)
+{
+	mm_chunk_t *chnk = mm_tochunk(this->block);
+	mm_csize_t csize = chnk->csize;
+	uint32_t size = chnk->guard_offset;
+	void *lr = mm_chunk_allocator_get(chnk);
+
+	mm_chunk_merge(hole);
+	if (!hole->allocated) {
+		// both would not fit in a single chunk
+		return false;
+	}
+	this->block = mm_toptr(hole);
+
+	mm_chunk_t *tail = mm_chunk_split(hole, csize);
+	if (tail != NULL) {
+		mm_chunk_t *next = mm_chunk_next_get(tail);
+		if (mm_chunk_is_available(next)) {
+			mm_chunk_merge(tail);
+		}
+	}
+
+	mm_chunk_guard_set(hole, size);
+	mm_chunk_allocator_set(hole, lr);
+	hole->xorsum = mm_chunk_xorsum(hole);
+	return true;
+}
+
+/* Functions definitions -----------------------------------------------------*/
+mm_handle_t *mm_halloc(uint32_t size)
+{
+	return mm_heap_halloc(mm_heap_default(), size);
+}
+
+mm_handle_t *mm_heap_halloc(mm_heap_t *heap, uint32_t size)
+{
+	if (size == 0) {
+		return NULL;
+	}
+	if (heap == NULL) {
+		heap = mm_heap_default();
+	}
+	mm_handle_t *this = mm_handle_claim(heap);
+	if (this == NULL) {
+		return NULL;
+	}
+
+	// the lock keeps mm_compact away until the back pointer is set
+	mm_heap_lock(heap);
+	uint8_t *block = mm_heap_alloc_uncached(heap, MM_HANDLE_PREFIX + size,
+						__builtin_return_address(0));
+	if (block != NULL) {
+		memcpy(block, &this, sizeof(this));
+		this->block = block;
+		this->locks = 0;
+	}
+	mm_heap_unlock(heap);
+
+	if (block == NULL) {
+		mm_handle_release(this);
+		return NULL;
+	}
+	return this;
+}
+
+void *mm_hlock(mm_handle_t *this)
+{
+	mm_heap_lock(this->heap);
+	this->locks ++;
+	void *ptr = this->block + MM_HANDLE_PREFIX;
+	mm_heap_unlock(this->heap);
+	return ptr;
+}
+
+void mm_hunlock(mm_handle_t *this)
+{
+	mm_heap_lock(this->heap);
+	if (this->locks == 0) {
+		die("MM: handle not locked");
+	}
+	this->locks --;
+	mm_heap_unlock(this->heap);
+}
+
+void mm_hfree(mm_handle_t *this)
+{
+	if (this == NULL) {
+		return;
+	}
+	mm_heap_t *heap = this->heap;
+	mm_heap_lock(heap);
+	mm_heap_free_uncached(heap, this->block);
+	mm_handle_release(this);
+	mm_heap_unlock(heap);
+}
+
+uint32_t mm_compact(mm_heap_t *heap)
+{
+	mm_csize_t largest = 0;
+	if (heap == NULL) {
+		heap = mm_heap_default();
+	}
+
+	mm_heap_lock(heap);
+	mm_heap_remote_drain(heap);
+	mm_chunk_t *chnk = mm_chunk_ctx_get()->boundary.first;
+	while (chnk != NULL) {
+		mm_chunk_validate(chnk);
+		if (!chnk->allocated) {
+			// blocks only slide within their region
+			mm_handle_t *handle = mm_handle_of(mm_chunk_next_get(chnk));
+			if ((handle != NULL) && (handle->locks == 0) &&
+			    mm_handle_slide(handle, chnk)) {
+				// chnk now holds the block, the hole moved after it
+				chnk = mm_chunk_next_get(chnk);
+				continue;
+			}
+			largest = umax(largest, chnk->csize);
+		}
+		chnk = mm_chunk_walk_next(chnk);
+	}
+	mm_heap_unlock(heap);
+
+	if (largest < mm_header_csize() + MM_GUARD_CSIZE) {
+		return 0;
+	}
+	return (largest - mm_header_csize() - MM_GUARD_CSIZE) * MM_CFG_ALIGNMENT;
+}
@@ -0,0 +1,240 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/memmgr_unity.h"
+#include "memmgr/chunk.h"
+#include "memmgr/handle.h"
+#include "memmgr/heap.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			HEAP_SIZE		(8192)
+#define			BLOCK_SIZE		(64)
+
+static uint8_t gs_buf[HEAP_SIZE] __attribute__((aligned(8)));
+static mm_heap_t *gs_heap = NULL;
+static mm_handle_t *gs_handles[MM_CFG_HANDLE_COUNT];
+
+static mm_handle_t *	handle_new		(char fill);
+static void		handle_verify		(mm_handle_t *handle,
+						 char fill);
+static uint32_t		heap_chunk_count	(void);
+
+static mm_handle_t *handle_new(char fill)
+{
+	mm_handle_t *handle = mm_heap_halloc(gs_heap, BLOCK_SIZE);
+	TEST_ASSERT_NOT_NULL(handle);
+	memset(mm_hlock(handle), fill, BLOCK_SIZE);
+	mm_hunlock(handle);
+	return handle;
+}
+
+static void handle_verify(mm_handle_t *handle, char fill)
+{
+	uint8_t *ptr = mm_hlock(handle);
+	for (uint32_t i = 0; i < BLOCK_SIZE; i++) {
+		TEST_ASSERT_EQUAL_UINT8_MESSAGE(fill, ptr[i], "Data has beed lost");
+	}
+	mm_hunlock(handle);
+}
+
+static uint32_t heap_chunk_count(void)
+{
+	mm_heap_lock(gs_heap);
+	uint32_t count = mm_chunk_count();
+	mm_heap_unlock(gs_heap);
+	return count;
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_handle);
+
+TEST_GROUP_RUNNER(mm_handle)
+{
+	RUN_TEST_CASE(mm_handle, halloc_zero_returns_null);
+	RUN_TEST_CASE(mm_handle, halloc_fails_if_heap_is_exhausted);
+	RUN_TEST_CASE(mm_handle, halloc_fails_if_handles_are_exhausted);
+	RUN_TEST_CASE(mm_handle, hlock_nests);
+	RUN_TEST_CASE(mm_handle, hunlock_unlocked_leads_to_death);
+	RUN_TEST_CASE(mm_handle, hfree_releases_the_block);
+	RUN_TEST_CASE(mm_handle, compact_slides_unlocked_blocks);
+	RUN_TEST_CASE(mm_handle, compact_keeps_locked_blocks);
+	RUN_TEST_CASE(mm_handle, compact_keeps_plain_blocks);
+	RUN_TEST_CASE(mm_handle, compact_joins_free_space);
+}
+
+TEST_SETUP(mm_handle)
+{
+	unity_mock_setup();
+	gs_heap = mm_heap_init(gs_buf, HEAP_SIZE);
+	TEST_ASSERT_NOT_NULL(gs_heap);
+	memset(gs_handles, 0, sizeof(gs_handles));
+}
+
+TEST_TEAR_DOWN(mm_handle)
+{
+	for (uint32_t i = 0; i < MM_CFG_HANDLE_COUNT; i++) {
+		mm_hfree(gs_handles[i]);
+	}
+	mm_heap_release(gs_heap);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_handle, halloc_zero_returns_null)
+{
+	TEST_ASSERT_NULL(mm_heap_halloc(gs_heap, 0));
+}
+
+TEST(mm_handle, halloc_fails_if_heap_is_exhausted)
+{
+	TEST_ASSERT_NULL(mm_heap_halloc(gs_heap, HEAP_SIZE));
+	/* the handle went back to the table */
+	gs_handles[0] = mm_heap_halloc(gs_heap, BLOCK_SIZE);
+	TEST_ASSERT_NOT_NULL(gs_handles[0]);
+}
+
+TEST(mm_handle, halloc_fails_if_handles_are_exhausted)
+{
+	for (uint32_t i = 0; i < MM_CFG_HANDLE_COUNT; i++) {
+		gs_handles[i] = mm_heap_halloc(gs_heap, 4);
+		TEST_ASSERT_NOT_NULL(gs_handles[i]);
+	}
+	TEST_ASSERT_NULL(mm_heap_halloc(gs_heap, 4));
+}
+
+TEST(mm_handle, hlock_nests)
+{
+	gs_handles[0] = handle_new('A');
+	uint8_t *ptr = mm_hlock(gs_handles[0]);
+	TEST_ASSERT_EQUAL_PTR(ptr, mm_hlock(gs_handles[0]));
+	mm_hunlock(gs_handles[0]);
+	mm_hunlock(gs_handles[0]);
+	handle_verify(gs_handles[0], 'A');
+}
+
+TEST(mm_handle, hunlock_unlocked_leads_to_death)
+{
+	gs_handles[0] = handle_new('A');
+
+	EXPECT_ABORT_BEGIN
+	mm_hunlock(gs_handles[0]);
+	VERIFY_FAILS_END("MM: handle not locked");
+
+	/* die() left gs_heap locked */
+	mm_heap_unlock(gs_heap);
+}
+
+TEST(mm_handle, hfree_releases_the_block)
+{
+	uint32_t count = heap_chunk_count();
+	mm_handle_t *handle = handle_new('A');
+	TEST_ASSERT_EQUAL_UINT32(count + 1, heap_chunk_count());
+
+	mm_hfree(handle);
+	TEST_ASSERT_EQUAL_UINT32(count, heap_chunk_count());
+	mm_hfree(NULL);
+}
+
+TEST(mm_handle, compact_slides_unlocked_blocks)
+{
+	gs_handles[0] = handle_new('A');
+	mm_handle_t *b = handle_new('B');
+	gs_handles[2] = handle_new('C');
+	uint8_t *hole = mm_hlock(b);
+	mm_hunlock(b);
+	mm_hfree(b);
+	TEST_ASSERT_EQUAL_UINT32(4, heap_chunk_count());
+
+	mm_compact(gs_heap);
+	TEST_ASSERT_EQUAL_UINT32(3, heap_chunk_count());
+	TEST_ASSERT_EQUAL_PTR(hole, mm_hlock(gs_handles[2]));
+	mm_hunlock(gs_handles[2]);
+	handle_verify(gs_handles[0], 'A');
+	handle_verify(gs_handles[2], 'C');
+	mm_heap_check(gs_heap);
+}
+
+TEST(mm_handle, compact_keeps_locked_blocks)
+{
+	gs_handles[0] = handle_new('A');
+	mm_handle_t *b = handle_new('B');
+	gs_handles[2] = handle_new('C');
+	mm_hfree(b);
+
+	uint8_t *ptr = mm_hlock(gs_handles[2]);
+	mm_compact(gs_heap);
+	TEST_ASSERT_EQUAL_UINT32(4, heap_chunk_count());
+	TEST_ASSERT_EQUAL_PTR(ptr, mm_hlock(gs_handles[2]));
+	mm_hunlock(gs_handles[2]);
+	mm_hunlock(gs_handles[2]);
+	handle_verify(gs_handles[2], 'C');
+}
+
+TEST(mm_handle, compact_keeps_plain_blocks)
+{
+	gs_handles[0] = handle_new('A');
+	mm_handle_t *b = handle_new('B');
+	uint8_t *plain = mm_heap_alloc(gs_heap, BLOCK_SIZE);
+	memset(plain, 'P', BLOCK_SIZE);
+	mm_hfree(b);
+
+	mm_compact(gs_heap);
+	TEST_ASSERT_EQUAL_UINT32(4, heap_chunk_count());
+	for (uint32_t i = 0; i < BLOCK_SIZE; i++) {
+		TEST_ASSERT_EQUAL_UINT8('P', plain[i]);
+	}
+	mm_heap_free(gs_heap, plain);
+}
+
+TEST(mm_handle, compact_joins_free_space)
+{
+	const uint32_t size = HEAP_SIZE / 16;
+	uint32_t n = 0;
+	mm_handle_t *handle = NULL;
+	while ((n < MM_CFG_HANDLE_COUNT) &&
+	       ((handle = mm_heap_halloc(gs_heap, size)) != NULL)) {
+		memset(mm_hlock(handle), 'a' + n, size);
+		mm_hunlock(handle);
+		gs_handles[n++] = handle;
+	}
+	for (uint32_t i = 0; i < n; i += 2) {
+		mm_hfree(gs_handles[i]);
+		gs_handles[i] = NULL;
+	}
+	/* half the heap is free, in slivers */
+	TEST_ASSERT_NULL(mm_heap_alloc(gs_heap, 2 * size));
+
+	uint32_t largest = mm_compact(gs_heap);
+	TEST_ASSERT_TRUE(largest >= (n / 2) * size);
+	void *ptr = mm_heap_alloc(gs_heap, largest);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_NULL(mm_heap_alloc(gs_heap, 1));
+
+	for (uint32_t i = 1; i < n; i += 2) {
+		uint8_t *data = mm_hlock(gs_handles[i]);
+		for (uint32_t j = 0; j < size; j++) {
+			TEST_ASSERT_EQUAL_UINT8('a' + i, data[j]);
+		}
+		mm_hunlock(gs_handles[i]);
+	}
+	mm_heap_free(gs_heap, ptr);
+	mm_heap_check(gs_heap);
+}
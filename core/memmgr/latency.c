@@ -0,0 +1,130 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "os/system.h"
+#include "os/task.h"
+#include "memmgr/heap.h"
+#include "memmgr/latency.h"
+
+#include "memmgr_conf.h"
+
+#if MM_CFG_LATENCY
+/*
+ * Counters are only touched with relaxed atomics, nothing waits on a reader.
+ * The fields of a copy may disagree by the operations that raced with it,
+ * resetting reads still hand each of them out exactly once per field.
+ */
+
+/* Macro definitions ---------------------------------------------------------*/
+/* UINT32_MAX falls in the last possible bucket */
+#if MM_CFG_LATENCY_BUCKETS > ((33 - MM_LATENCY_SUB_BITS) << MM_LATENCY_SUB_BITS)
+#error "MM_CFG_LATENCY_BUCKETS is above the bucket of the longest duration"
+#endif
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint32_t		mm_latency_take		(uint32_t *field,
+						 bool reset);
+
+/* Private functions definitions ---------------------------------------------*/
+static uint32_t mm_latency_take(uint32_t *field, bool reset)
+{
+	if (reset) {
+		return __atomic_exchange_n(field, 0, __ATOMIC_RELAXED);
+	}
+	return __atomic_load_n(field, __ATOMIC_RELAXED);
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_latency_init(mm_latency_t *this)
+{
+	memset(this, 0, sizeof(mm_latency_t));
+}
+
+uint32_t mm_latency_bucket(uint32_t ns)
+{
+	uint32_t bucket = ns;
+	if (ns >= MM_LATENCY_SUBS) {
+		uint32_t msb = 31 - __builtin_clz(ns);
+		uint32_t sub = (ns >> (msb - MM_LATENCY_SUB_BITS)) & (MM_LATENCY_SUBS - 1);
+		bucket = ((msb - MM_LATENCY_SUB_BITS + 1) << MM_LATENCY_SUB_BITS) + sub;
+	}
+	return umin(bucket, MM_CFG_LATENCY_BUCKETS - 1);
+}
+
+uint32_t mm_latency_bucket_floor(uint32_t bucket)
+{
+	if (bucket < MM_LATENCY_SUBS) {
+		return bucket;
+	}
+	uint32_t msb = (bucket >> MM_LATENCY_SUB_BITS) + MM_LATENCY_SUB_BITS - 1;
+	uint32_t sub = bucket & (MM_LATENCY_SUBS - 1);
+	return (1U << msb) | (sub << (msb - MM_LATENCY_SUB_BITS));
+}
+
+void mm_latency_record(mm_latency_t *this, mm_latency_kind_t kind, uint32_t ns)
+{
+	mm_latency_hist_t *hist = &this->hist[kind];
+	__atomic_fetch_add(&hist->buckets[mm_latency_bucket(ns)], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&hist->count, 1, __ATOMIC_RELAXED);
+
+	uint32_t max = __atomic_load_n(&hist->max_ns, __ATOMIC_RELAXED);
+	while ((ns > max) &&
+	       !__atomic_compare_exchange_n(&hist->max_ns, &max, ns, true,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+}
+
+uint32_t mm_latency_start(void)
+{
+	return system_time_ns();
+}
+
+void mm_latency_end(mm_latency_t *this, mm_latency_kind_t kind, uint32_t start)
+{
+	uint32_t ns = system_time_ns() - start;
+	mm_latency_record(this, kind, ns);
+
+	mm_latency_t *own = task_mm_latency_get(NULL);
+	if (own != NULL) {
+		mm_latency_record(own, kind, ns);
+	}
+}
+
+uint32_t mm_latency_read(mm_latency_t *this, mm_latency_kind_t kind,
+			 mm_latency_hist_t *out, bool reset)
+{
+	mm_latency_hist_t *hist = &this->hist[kind];
+	for (uint32_t i = 0; i < MM_CFG_LATENCY_BUCKETS; i++) {
+		out->buckets[i] = mm_latency_take(&hist->buckets[i], reset);
+	}
+	out->count = mm_latency_take(&hist->count, reset);
+	out->max_ns = mm_latency_take(&hist->max_ns, reset);
+	return out->count;
+}
+
+mm_latency_t *mm_heap_latency_get(mm_heap_t *this)
+{
+	return &this->latency;
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/heap.h"
+#include "memmgr/latency.h"
+#include "os/memmgr.h"
+#include "os/task.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			HEAP_SIZE		(4096)
+
+static uint8_t gs_buf[HEAP_SIZE] __attribute__((aligned(8)));
+static mm_heap_t *gs_heap = NULL;
+
+static uint32_t		count_of		(mm_latency_t *latency,
+						 mm_latency_kind_t kind);
+static void		alloc_and_free		(void *arg);
+
+static uint32_t count_of(mm_latency_t *latency, mm_latency_kind_t kind)
+{
+	mm_latency_hist_t hist;
+	return mm_latency_read(latency, kind, &hist, false);
+}
+
+static void alloc_and_free(void *arg)
+{
+	(void)arg;
+	mm_heap_free(gs_heap, mm_heap_alloc(gs_heap, 32));
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_latency);
+
+TEST_GROUP_RUNNER(mm_latency)
+{
+	RUN_TEST_CASE(mm_latency, bucket_is_log_linear);
+	RUN_TEST_CASE(mm_latency, floor_is_the_start_of_a_bucket);
+	RUN_TEST_CASE(mm_latency, record_keeps_the_worst);
+	RUN_TEST_CASE(mm_latency, read_can_reset);
+	RUN_TEST_CASE(mm_latency, heap_counts_its_operations);
+	RUN_TEST_CASE(mm_latency, moving_realloc_counts_once);
+	RUN_TEST_CASE(mm_latency, task_counts_its_own);
+}
+
+TEST_SETUP(mm_latency)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+	gs_heap = mm_heap_init(gs_buf, HEAP_SIZE);
+	TEST_ASSERT_NOT_NULL(gs_heap);
+}
+
+TEST_TEAR_DOWN(mm_latency)
+{
+	mm_heap_release(gs_heap);
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_latency, bucket_is_log_linear)
+{
+	TEST_ASSERT_EQUAL_UINT32(0, mm_latency_bucket(0));
+	TEST_ASSERT_EQUAL_UINT32(3, mm_latency_bucket(3));
+	TEST_ASSERT_EQUAL_UINT32(4, mm_latency_bucket(4));
+	TEST_ASSERT_EQUAL_UINT32(7, mm_latency_bucket(7));
+	TEST_ASSERT_EQUAL_UINT32(8, mm_latency_bucket(8));
+	TEST_ASSERT_EQUAL_UINT32(8, mm_latency_bucket(9));
+	TEST_ASSERT_EQUAL_UINT32(10, mm_latency_bucket(12));
+	TEST_ASSERT_EQUAL_UINT32(11, mm_latency_bucket(15));
+	TEST_ASSERT_EQUAL_UINT32(12, mm_latency_bucket(16));
+	TEST_ASSERT_EQUAL_UINT32(15, mm_latency_bucket(31));
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_LATENCY_BUCKETS - 1,
+				 mm_latency_bucket(UINT32_MAX));
+}
+
+TEST(mm_latency, floor_is_the_start_of_a_bucket)
+{
+	for (uint32_t bucket = 0; bucket < MM_CFG_LATENCY_BUCKETS; bucket++) {
+		uint32_t floor = mm_latency_bucket_floor(bucket);
+		TEST_ASSERT_EQUAL_UINT32(bucket, mm_latency_bucket(floor));
+		if (floor != 0) {
+			TEST_ASSERT_EQUAL_UINT32(bucket - 1,
+						 mm_latency_bucket(floor - 1));
+		}
+	}
+}
+
+TEST(mm_latency, record_keeps_the_worst)
+{
+	mm_latency_t latency;
+	mm_latency_hist_t hist;
+	mm_latency_init(&latency);
+
+	mm_latency_record(&latency, MM_LATENCY_FREE, 3);
+	mm_latency_record(&latency, MM_LATENCY_FREE, 100);
+	mm_latency_record(&latency, MM_LATENCY_FREE, 7);
+
+	TEST_ASSERT_EQUAL_UINT32(3, mm_latency_read(&latency, MM_LATENCY_FREE,
+						    &hist, false));
+	TEST_ASSERT_EQUAL_UINT32(100, hist.max_ns);
+	TEST_ASSERT_EQUAL_UINT32(1, hist.buckets[3]);
+	TEST_ASSERT_EQUAL_UINT32(1, hist.buckets[7]);
+	TEST_ASSERT_EQUAL_UINT32(1, hist.buckets[mm_latency_bucket(100)]);
+	TEST_ASSERT_EQUAL_UINT32(0, count_of(&latency, MM_LATENCY_ALLOC));
+}
+
+TEST(mm_latency, read_can_reset)
+{
+	mm_latency_t latency;
+	mm_latency_hist_t hist;
+	mm_latency_init(&latency);
+	mm_latency_record(&latency, MM_LATENCY_WAIT, 42);
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_latency_read(&latency, MM_LATENCY_WAIT,
+						    &hist, false));
+	TEST_ASSERT_EQUAL_UINT32(1, mm_latency_read(&latency, MM_LATENCY_WAIT,
+						    &hist, true));
+	TEST_ASSERT_EQUAL_UINT32(42, hist.max_ns);
+
+	TEST_ASSERT_EQUAL_UINT32(0, mm_latency_read(&latency, MM_LATENCY_WAIT,
+						    &hist, false));
+	TEST_ASSERT_EQUAL_UINT32(0, hist.max_ns);
+	TEST_ASSERT_EQUAL_UINT32(0, hist.buckets[mm_latency_bucket(42)]);
+}
+
+TEST(mm_latency, heap_counts_its_operations)
+{
+	mm_latency_t *latency = mm_heap_latency_get(gs_heap);
+	mm_latency_t *other = mm_heap_latency_get(mm_heap_default());
+	uint32_t other_allocs = count_of(other, MM_LATENCY_ALLOC);
+	void *a = mm_heap_alloc(gs_heap, 16);
+	a = mm_heap_realloc(gs_heap, a, 32);
+	mm_heap_free(gs_heap, a);
+
+	TEST_ASSERT_EQUAL_UINT32(1, count_of(latency, MM_LATENCY_ALLOC));
+	TEST_ASSERT_EQUAL_UINT32(1, count_of(latency, MM_LATENCY_REALLOC));
+	TEST_ASSERT_EQUAL_UINT32(1, count_of(latency, MM_LATENCY_FREE));
+	// each operation takes the heap lock at least once
+	TEST_ASSERT_TRUE(count_of(latency, MM_LATENCY_WAIT) >= 3);
+	TEST_ASSERT_EQUAL_UINT32(other_allocs, count_of(other, MM_LATENCY_ALLOC));
+
+	// durations are in ns, no real operation is that quick
+	mm_latency_hist_t hist;
+	mm_latency_read(latency, MM_LATENCY_ALLOC, &hist, false);
+	TEST_ASSERT_EQUAL_UINT32(0, hist.buckets[0]);
+	TEST_ASSERT_TRUE(hist.max_ns > 0);
+}
+
+TEST(mm_latency, moving_realloc_counts_once)
+{
+	mm_latency_t *latency = mm_heap_latency_get(mm_heap_default());
+	mm_latency_hist_t hist;
+	void *a = mm_alloc(16);
+	void *b = mm_alloc(16);
+	for (uint32_t kind = 0; kind < MM_LATENCY_KINDS; kind++) {
+		mm_latency_read(latency, kind, &hist, true);
+	}
+
+	void *c = mm_realloc(a, 128);
+	TEST_ASSERT_TRUE(c != a);
+	TEST_ASSERT_EQUAL_UINT32(1, count_of(latency, MM_LATENCY_REALLOC));
+	TEST_ASSERT_EQUAL_UINT32(0, count_of(latency, MM_LATENCY_ALLOC));
+	TEST_ASSERT_EQUAL_UINT32(0, count_of(latency, MM_LATENCY_FREE));
+
+	mm_free(b);
+	mm_free(c);
+	TEST_ASSERT_EQUAL_UINT32(2, count_of(latency, MM_LATENCY_FREE));
+}
+
+TEST(mm_latency, task_counts_its_own)
+{
+	task_t *t = task_create(alloc_and_free, NULL, 0, 0, "test_latency");
+	TEST_ASSERT_NOT_NULL(t);
+	mm_latency_t *latency = task_mm_latency_get(t);
+	TEST_ASSERT_NOT_NULL(latency);
+
+	TEST_ASSERT_TRUE(task_start(t));
+	task_stop(t);
+	TEST_ASSERT_EQUAL_UINT32(1, count_of(latency, MM_LATENCY_ALLOC));
+	TEST_ASSERT_EQUAL_UINT32(1, count_of(latency, MM_LATENCY_FREE));
+	TEST_ASSERT_EQUAL_UINT32(2, count_of(mm_heap_latency_get(gs_heap),
+					     MM_LATENCY_ALLOC) +
+				    count_of(mm_heap_latency_get(gs_heap),
+					     MM_LATENCY_FREE));
+	object_delete(&t->base);
+}
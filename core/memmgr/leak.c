@@ -0,0 +1,353 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os/system.h"
+#include "os/task.h"
+#include "memmgr/leak.h"
+
+#include "memmgr_conf.h"
+
+#if MM_CFG_LEAK
+/*
+ * Open addressing table of the live blocks keyed by address, linear probing.
+ * Removals shift the following entries back so that no probe sequence is
+ * ever cut short, one slot is always left empty to end them. The table has
+ * its own spinning lock: tasks report their leaks when they end, whatever
+ * the state of the heap lock.
+ */
+
+/* Macro definitions ---------------------------------------------------------*/
+#if (MM_CFG_LEAK_BLOCKS & (MM_CFG_LEAK_BLOCKS - 1)) != 0
+#error "MM_CFG_LEAK_BLOCKS must be a power of two"
+#endif
+
+#define MM_LEAK_MASK		(MM_CFG_LEAK_BLOCKS - 1)
+#define MM_LEAK_LINE		(128)
+/* groups written by mm_leak_dump */
+#define MM_LEAK_DUMP_GROUPS	(16)
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct
+{
+	/* NULL when the slot is empty */
+	void *		ptr;
+	task_t *	task;
+	void *		site;
+	uint32_t	size;
+} mm_leak_block_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint32_t		mm_leak_home		(void *ptr);
+static mm_leak_block_t *mm_leak_find		(void *ptr,
+						 bool insert);
+static void		mm_leak_remove		(uint32_t i);
+static bool		mm_leak_write_line	(mm_leak_write_f write,
+						 void *arg,
+						 char *line,
+						 int len);
+static void		mm_leak_lock		(void);
+static void		mm_leak_unlock		(void);
+
+/* Variables -----------------------------------------------------------------*/
+static mm_leak_block_t	gs_blocks[MM_CFG_LEAK_BLOCKS];
+static uint32_t		gs_count = 0;
+static uint32_t		gs_dropped = 0;
+static mm_leak_write_f	gs_hook = NULL;
+static void		*gs_hook_arg = NULL;
+static bool		gs_leak_lock = false;
+
+/* Private functions definitions ---------------------------------------------*/
+static uint32_t mm_leak_home(void *ptr)
+{
+	return (((uintptr_t)ptr >> 2) * 2654435761u) & MM_LEAK_MASK;
+}
+
+static mm_leak_block_t *mm_leak_find(void *ptr, bool insert)
+{
+	uint32_t i = mm_leak_home(ptr);
+	for (uint32_t n = 0; n < MM_CFG_LEAK_BLOCKS; n++, i = (i + 1) & MM_LEAK_MASK) {
+		mm_leak_block_t *slot = &gs_blocks[i];
+		if (slot->ptr == ptr) {
+			return slot;
+		}
+		if (slot->ptr == NULL) {
+			return insert ? slot : NULL;
+		}
+	}
+	return NULL;
+}
+
+static void mm_leak_remove(uint32_t i)
+{
+	uint32_t j = i;
+	for (;;) {
+		j = (j + 1) & MM_LEAK_MASK;
+		if (gs_blocks[j].ptr == NULL) {
+			break;
+		}
+		// the hole is on the probe sequence of j, j moves into it
+		uint32_t home = mm_leak_home(gs_blocks[j].ptr);
+		if (((j - home) & MM_LEAK_MASK) >= ((j - i) & MM_LEAK_MASK)) {
+			gs_blocks[i] = gs_blocks[j];
+			i = j;
+		}
+	}
+	gs_blocks[i].ptr = NULL;
+	gs_count--;
+}
+
+static bool mm_leak_write_line(mm_leak_write_f write, void *arg, char *line,
+			       int len)
+{
+	if (len < 0) {
+		return false;
+	}
+	if (len >= MM_LEAK_LINE) {
+		len = MM_LEAK_LINE - 1;
+	}
+	return write(arg, line, len);
+}
+
+static void mm_leak_lock(void)
+{
+	while (__atomic_test_and_set(&gs_leak_lock, __ATOMIC_ACQUIRE)) {
+		while (__atomic_load_n(&gs_leak_lock, __ATOMIC_RELAXED)) {
+		}
+	}
+}
+
+static void mm_leak_unlock(void)
+{
+	__atomic_clear(&gs_leak_lock, __ATOMIC_RELEASE);
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_leak_reset(void)
+{
+	gs_leak_lock = false;
+	memset(gs_blocks, 0, sizeof(gs_blocks));
+	gs_count = 0;
+	gs_dropped = 0;
+}
+
+void mm_leak_alloc(void *ptr, uint32_t size, void *site)
+{
+	if (ptr == NULL) {
+		return;
+	}
+	mm_leak_lock();
+	mm_leak_block_t *block = mm_leak_find(ptr, true);
+	if ((block == NULL) ||
+	    ((block->ptr == NULL) && (gs_count == MM_CFG_LEAK_BLOCKS - 1))) {
+		gs_dropped++;
+	} else {
+		gs_count += (block->ptr == NULL);
+		block->ptr = ptr;
+		block->task = task_self();
+		block->site = site;
+		block->size = size;
+	}
+	mm_leak_unlock();
+}
+
+bool mm_leak_free(void *ptr, mm_leak_t *tag)
+{
+	if (ptr == NULL) {
+		return false;
+	}
+	mm_leak_lock();
+	mm_leak_block_t *block = mm_leak_find(ptr, false);
+	if (block != NULL) {
+		if (tag != NULL) {
+			tag->site = block->site;
+			tag->size = block->size;
+			tag->count = 1;
+		}
+		mm_leak_remove(block - gs_blocks);
+	}
+	mm_leak_unlock();
+	return block != NULL;
+}
+
+void mm_leak_site_set(void *ptr, void *site)
+{
+	if (ptr == NULL) {
+		return;
+	}
+	mm_leak_lock();
+	mm_leak_block_t *block = mm_leak_find(ptr, false);
+	if (block != NULL) {
+		block->site = site;
+	}
+	mm_leak_unlock();
+}
+
+void mm_leak_adopt(void *ptr)
+{
+	if (ptr == NULL) {
+		return;
+	}
+	mm_leak_lock();
+	mm_leak_block_t *block = mm_leak_find(ptr, false);
+	if (block != NULL) {
+		block->task = task_self();
+	}
+	mm_leak_unlock();
+}
+
+uint32_t mm_leak_dropped(void)
+{
+	return gs_dropped;
+}
+
+uint32_t mm_leak_count(task_t *task, uint32_t *bytes)
+{
+	uint32_t count = 0;
+	uint32_t sum = 0;
+
+	mm_leak_lock();
+	for (uint32_t i = 0; i < MM_CFG_LEAK_BLOCKS; i++) {
+		mm_leak_block_t *block = &gs_blocks[i];
+		if ((block->ptr != NULL) && (block->task == task)) {
+			count++;
+			sum += block->size;
+		}
+	}
+	mm_leak_unlock();
+
+	if (bytes != NULL) {
+		*bytes = sum;
+	}
+	return count;
+}
+
+uint32_t mm_leak_report(task_t *task, mm_leak_t *out, uint32_t n)
+{
+	uint32_t count = 0;
+
+	mm_leak_lock();
+	for (uint32_t i = 0; i < MM_CFG_LEAK_BLOCKS; i++) {
+		mm_leak_block_t *block = &gs_blocks[i];
+		if ((block->ptr == NULL) || (block->task != task)) {
+			continue;
+		}
+		uint32_t j = 0;
+		while ((j < count) &&
+		       ((out[j].site != block->site) || (out[j].size != block->size))) {
+			j++;
+		}
+		if (j < count) {
+			out[j].count++;
+		} else if (count < n) {
+			out[count].site = block->site;
+			out[count].size = block->size;
+			out[count].count = 1;
+			count++;
+		}
+	}
+	mm_leak_unlock();
+
+	// insertion sort on the bytes held
+	for (uint32_t i = 1; i < count; i++) {
+		mm_leak_t group = out[i];
+		uint64_t bytes = (uint64_t)group.size * group.count;
+		uint32_t j = i;
+		while ((j > 0) && ((uint64_t)out[j - 1].size * out[j - 1].count < bytes)) {
+			out[j] = out[j - 1];
+			j--;
+		}
+		out[j] = group;
+	}
+	return count;
+}
+
+uint32_t mm_leak_dump(task_t *task, mm_leak_write_f write, void *arg)
+{
+	mm_leak_t groups[MM_LEAK_DUMP_GROUPS];
+	uint32_t bytes = 0;
+	uint32_t blocks = mm_leak_count(task, &bytes);
+	uint32_t count = mm_leak_report(task, groups, MM_LEAK_DUMP_GROUPS);
+	uint32_t lines = 0;
+
+	// written without the lock, the sink may well allocate
+	char line[MM_LEAK_LINE];
+	int len = snprintf(line, sizeof(line), "task %p: %u blocks, %u bytes\n",
+			   (void *)task, (unsigned)blocks, (unsigned)bytes);
+	if (!mm_leak_write_line(write, arg, line, len)) {
+		return lines;
+	}
+	lines++;
+
+	for (uint32_t i = 0; i < count; i++) {
+		const char *name = NULL;
+		uintptr_t offset = 0;
+		if (system_symbol_get(groups[i].site, &name, &offset)) {
+			len = snprintf(line, sizeof(line), "%s+0x%lx", name,
+				       (unsigned long)offset);
+		} else {
+			len = snprintf(line, sizeof(line), "%p", groups[i].site);
+		}
+		if ((len >= 0) && (len < (int)sizeof(line))) {
+			len += snprintf(line + len, sizeof(line) - len,
+					" size=%u count=%u\n",
+					(unsigned)groups[i].size,
+					(unsigned)groups[i].count);
+		}
+		if (!mm_leak_write_line(write, arg, line, len)) {
+			break;
+		}
+		lines++;
+	}
+	return lines;
+}
+
+void mm_leak_hook_set(mm_leak_write_f write, void *arg)
+{
+	mm_leak_lock();
+	gs_hook = write;
+	gs_hook_arg = arg;
+	mm_leak_unlock();
+}
+
+void mm_leak_task_exit(task_t *task)
+{
+	mm_leak_lock();
+	mm_leak_write_f hook = gs_hook;
+	void *arg = gs_hook_arg;
+	mm_leak_unlock();
+
+	if ((hook != NULL) && (mm_leak_count(task, NULL) != 0)) {
+		mm_leak_dump(task, hook, arg);
+	}
+
+	mm_leak_lock();
+	for (uint32_t i = 0; i < MM_CFG_LEAK_BLOCKS; i++) {
+		// the next entry may shift into i
+		while ((gs_blocks[i].ptr != NULL) && (gs_blocks[i].task == task)) {
+			mm_leak_remove(i);
+		}
+	}
+	mm_leak_unlock();
+}
+#endif
@@ -0,0 +1,296 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/leak.h"
+#include "os/memmgr.h"
+#include "os/task.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			OUT_SIZE		(512)
+
+static char gs_out[OUT_SIZE];
+static uint32_t gs_out_len = 0;
+static uint32_t gs_out_lines = 0;
+static void *gs_handed = NULL;
+static void *gs_leaked = NULL;
+
+static void *		alloc_here		(uint32_t size);
+static void *		alloc_there		(uint32_t size);
+static void *		zalloc_here		(uint32_t size);
+static void *		site_of_here		(void);
+static void *		site_of_zalloc_here	(void);
+static bool		write_out		(void *arg,
+						 const char *line,
+						 uint32_t len);
+static void		leak_and_adopt		(void *arg);
+
+/* two distinct call sites */
+__attribute__((noinline)) static void *alloc_here(uint32_t size)
+{
+	return mm_alloc(size);
+}
+
+__attribute__((noinline)) static void *alloc_there(uint32_t size)
+{
+	return mm_alloc(size);
+}
+
+__attribute__((noinline)) static void *zalloc_here(uint32_t size)
+{
+	return mm_zalloc(size);
+}
+
+/* slots and cached chunks do not record the call site, a big chunk does */
+static void *site_of_here(void)
+{
+	void *ptr = alloc_here(CHUNK_TEST_UNCACHED);
+	void *site = mm_chunk_allocator_get(mm_tochunk(ptr));
+	mm_free(ptr);
+	return site;
+}
+
+static void *site_of_zalloc_here(void)
+{
+	void *ptr = zalloc_here(CHUNK_TEST_UNCACHED);
+	void *site = mm_chunk_allocator_get(mm_tochunk(ptr));
+	mm_free(ptr);
+	return site;
+}
+
+static bool write_out(void *arg, const char *line, uint32_t len)
+{
+	(void)arg;
+	if (gs_out_len + len >= OUT_SIZE) {
+		return false;
+	}
+	memcpy(gs_out + gs_out_len, line, len);
+	gs_out_len += len;
+	gs_out[gs_out_len] = '\0';
+	gs_out_lines++;
+	return true;
+}
+
+static void leak_and_adopt(void *arg)
+{
+	(void)arg;
+	mm_leak_adopt(gs_handed);
+	gs_leaked = mm_alloc(24);
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_leak);
+
+TEST_GROUP_RUNNER(mm_leak)
+{
+	RUN_TEST_CASE(mm_leak, report_groups_by_site_and_size);
+	RUN_TEST_CASE(mm_leak, free_untags_the_block);
+	RUN_TEST_CASE(mm_leak, realloc_retags_the_block);
+	RUN_TEST_CASE(mm_leak, zalloc_reports_its_caller);
+	RUN_TEST_CASE(mm_leak, batch_tags_each_block);
+	RUN_TEST_CASE(mm_leak, removal_keeps_colliding_blocks);
+	RUN_TEST_CASE(mm_leak, full_table_drops_blocks);
+	RUN_TEST_CASE(mm_leak, task_exit_reports_and_forgets);
+	RUN_TEST_CASE(mm_leak, dump_writes_summary_and_groups);
+}
+
+TEST_SETUP(mm_leak)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_leak_reset();
+	gs_out_len = 0;
+	gs_out_lines = 0;
+	gs_out[0] = '\0';
+}
+
+TEST_TEAR_DOWN(mm_leak)
+{
+	mm_leak_hook_set(NULL, NULL);
+	mm_leak_reset();
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_leak, report_groups_by_site_and_size)
+{
+	mm_leak_t out[4];
+	void *a = alloc_here(10);
+	void *b = alloc_here(10);
+	void *c = alloc_here(10);
+	void *d = alloc_here(20);
+	void *e = alloc_there(8);
+
+	TEST_ASSERT_EQUAL_UINT32(3, mm_leak_report(task_self(), out, 4));
+	void *site = out[0].site;
+	TEST_ASSERT_EQUAL_UINT32(10, out[0].size);
+	TEST_ASSERT_EQUAL_UINT32(3, out[0].count);
+	TEST_ASSERT_EQUAL_PTR(out[0].site, out[1].site);
+	TEST_ASSERT_EQUAL_UINT32(20, out[1].size);
+	TEST_ASSERT_EQUAL_UINT32(1, out[1].count);
+	TEST_ASSERT_TRUE(out[2].site != out[0].site);
+	TEST_ASSERT_EQUAL_UINT32(8, out[2].size);
+
+	// the groups that do not fit are left out
+	TEST_ASSERT_EQUAL_UINT32(1, mm_leak_report(task_self(), out, 1));
+
+	mm_free(a);
+	mm_free(b);
+	mm_free(c);
+	mm_free(d);
+	mm_free(e);
+	TEST_ASSERT_EQUAL_PTR(site_of_here(), site);
+}
+
+TEST(mm_leak, free_untags_the_block)
+{
+	uint32_t bytes = 0;
+	void *a = alloc_here(10);
+	void *b = alloc_here(30);
+	mm_free(a);
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_leak_count(task_self(), &bytes));
+	TEST_ASSERT_EQUAL_UINT32(30, bytes);
+	mm_free(b);
+	TEST_ASSERT_EQUAL_UINT32(0, mm_leak_count(task_self(), NULL));
+}
+
+TEST(mm_leak, realloc_retags_the_block)
+{
+	mm_leak_t out[2];
+	void *a = alloc_here(16);
+	void *b = alloc_here(16);
+	void *c = mm_realloc(a, 128);
+	TEST_ASSERT_TRUE(c != a);
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_leak_report(task_self(), out, 2));
+	TEST_ASSERT_EQUAL_UINT32(128, out[0].size);
+	TEST_ASSERT_EQUAL_UINT32(1, out[0].count);
+	TEST_ASSERT_EQUAL_UINT32(16, out[1].size);
+	TEST_ASSERT_EQUAL_UINT32(1, out[1].count);
+
+	mm_free(b);
+	mm_free(c);
+}
+
+TEST(mm_leak, zalloc_reports_its_caller)
+{
+	mm_leak_t out[1];
+	void *a = zalloc_here(12);
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_leak_report(task_self(), out, 1));
+	TEST_ASSERT_EQUAL_PTR(site_of_zalloc_here(), out[0].site);
+	mm_free(a);
+}
+
+TEST(mm_leak, batch_tags_each_block)
+{
+	uint32_t sizes[3] = {8, 0, 16};
+	void *ptrs[3];
+	uint32_t bytes = 0;
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_alloc_batch(3, sizes, ptrs));
+	TEST_ASSERT_EQUAL_UINT32(2, mm_leak_count(task_self(), &bytes));
+	TEST_ASSERT_EQUAL_UINT32(24, bytes);
+
+	mm_free_batch(ptrs, 3);
+	TEST_ASSERT_EQUAL_UINT32(0, mm_leak_count(task_self(), NULL));
+}
+
+TEST(mm_leak, removal_keeps_colliding_blocks)
+{
+	// addresses a table size apart share their first slot
+	uintptr_t base = 0x1000;
+	uintptr_t step = MM_CFG_LEAK_BLOCKS * 4;
+	for (uint32_t i = 0; i < 4; i++) {
+		mm_leak_alloc((void *)(base + (i * step)), i + 1, NULL);
+	}
+
+	mm_leak_t tag;
+	TEST_ASSERT_TRUE(mm_leak_free((void *)(base + step), &tag));
+	TEST_ASSERT_EQUAL_UINT32(2, tag.size);
+	TEST_ASSERT_FALSE(mm_leak_free((void *)(base + 5 * step), NULL));
+
+	uint32_t bytes = 0;
+	TEST_ASSERT_EQUAL_UINT32(3, mm_leak_count(task_self(), &bytes));
+	TEST_ASSERT_EQUAL_UINT32(1 + 3 + 4, bytes);
+	for (uint32_t i = 0; i < 4; i++) {
+		mm_leak_free((void *)(base + (i * step)), NULL);
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mm_leak_count(task_self(), NULL));
+}
+
+TEST(mm_leak, full_table_drops_blocks)
+{
+	for (uint32_t i = 0; i < MM_CFG_LEAK_BLOCKS; i++) {
+		mm_leak_alloc((void *)(uintptr_t)(0x1000 + (i * 16)), 1, NULL);
+	}
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_LEAK_BLOCKS - 1,
+				 mm_leak_count(task_self(), NULL));
+	TEST_ASSERT_EQUAL_UINT32(1, mm_leak_dropped());
+
+	// a tagged block can still be found and removed
+	TEST_ASSERT_TRUE(mm_leak_free((void *)0x1000, NULL));
+	TEST_ASSERT_FALSE(mm_leak_free((void *)0x1000, NULL));
+	mm_leak_alloc((void *)0x1000, 1, NULL);
+	TEST_ASSERT_EQUAL_UINT32(1, mm_leak_dropped());
+}
+
+TEST(mm_leak, task_exit_reports_and_forgets)
+{
+	gs_handed = alloc_here(40);
+	gs_leaked = NULL;
+	mm_leak_hook_set(write_out, NULL);
+
+	task_t *t = task_create(leak_and_adopt, NULL, 0, 0, "test_leak");
+	TEST_ASSERT_NOT_NULL(t);
+	TEST_ASSERT_TRUE(task_start(t));
+	task_stop(t);
+
+	TEST_ASSERT_NOT_NULL(gs_leaked);
+	TEST_ASSERT_EQUAL_UINT32(3, gs_out_lines);
+	TEST_ASSERT_NOT_NULL(strstr(gs_out, "2 blocks, 64 bytes\n"));
+	TEST_ASSERT_NOT_NULL(strstr(gs_out, " size=40 count=1\n"));
+	TEST_ASSERT_NOT_NULL(strstr(gs_out, " size=24 count=1\n"));
+	TEST_ASSERT_EQUAL_UINT32(0, mm_leak_count(t, NULL));
+	TEST_ASSERT_EQUAL_UINT32(0, mm_leak_count(task_self(), NULL));
+
+	object_delete(&t->base);
+	mm_free(gs_handed);
+	mm_free(gs_leaked);
+}
+
+TEST(mm_leak, dump_writes_summary_and_groups)
+{
+	void *a = alloc_here(10);
+	void *b = alloc_there(20);
+
+	TEST_ASSERT_EQUAL_UINT32(3, mm_leak_dump(task_self(), write_out, NULL));
+	TEST_ASSERT_NOT_NULL(strstr(gs_out, ": 2 blocks, 30 bytes\n"));
+	TEST_ASSERT_NOT_NULL(strstr(gs_out, " size=20 count=1\n"));
+	TEST_ASSERT_TRUE(strstr(gs_out, " size=20") < strstr(gs_out, " size=10"));
+
+	mm_free(a);
+	mm_free(b);
+}
@@ -17,27 +17,40 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "common/common.h"
 #include "os/memmgr.h"
 #include "os/mutex.h"
+#include "os/task.h"
+#include "memmgr/cache.h"
 #include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/latency.h"
+#include "memmgr/leak.h"
+#include "memmgr/pool.h"
+#include "memmgr/profile.h"
+#include "memmgr/reclaim.h"
+#include "memmgr/slab.h"
+#include "memmgr/trace.h"
+#include "memmgr/zone.h"
 #include "memmgr_conf.h"
 
 /* Macro definitions ---------------------------------------------------------*/
+/* something watches the mm_alloc family, see mm_traced() */
+#define MM_WATCHED	(MM_CFG_TRACE || MM_CFG_PROFILE || MM_CFG_LATENCY || \
+			 MM_CFG_LEAK || MM_CFG_ZONE)
 
 /* Type definitions ----------------------------------------------------------*/
+/* a heap created by mm_heap_init lives at the start of its own buffer */
 typedef struct
 {
-	uint8_t		*heap;
-	mutex_t		*mtx;
-} mm_heap_t;
+	mm_heap_t	heap;
+	mm_chunk_ctx_t	ctx;
+} mm_heap_desc_t;
 
 /* Prototypes ----------------------------------------------------------------*/
-static void			mm_lock			(void);
-static void			mm_unlock		(void);
-
 static void *			mm_alloc_impl		(uint32_t size);
 static void *			mm_zalloc_impl		(uint32_t size);
 static void *			mm_calloc_impl		(uint32_t n,
@@ -45,9 +58,44 @@ static void *			mm_calloc_impl		(uint32_t n,
 static void *			mm_realloc_impl		(void *old_ptr,
 							 uint32_t size);
 static void 			mm_free_impl		(void *ptr);
+static void *			mm_alloc_cached		(uint32_t size,
+							 void *lr);
+static void			mm_free_cached		(void *ptr);
+#if MM_CFG_ZONE
+static void *			mm_alloc_zoned		(uint32_t size,
+							 void *lr);
+#endif
+static bool			mm_traced		(void);
+static void			mm_block_allocator_set	(void *ptr,
+							 void *lr);
+#if MM_CFG_PROFILE
+static void			mm_profile_block	(void *ptr,
+							 bool alloc);
+#endif
+
+static void			mm_heap_prepare		(mm_heap_t *this,
+							 uint8_t *buffer);
+static void			mm_heap_setup		(mm_heap_t *this,
+							 uint8_t *buffer,
+							 uint32_t size);
+static void *			mm_heap_alloc_any	(mm_heap_t *this,
+							 uint32_t size);
+static void			mm_heap_free_any	(mm_heap_t *this,
+							 void *ptr);
+static void			mm_free_locked		(void *ptr);
+static bool			mm_heap_grow		(mm_heap_t *this,
+							 uint32_t csize);
+static int			mm_ptr_cmp		(const void *a,
+							 const void *b);
+static void *			mm_heap_realloc_internal(mm_heap_t *this,
+							 void *old_ptr,
+							 uint32_t size,
+							 void *lr);
 
 /* Variables -----------------------------------------------------------------*/
 static mm_heap_t	gs_memmgr = {NULL};
+static mm_region_get_f	gs_region_get = NULL;
+static mm_region_put_f	gs_region_put = NULL;
 
 MOCKABLE mm_alloc_f	mm_alloc = mm_alloc_impl;
 MOCKABLE mm_alloc_f	mm_zalloc = mm_zalloc_impl;
@@ -56,87 +104,390 @@ MOCKABLE mm_realloc_f	mm_realloc = mm_realloc_impl;
 MOCKABLE mm_free_f	mm_free = mm_free_impl;
 
 /* Private Functions definitions ---------------------------------------------*/
-static void mm_lock(void)
+static void *mm_alloc_impl(uint32_t size)
 {
-	if (gs_memmgr.mtx != NULL) {
-		mutex_lock(gs_memmgr.mtx, -1);
+	void *lr = __builtin_return_address(0);
+	MM_LATENCY_START(start);
+#if MM_CFG_ZONE
+	void *ptr = mm_alloc_zoned(size, lr);
+#else
+	void *ptr = mm_alloc_cached(size, lr);
+#endif
+	if (mm_traced()) {
+		MM_LATENCY_END(&gs_memmgr.latency, MM_LATENCY_ALLOC, start);
+		MM_TRACE(MM_TRACE_ALLOC, ptr, NULL, size, lr);
+#if MM_CFG_LEAK
+		mm_leak_alloc(ptr, size, lr);
+#endif
+#if MM_CFG_PROFILE
+		// a cached block still carries the call site that filled the cache
+		mm_block_allocator_set(ptr, lr);
+		mm_profile_block(ptr, true);
+#endif
 	}
+	return ptr;
 }
 
-static void mm_unlock(void)
+static void *mm_zalloc_impl(uint32_t size)
 {
-	if (gs_memmgr.mtx != NULL) {
-		mutex_unlock(gs_memmgr.mtx);
+	mm_lock();
+	// mm_alloc may hand out a cached block the heap did not clear
+	gs_memmgr.zero = true;
+	gs_memmgr.zeroed = NULL;
+	void *ptr = mm_alloc(size);
+	gs_memmgr.zero = false;
+	if (ptr != NULL) {
+		if (ptr != gs_memmgr.zeroed) {
+			memset(ptr, 0, size);
+		}
+		mm_allocator_update(ptr);
 	}
+	mm_unlock();
+	return ptr;
 }
 
-static void *mm_alloc_impl(uint32_t size)
+static void *mm_calloc_impl(uint32_t n, uint32_t size)
 {
-	int32_t wanted_csize = 0;
+	mm_lock();
+	void *ptr = mm_zalloc(n * size);
+	if (ptr != NULL) {
+		mm_allocator_update(ptr);
+	}
+	mm_unlock();
+	return ptr;
+}
+
+static void *mm_realloc_impl(void *old_ptr, uint32_t size)
+{
+	void *lr = __builtin_return_address(0);
+#if MM_CFG_PROFILE
+	bool profiled = mm_traced() && (old_ptr != NULL) && (size != 0);
+	if (profiled) {
+		mm_profile_block(old_ptr, false);
+	}
+#endif
+#if MM_CFG_LEAK
+	// untagged before the block moves, its address may be handed out again
+	mm_leak_t tag;
+	bool tagged = mm_traced() && mm_leak_free(old_ptr, &tag);
+#endif
+#if MM_CFG_ZONE
+	// the block stays in its zone, which must afford the growth
+	mm_zone_t *zone = NULL;
+	uint32_t old_size = 0;
+	bool fits = true;
+	if (mm_traced()) {
+		zone = (old_ptr == NULL) ? mm_zone_current() :
+		       mm_zone_untag(old_ptr, &old_size);
+		fits = (zone == NULL) || (size <= old_size) ||
+		       mm_zone_charge(zone, size - old_size, (old_ptr == NULL));
+	}
+#else
+	bool fits = true;
+#endif
+	MM_LATENCY_START(start);
 	void *ptr = NULL;
-	mm_chunk_t *chnk = NULL;
-	if (size == 0) {
-		return NULL;
+	if (fits) {
+		ptr = mm_heap_realloc_internal(&gs_memmgr, old_ptr, size, lr);
 	}
+	if (mm_traced()) {
+		MM_LATENCY_END(&gs_memmgr.latency, MM_LATENCY_REALLOC, start);
+	}
+#if MM_CFG_ZONE
+	if ((zone != NULL) && (ptr != NULL)) {
+		mm_zone_tag(zone, ptr, size);
+		if (size < old_size) {
+			mm_zone_cancel(zone, old_size - size, 0);
+		}
+	} else if ((zone != NULL) && (size == 0)) {
+		// the old block, if any, was freed
+		mm_zone_cancel(zone, old_size, (old_ptr != NULL));
+	} else if (zone != NULL) {
+		if (fits && (size > old_size)) {
+			mm_zone_cancel(zone, size - old_size, (old_ptr == NULL));
+		}
+		if (old_ptr != NULL) {
+			mm_zone_tag(zone, old_ptr, old_size);
+		}
+	}
+#endif
+#if MM_CFG_LEAK
+	if ((ptr != NULL) && mm_traced()) {
+		mm_leak_alloc(ptr, size, lr);
+	} else if (tagged && (size != 0)) {
+		// a failed realloc leaves the old block to its caller
+		mm_leak_alloc(old_ptr, tag.size, tag.site);
+	}
+#endif
+	// shrinking to 0 is traced by the free it ends up in
+	if ((ptr != NULL) && mm_traced()) {
+		MM_TRACE(MM_TRACE_REALLOC, ptr, old_ptr, size, lr);
+	}
+#if MM_CFG_PROFILE
+	if (mm_traced()) {
+		// a failed realloc leaves the old block allocated
+		mm_profile_block((ptr != NULL) ? ptr : (profiled ? old_ptr : NULL), true);
+	}
+#endif
+	return ptr;
+}
 
-	wanted_csize = mm_to_csize(size);
-	if (wanted_csize > CSIZE_MAX) {
-		return NULL;
+static void mm_free_impl(void *ptr)
+{
+	bool traced = mm_traced();
+	if (traced) {
+		MM_TRACE(MM_TRACE_FREE, ptr, NULL, 0, __builtin_return_address(0));
+#if MM_CFG_LEAK
+		mm_leak_free(ptr, NULL);
+#endif
+#if MM_CFG_ZONE
+		mm_zone_release(ptr);
+#endif
+#if MM_CFG_PROFILE
+		mm_profile_block(ptr, false);
+#endif
+	}
+	MM_LATENCY_START(start);
+	mm_free_cached(ptr);
+	if (traced) {
+		MM_LATENCY_END(&gs_memmgr.latency, MM_LATENCY_FREE, start);
 	}
+}
 
-	mm_lock();
-	chnk = mm_find_first_free(wanted_csize);
-	if (chnk != NULL) {
-		mm_chunk_t *new = mm_chunk_split(chnk, wanted_csize);
-		if (new != NULL) {
-			mm_chunk_t *next = mm_chunk_next_get(new);
-			if (mm_chunk_is_available(next)){
-				mm_chunk_merge(new);
-			}
+static void *mm_alloc_cached(uint32_t size, void *lr)
+{
+	// slots share the call site of their slab, a profile could not tell
+	// their callers apart
+#if MM_CFG_SLAB && !MM_CFG_PROFILE
+	if (size <= MM_CFG_SLAB_MAX_PAYLOAD) {
+		void *ptr = mm_slab_alloc(size, lr);
+		if (ptr != NULL) {
+			return ptr;
 		}
+	}
+#endif
+#if MM_CFG_TASK_CACHE
+	void *ptr = mm_cache_alloc(task_mm_cache_get(), size, lr);
+	if (ptr != NULL) {
+		return ptr;
+	}
+#endif
+	return mm_heap_alloc_uncached(&gs_memmgr, size, lr);
+}
 
-		chnk->allocated = true;
-		mm_chunk_guard_set(chnk, size);
-		chnk->allocator = __builtin_return_address(0);
-		chnk->xorsum = mm_chunk_xorsum(chnk);
-		ptr = mm_toptr(chnk);
+#if MM_CFG_ZONE
+/* over the budget of the zone of the caller, fail before looking at the heap */
+static void *mm_alloc_zoned(uint32_t size, void *lr)
+{
+	mm_zone_t *zone = mm_traced() ? mm_zone_current() : NULL;
+	if (zone == NULL) {
+		return mm_alloc_cached(size, lr);
+	}
+	if (!mm_zone_charge(zone, size, 1)) {
+		return NULL;
+	}
+	void *ptr = mm_alloc_cached(size, lr);
+	if (ptr == NULL) {
+		mm_zone_cancel(zone, size, 1);
+	} else {
+		mm_zone_tag(zone, ptr, size);
 	}
-	mm_unlock();
 	return ptr;
 }
+#endif
 
-static void *mm_zalloc_impl(uint32_t size)
+static void mm_free_cached(void *ptr)
+{
+#if MM_CFG_SLAB
+	if (mm_slab_free(ptr)) {
+		return;
+	}
+#endif
+#if MM_CFG_TASK_CACHE
+	if (mm_cache_free(task_mm_cache_get(), ptr)) {
+		return;
+	}
+#endif
+	mm_heap_free_uncached(&gs_memmgr, ptr);
+}
+
+/* a moving mm_realloc goes through mm_alloc and mm_free, trace it only once */
+static bool mm_traced(void)
+{
+#if MM_WATCHED
+	task_t *untraced = gs_memmgr.untraced;
+	return (untraced == NULL) || (untraced != task_self());
+#else
+	return false;
+#endif
+}
+
+static void mm_block_allocator_set(void *ptr, void *lr)
 {
 	mm_lock();
-	void *ptr = mm_alloc(size);
-	if (ptr != NULL) {
-		memset(ptr, 0, size);
-		mm_allocator_update(ptr);
+	// slots share the call site of their slab
+	if ((ptr != NULL) && (mm_slab_size(ptr) == 0)) {
+		mm_chunk_t *chnk = mm_tochunk(ptr);
+		mm_chunk_allocator_set(chnk, lr);
+		chnk->xorsum = mm_chunk_xorsum(chnk);
 	}
 	mm_unlock();
-	return ptr;
 }
 
-static void *mm_calloc_impl(uint32_t n, uint32_t size)
+#if MM_CFG_PROFILE
+/* account a block to the call site its chunk records */
+static void mm_profile_block(void *ptr, bool alloc)
 {
+	if (ptr == NULL) {
+		return;
+	}
 	mm_lock();
-	void *ptr = mm_zalloc(n * size);
-	if (ptr != NULL) {
-		mm_allocator_update(ptr);
+	// only slabs mm_attach adopted hand out slots in a profiling build
+	if (mm_slab_size(ptr) == 0) {
+		mm_chunk_t *chnk = mm_tochunk(ptr);
+		void *site = mm_chunk_allocator_get(chnk);
+		if (alloc) {
+			mm_profile_alloc(site, chnk->guard_offset);
+		} else {
+			mm_profile_free(site, chnk->guard_offset);
+		}
 	}
 	mm_unlock();
-	return ptr;
 }
+#endif
 
-static void *mm_realloc_impl(void *old_ptr, uint32_t size)
+/* free to the heap whose lock the caller holds */
+static void mm_free_locked(void *ptr)
+{
+	mm_chunk_t *chnk = mm_tochunk(ptr);
+	if (!chnk->allocated) {
+		die("MM: double free");
+	}
+
+	mm_chunk_allocated_set(chnk, false);
+	mm_chunk_allocator_set(chnk, NULL);
+	mm_chunk_guard_set(chnk, 0);
+	chnk->xorsum = mm_chunk_xorsum(chnk);
+
+	mm_chunk_t *sibbling = mm_chunk_next_get(chnk);
+	if (mm_chunk_is_available(sibbling)) {
+		mm_chunk_merge(chnk);
+	}
+	sibbling = mm_chunk_prev_get(chnk);
+	if (mm_chunk_is_available(sibbling)) {
+		mm_chunk_merge(sibbling);
+	}
+}
+
+/* get a region from the OS hook, big enough for a chunk of csize */
+static bool mm_heap_grow(mm_heap_t *this, uint32_t csize)
+{
+	if ((this != &gs_memmgr) || (gs_region_get == NULL)) {
+		return false;
+	}
+
+	// right after the highest region, links count from the first one
+	mm_boundary_t *boundary = &mm_chunk_ctx_get()->boundary;
+	uintptr_t hint = 0;
+	for (uint32_t i = 0; i < boundary->region_count; i++) {
+		mm_chunk_t *last = boundary->regions[i].last;
+		uintptr_t end = (uintptr_t)mm_compute_next(last, last->csize);
+		if (end > hint) {
+			hint = end;
+		}
+	}
+
+	uint32_t size = umax(MM_CFG_REGION_SIZE, csize * MM_CFG_ALIGNMENT);
+	void *region = gs_region_get((void *)hint, &size);
+	if (region == NULL) {
+		return false;
+	}
+	if (!mm_chunk_region_add(region, size / MM_CFG_ALIGNMENT, true)) {
+		if (gs_region_put != NULL) {
+			gs_region_put(region, size);
+		}
+		return false;
+	}
+	return true;
+}
+
+static int mm_ptr_cmp(const void *a, const void *b)
+{
+	uintptr_t pa = (uintptr_t)*(void * const *)a;
+	uintptr_t pb = (uintptr_t)*(void * const *)b;
+	return (pa > pb) - (pa < pb);
+}
+
+static void mm_heap_prepare(mm_heap_t *this, uint8_t *buffer)
+{
+	this->heap = buffer;
+	this->mtx = NULL;
+	this->saved = NULL;
+	this->depth = 0;
+	this->owner = NULL;
+	this->untraced = NULL;
+	this->zero = false;
+	this->zeroed = NULL;
+	mm_remote_init(&this->remote);
+#if MM_CFG_LATENCY
+	mm_latency_init(&this->latency);
+#endif
+}
+
+static void mm_heap_setup(mm_heap_t *this, uint8_t *buffer, uint32_t size)
+{
+	mm_heap_prepare(this, buffer);
+
+	mm_heap_lock(this);
+	mm_chunk_t *chnk = (mm_chunk_t *)buffer;
+
+	uint32_t count = 0;
+	mm_chunk_t *first = chnk;
+	mm_chunk_t *prev = NULL;
+	uint32_t heap_size = size/MM_CFG_ALIGNMENT;
+
+	while (heap_size >= mm_min_csize()) {
+		mm_csize_t size = umin(heap_size, CSIZE_MAX);
+		heap_size -= size;
+
+		mm_chunk_init(chnk, prev, size);
+		count++;
+
+		prev = chnk;
+		chnk = mm_compute_next(chnk, chnk->csize);
+	}
+	mm_chunk_boundary_set(first, prev, count);
+	mm_heap_unlock(this);
+}
+
+/* the default heap goes through the mockable, cached entry points */
+static void *mm_heap_alloc_any(mm_heap_t *this, uint32_t size)
+{
+	if (this == &gs_memmgr) {
+		return mm_alloc(size);
+	}
+	return mm_heap_alloc_uncached(this, size, __builtin_return_address(0));
+}
+
+static void mm_heap_free_any(mm_heap_t *this, void *ptr)
+{
+	if (this == &gs_memmgr) {
+		mm_free(ptr);
+	} else {
+		mm_heap_free_uncached(this, ptr);
+	}
+}
+
+static void *mm_heap_realloc_internal(mm_heap_t *this, void *old_ptr,
+				      uint32_t size, void *lr)
 {
 	int32_t wanted_csize = 0;
-	mm_chunk_t *this = NULL;
+	mm_chunk_t *chnk = NULL;
 	void *new_ptr = NULL;
 
 	if (size == 0) {
 		if (old_ptr != NULL) {
-			mm_free(old_ptr);
+			mm_heap_free_any(this, old_ptr);
 		}
 		return NULL;
 	}
@@ -147,49 +498,80 @@ static void *mm_realloc_impl(void *old_ptr, uint32_t size)
 	}
 
 	if (old_ptr == NULL) {
-		new_ptr = mm_alloc_impl(size);
-		mm_lock();
-		this = mm_tochunk(new_ptr);
+		new_ptr = (this == &gs_memmgr) ? mm_alloc_cached(size, lr) :
+			  mm_heap_alloc_uncached(this, size, lr);
+		if (this == &gs_memmgr) {
+			mm_block_allocator_set(new_ptr, lr);
+			return new_ptr;
+		}
+		mm_heap_lock(this);
+		chnk = mm_tochunk(new_ptr);
 
-		this->allocator = __builtin_return_address(1);
-		this->xorsum = mm_chunk_xorsum(this);
-		mm_unlock();
+		mm_chunk_allocator_set(chnk, lr);
+		chnk->xorsum = mm_chunk_xorsum(chnk);
+		mm_heap_unlock(this);
 		return new_ptr;
 	}
 
-	mm_lock();
-	this = mm_tochunk(old_ptr);
+#if MM_CFG_SLAB
+	uint32_t slot_size = (this == &gs_memmgr) ? mm_slab_size(old_ptr) : 0;
+	if (slot_size >= size) {
+		return old_ptr;
+	} else if (slot_size != 0) {
+		new_ptr = mm_alloc_cached(size, lr);
+		if (new_ptr != NULL) {
+			memcpy(new_ptr, old_ptr, slot_size);
+			mm_slab_free(old_ptr);
+		}
+		return new_ptr;
+	}
+#endif
+
+	mm_heap_lock(this);
+	chnk = mm_tochunk(old_ptr);
 
-	if (wanted_csize > this->csize) {
-		mm_chunk_t *next = mm_chunk_next_get(this);
-		mm_chunk_t *prev = mm_chunk_prev_get(this);
+	if (wanted_csize > chnk->csize) {
+		mm_chunk_t *next = mm_chunk_next_get(chnk);
+		mm_chunk_t *prev = mm_chunk_prev_get(chnk);
 
 		uint32_t prev_csize = mm_chunk_available_csize(prev);
 		uint32_t next_csize = mm_chunk_available_csize(next);
 
-		if (mm_validate_csize(wanted_csize, this->csize + next_csize)) {
-			mm_chunk_merge(this);
-		} else if (mm_validate_csize(wanted_csize, prev_csize + this->csize)) {
+		if (mm_validate_csize(wanted_csize, chnk->csize + next_csize)) {
+			mm_chunk_merge(chnk);
+		} else if (mm_validate_csize(wanted_csize, prev_csize + chnk->csize)) {
 			mm_chunk_merge(prev);
-			this = prev;
-			old_ptr = mm_toptr(this);
-		} else if (mm_validate_csize(wanted_csize, prev_csize + this->csize + next_csize)) {
-			mm_chunk_merge(this);
+			chnk = prev;
+			old_ptr = mm_toptr(chnk);
+		} else if (mm_validate_csize(wanted_csize, prev_csize + chnk->csize + next_csize)) {
+			mm_chunk_merge(chnk);
 			mm_chunk_merge(prev);
-			this = prev;
-			old_ptr = mm_toptr(this);
+			chnk = prev;
+			old_ptr = mm_toptr(chnk);
 		}
 	}
 
-	if (wanted_csize > this->csize) {
-		new_ptr = mm_alloc(size);
+	if (wanted_csize > chnk->csize) {
+#if MM_WATCHED
+		task_t *untraced = this->untraced;
+		this->untraced = task_self();
+#endif
+		new_ptr = mm_heap_alloc_any(this, size);
 		if (new_ptr != NULL) {
-			memcpy(new_ptr, old_ptr, umin(this->guard_offset, size));
-			this = mm_tochunk(new_ptr);
-			mm_free(old_ptr);
+			memcpy(new_ptr, old_ptr, umin(chnk->guard_offset, size));
+			mm_heap_free_any(this, old_ptr);
+#if MM_CFG_SLAB
+			// a slot keeps the call site of its slab
+			chnk = (mm_slab_size(new_ptr) != 0) ? NULL : mm_tochunk(new_ptr);
+#else
+			chnk = mm_tochunk(new_ptr);
+#endif
 		}
+#if MM_WATCHED
+		this->untraced = untraced;
+#endif
 	} else {
-		mm_chunk_t *new = mm_chunk_split(this, wanted_csize);
+		mm_chunk_t *new = mm_chunk_split(chnk, wanted_csize);
 		if (new != NULL) {
 			mm_chunk_t *next = mm_chunk_next_get(new);
 			if (mm_chunk_is_available(next)) {
@@ -199,87 +581,550 @@ static void *mm_realloc_impl(void *old_ptr, uint32_t size)
 		new_ptr = old_ptr;
 	}
 
-	if (new_ptr != NULL) {
-		mm_chunk_guard_set(this, size);
-		this->allocator = __builtin_return_address(1);
-		this->xorsum = mm_chunk_xorsum(this);
+	if ((new_ptr != NULL) && (chnk != NULL)) {
+		mm_chunk_guard_set(chnk, size);
+		mm_chunk_allocator_set(chnk, lr);
+		chnk->xorsum = mm_chunk_xorsum(chnk);
+		mm_chunk_stats_peak();
 	}
 
-	mm_unlock();
+	mm_heap_unlock(this);
 	return new_ptr;
 }
 
-static void mm_free_impl(void *ptr)
+/* Functions definitions -----------------------------------------------------*/
+void mm_heap_lock(mm_heap_t *this)
 {
-	mm_lock();
-	if (ptr != NULL) {
-		mm_chunk_t *chnk = mm_tochunk(ptr);
-		if (!chnk->allocated) {
-			die("MM: double free");
+	if (this->mtx != NULL) {
+		MM_LATENCY_START(start);
+		mutex_lock(this->mtx, -1);
+		// only the outermost lock may wait
+		if (this->depth == 0) {
+			MM_LATENCY_END(&this->latency, MM_LATENCY_WAIT, start);
 		}
+	}
+	if (this->depth++ == 0) {
+		this->saved = mm_chunk_ctx_get();
+		mm_chunk_ctx_set(this->ctx);
+	}
+}
 
-		chnk->allocated = false;
-		chnk->allocator = NULL;
-		mm_chunk_guard_set(chnk, 0);
-		chnk->xorsum = mm_chunk_xorsum(chnk);
+bool mm_heap_trylock(mm_heap_t *this)
+{
+	if (this->mtx != NULL) {
+		MM_LATENCY_START(start);
+		if (!mutex_lock(this->mtx, 0)) {
+			return false;
+		}
+		if (this->depth == 0) {
+			MM_LATENCY_END(&this->latency, MM_LATENCY_WAIT, start);
+		}
+	}
+	if (this->depth++ == 0) {
+		this->saved = mm_chunk_ctx_get();
+		mm_chunk_ctx_set(this->ctx);
+	}
+	return true;
+}
 
-		mm_chunk_t *sibbling = mm_chunk_next_get(chnk);
-		if (mm_chunk_is_available(sibbling)) {
-			mm_chunk_merge(chnk);
+void mm_heap_unlock(mm_heap_t *this)
+{
+	if (--this->depth == 0) {
+		mm_chunk_ctx_set(this->saved);
+	}
+	if (this->mtx != NULL) {
+		mutex_unlock(this->mtx);
+	}
+}
+
+void mm_lock(void)
+{
+	mm_heap_lock(&gs_memmgr);
+}
+
+void mm_unlock(void)
+{
+	mm_heap_unlock(&gs_memmgr);
+}
+
+void *mm_heap_alloc_uncached(mm_heap_t *this, uint32_t size, void *lr)
+{
+	int32_t wanted_csize = 0;
+	void *ptr = NULL;
+	mm_chunk_t *chnk = NULL;
+	if (size == 0) {
+		return NULL;
+	}
+
+	wanted_csize = mm_to_csize(size);
+	if (wanted_csize > CSIZE_MAX) {
+		return NULL;
+	}
+
+	mm_heap_lock(this);
+	mm_heap_remote_drain(this);
+	chnk = mm_find_first_free(wanted_csize);
+	if ((chnk == NULL) && mm_heap_grow(this, wanted_csize)) {
+		chnk = mm_find_first_free(wanted_csize);
+	}
+#if MM_CFG_RECLAIM
+	if ((chnk == NULL) && (this == &gs_memmgr)) {
+		chnk = mm_reclaim_run(wanted_csize);
+	}
+#endif
+	if (chnk != NULL) {
+		mm_chunk_t *new = mm_chunk_split(chnk, wanted_csize);
+		if (new != NULL) {
+			mm_chunk_t *next = mm_chunk_next_get(new);
+			if (mm_chunk_is_available(next)){
+				mm_chunk_merge(new);
+			}
 		}
-		sibbling = mm_chunk_prev_get(chnk);
-		if (mm_chunk_is_available(sibbling)) {
-			mm_chunk_merge(sibbling);
+
+		bool zeroed = mm_chunk_zeroed_get(chnk);
+		mm_chunk_allocated_set(chnk, true);
+		ptr = mm_toptr(chnk);
+		if (this->zero) {
+			mm_chunk_clear(chnk, size, zeroed);
+			this->zero = false;
+			this->zeroed = ptr;
 		}
+		mm_chunk_guard_set(chnk, size);
+		mm_chunk_allocator_set(chnk, lr);
+		chnk->xorsum = mm_chunk_xorsum(chnk);
 	}
-	mm_unlock();
+	mm_heap_unlock(this);
+	return ptr;
 }
 
-/* Functions definitions -----------------------------------------------------*/
-void mm_init(uint8_t *heap, uint32_t size)
+void mm_heap_free_uncached(mm_heap_t *this, void *ptr)
 {
-	gs_memmgr.heap = heap;
-	mm_chunk_t *chnk = (mm_chunk_t *)heap;
+	if (ptr == NULL) {
+		return;
+	}
+	bool foreign = (this->owner != NULL) && (this->owner != task_self());
+	if (foreign || !mm_heap_trylock(this)) {
+		if (mm_heap_remote_push(this, ptr)) {
+			return;
+		}
+		mm_heap_lock(this);
+	}
+	mm_free_locked(ptr);
+	mm_heap_unlock(this);
+#if MM_CFG_RECLAIM
+	if (this == &gs_memmgr) {
+		mm_reclaim_rearm();
+	}
+#endif
+}
 
-	uint32_t count = 0;
-	mm_chunk_t *first = chnk;
-	mm_chunk_t *prev = NULL;
-	uint32_t heap_size = size/MM_CFG_ALIGNMENT;
+bool mm_heap_remote_push(mm_heap_t *this, void *ptr)
+{
+	// the block is ours until freed, its payload can hold the link; the
+	// heap validates it when it drains the list
+	mm_chunk_t *chnk = mm_chunk_owned(ptr);
+	if (chnk->guard_offset < sizeof(mm_remote_node_t)) {
+		return false;
+	}
+	mm_remote_push(&this->remote, ptr, ptr);
+	return true;
+}
 
-	while (heap_size >= mm_min_csize()) {
-		uint16_t size = umin(heap_size, CSIZE_MAX);
-		heap_size -= size;
+void mm_heap_remote_drain(mm_heap_t *this)
+{
+	mm_remote_node_t *node = mm_remote_take(&this->remote);
+	while (node != NULL) {
+		mm_remote_node_t *next = node->next;
+		mm_free_locked(node);
+		node = next;
+	}
+}
 
-		mm_chunk_init(chnk, prev, size);
-		count++;
+void *mm_alloc_uncached(uint32_t size, void *lr)
+{
+	return mm_heap_alloc_uncached(&gs_memmgr, size, lr);
+}
 
-		prev = chnk;
-		chnk = mm_compute_next(chnk, chnk->csize);
+void mm_free_uncached(void *ptr)
+{
+	mm_heap_free_uncached(&gs_memmgr, ptr);
+}
+
+void mm_init(uint8_t *heap, uint32_t size)
+{
+	gs_memmgr.mtx = NULL;
+	gs_memmgr.ctx = mm_chunk_ctx_default();
+	mm_pool_forget_all();
+	mm_slab_forget_all();
+#if MM_CFG_TASK_CACHE
+	// the chunks cached by the caller belonged to the previous heap
+	if (task_mm_cache_get() != NULL) {
+		mm_cache_init(task_mm_cache_get());
 	}
-	mm_chunk_boundary_set(first, prev, count);
+#endif
+#if MM_CFG_PROFILE
+	mm_profile_reset();
+#endif
+#if MM_CFG_LEAK
+	mm_leak_reset();
+#endif
+#if MM_CFG_ZONE
+	mm_zone_reset();
+#endif
+#if MM_CFG_RECLAIM
+	mm_reclaim_reset();
+#endif
+
+	mm_heap_setup(&gs_memmgr, heap, size);
 	gs_memmgr.mtx = mutex_new(false, "memmgr");
+#if MM_CFG_RECLAIM
+	mm_reserve_set(MM_CFG_RECLAIM_RESERVE);
+#endif
 }
 
-void mm_check(void)
+bool mm_attach(uint8_t *heap, uint32_t size, const uint8_t *origin)
+{
+	gs_memmgr.ctx = mm_chunk_ctx_default();
+	mm_pool_forget_all();
+	mm_slab_forget_all();
+#if MM_CFG_TASK_CACHE
+	// the chunks cached by the caller belonged to the previous heap
+	if (task_mm_cache_get() != NULL) {
+		mm_cache_init(task_mm_cache_get());
+	}
+#endif
+#if MM_CFG_PROFILE
+	mm_profile_reset();
+#endif
+#if MM_CFG_LEAK
+	mm_leak_reset();
+#endif
+#if MM_CFG_ZONE
+	mm_zone_reset();
+#endif
+#if MM_CFG_RECLAIM
+	mm_reclaim_reset();
+#endif
+	mm_heap_prepare(&gs_memmgr, heap);
+
+	mm_heap_lock(&gs_memmgr);
+	bool attached = mm_chunk_attach((mm_chunk_t *)heap, size/MM_CFG_ALIGNMENT,
+					(origin != NULL) ? origin : heap);
+	if (attached) {
+		mm_slab_adopt_all();
+	}
+	mm_heap_unlock(&gs_memmgr);
+
+	if (attached) {
+		gs_memmgr.mtx = mutex_new(false, "memmgr");
+	}
+	return attached;
+}
+
+void mm_detach(void)
 {
+#if MM_CFG_RECLAIM
+	// a later mm_attach would take the reserve for a block of the program
+	mm_reserve_set(0);
+#endif
 	mm_lock();
-	mm_chunk_t *chnk = (mm_chunk_t *)gs_memmgr.heap;
-	mm_chunk_validate(chnk);
+	mm_heap_remote_drain(&gs_memmgr);
+	mm_unlock();
+
+	// the mutex lives in a pool block, from now on nothing else may run
+	gs_memmgr.mtx = NULL;
+	mm_pool_release_all();
+#if MM_CFG_TASK_CACHE
+	mm_cache_drain(task_mm_cache_get());
+#endif
+}
+
+bool mm_add_region(uint8_t *region, uint32_t size)
+{
+	mm_lock();
+	bool added = mm_chunk_region_add(region, size / MM_CFG_ALIGNMENT, false);
+	mm_unlock();
+	return added;
+}
+
+void mm_region_hooks_set(mm_region_get_f get, mm_region_put_f put)
+{
+	mm_lock();
+	gs_region_get = get;
+	gs_region_put = put;
+	mm_unlock();
+}
+
+mm_heap_t *mm_heap_init(uint8_t *buffer, uint32_t size)
+{
+	uint32_t desc_size = ((sizeof(mm_heap_desc_t) + MM_CFG_ALIGNMENT - 1) /
+			      MM_CFG_ALIGNMENT) * MM_CFG_ALIGNMENT;
+	if ((buffer == NULL) ||
+	    (size < desc_size + (mm_min_csize() * MM_CFG_ALIGNMENT))) {
+		return NULL;
+	}
+
+	mm_heap_desc_t *desc = (mm_heap_desc_t *)buffer;
+	memset(desc, 0, sizeof(mm_heap_desc_t));
+	desc->heap.ctx = &desc->ctx;
+	mm_heap_setup(&desc->heap, buffer + desc_size, size - desc_size);
+
+	desc->heap.mtx = mutex_new(false, "memmgr heap");
+	if (desc->heap.mtx == NULL) {
+		return NULL;
+	}
+	desc->heap.owner = task_self();
+	return &desc->heap;
+}
+
+void mm_heap_owner_set(mm_heap_t *this, task_t *owner)
+{
+	mm_heap_lock(this);
+	this->owner = owner;
+	mm_heap_unlock(this);
+}
+
+void mm_heap_release(mm_heap_t *this)
+{
+	if ((this == NULL) || (this == &gs_memmgr)) {
+		return;
+	}
+	if (this->mtx != NULL) {
+		object_delete(&this->mtx->base);
+		this->mtx = NULL;
+	}
+}
+
+mm_heap_t *mm_heap_default(void)
+{
+	return &gs_memmgr;
+}
+
+void *mm_heap_alloc(mm_heap_t *this, uint32_t size)
+{
+	MM_LATENCY_START(start);
+	void *ptr = mm_heap_alloc_uncached(this, size, __builtin_return_address(0));
+	MM_LATENCY_END(&this->latency, MM_LATENCY_ALLOC, start);
+	return ptr;
+}
+
+void *mm_heap_zalloc(mm_heap_t *this, uint32_t size)
+{
+	MM_LATENCY_START(start);
+	mm_heap_lock(this);
+	this->zero = true;
+	void *ptr = mm_heap_alloc_uncached(this, size, __builtin_return_address(0));
+	this->zero = false;
+	mm_heap_unlock(this);
+	MM_LATENCY_END(&this->latency, MM_LATENCY_ALLOC, start);
+	return ptr;
+}
+
+void *mm_heap_realloc(mm_heap_t *this, void *ptr, uint32_t size)
+{
+	MM_LATENCY_START(start);
+	void *new_ptr = mm_heap_realloc_internal(this, ptr, size,
+						 __builtin_return_address(0));
+	MM_LATENCY_END(&this->latency, MM_LATENCY_REALLOC, start);
+	return new_ptr;
+}
+
+void mm_heap_free(mm_heap_t *this, void *ptr)
+{
+	MM_LATENCY_START(start);
+#if MM_CFG_SLAB
+	if ((this == &gs_memmgr) && mm_slab_free(ptr)) {
+		MM_LATENCY_END(&this->latency, MM_LATENCY_FREE, start);
+		return;
+	}
+#endif
+	mm_heap_free_uncached(this, ptr);
+	MM_LATENCY_END(&this->latency, MM_LATENCY_FREE, start);
+}
+
+void mm_heap_check(mm_heap_t *this)
+{
+	mm_heap_lock(this);
+	mm_chunk_t *chnk = (mm_chunk_t *)this->heap;
 	while (chnk != NULL) {
-		chnk = mm_chunk_next_get(chnk);
+		mm_chunk_validate(chnk);
+		chnk = mm_chunk_walk_next(chnk);
+	}
+	mm_heap_unlock(this);
+}
+
+void mm_check(void)
+{
+	mm_heap_check(&gs_memmgr);
+}
+
+void mm_heap_stats_get(mm_heap_t *this, mm_stats_t *stats)
+{
+	mm_heap_lock(this);
+	mm_chunk_stats_t *cstats = &mm_chunk_ctx_get()->stats;
+	stats->heap_size = cstats->total_csize * MM_CFG_ALIGNMENT;
+	stats->free_size = cstats->free_csize * MM_CFG_ALIGNMENT;
+	stats->largest_free = cstats->largest_csize * MM_CFG_ALIGNMENT;
+	stats->free_count = cstats->free_count;
+	stats->peak_used = cstats->peak_used_csize * MM_CFG_ALIGNMENT;
+	stats->fragmentation = 0;
+	if (cstats->free_csize != 0) {
+		uint64_t scattered = cstats->free_csize - cstats->largest_csize;
+		stats->fragmentation = (scattered * 1000) / cstats->free_csize;
 	}
+	mm_heap_unlock(this);
+}
+
+void mm_stats_get(mm_stats_t *stats)
+{
+	mm_heap_stats_get(&gs_memmgr, stats);
+}
+
+uint32_t mm_alloc_batch(uint32_t n, const uint32_t *sizes, void **out)
+{
+	void *lr = __builtin_return_address(0);
+	uint32_t total = 0;
+	uint32_t done = 0;
+	uint32_t i = 0;
+
+	for (i = 0; i < n; i++) {
+		out[i] = NULL;
+		if (sizes[i] != 0) {
+			total += mm_to_csize(sizes[i]);
+		}
+	}
+
+	mm_lock();
+	mm_heap_remote_drain(&gs_memmgr);
+	// carve everything from one free chunk when there is one big enough
+	mm_chunk_t *chnk = NULL;
+	if ((total != 0) && (total <= CSIZE_MAX)) {
+		chnk = mm_find_first_free(total);
+	}
+	if (chnk != NULL) {
+		for (i = 0; i < n; i++) {
+			if (sizes[i] == 0) {
+				continue;
+			}
+			mm_chunk_t *rest = mm_chunk_split(chnk, mm_to_csize(sizes[i]));
+			mm_chunk_allocated_set(chnk, true);
+			mm_chunk_guard_set(chnk, sizes[i]);
+			mm_chunk_allocator_set(chnk, lr);
+			chnk->xorsum = mm_chunk_xorsum(chnk);
+			out[i] = mm_toptr(chnk);
+			done ++;
+			chnk = rest;
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			if (sizes[i] != 0) {
+				out[i] = mm_alloc_uncached(sizes[i], lr);
+				done += (out[i] != NULL);
+			}
+		}
+	}
+#if MM_CFG_ZONE
+	// blocks over the budget of the zone of the caller go back to the heap
+	mm_zone_t *zone = mm_zone_current();
+	for (i = 0; (zone != NULL) && (i < n); i++) {
+		if (out[i] == NULL) {
+			continue;
+		}
+		if (mm_zone_charge(zone, sizes[i], 1)) {
+			mm_zone_tag(zone, out[i], sizes[i]);
+		} else {
+			mm_free_uncached(out[i]);
+			out[i] = NULL;
+			done--;
+		}
+	}
+#endif
+#if MM_CFG_TRACE || MM_CFG_PROFILE || MM_CFG_LEAK
+	for (i = 0; i < n; i++) {
+		if (out[i] != NULL) {
+			MM_TRACE(MM_TRACE_ALLOC, out[i], NULL, sizes[i], lr);
+#if MM_CFG_LEAK
+			mm_leak_alloc(out[i], sizes[i], lr);
+#endif
+#if MM_CFG_PROFILE
+			mm_profile_block(out[i], true);
+#endif
+		}
+	}
+#endif
 	mm_unlock();
+	return done;
 }
 
-void mm_allocator_set(void *ptr, void *lr)
+void mm_free_batch(void **ptrs, uint32_t n)
 {
+	uint32_t i = 0;
+
+#if MM_WATCHED
+	// every block is seen, slots included, before the heap lock is taken
+	for (uint32_t j = 0; j < n; j++) {
+		if (ptrs[j] == NULL) {
+			continue;
+		}
+		MM_TRACE(MM_TRACE_FREE, ptrs[j], NULL, 0, __builtin_return_address(0));
+#if MM_CFG_LEAK
+		mm_leak_free(ptrs[j], NULL);
+#endif
+#if MM_CFG_ZONE
+		mm_zone_release(ptrs[j]);
+#endif
+#if MM_CFG_PROFILE
+		mm_profile_block(ptrs[j], false);
+#endif
+	}
+#endif
+#if MM_CFG_SLAB
+	for (uint32_t j = 0; j < n; j++) {
+		if (mm_slab_free(ptrs[j])) {
+			ptrs[j] = NULL;
+		}
+	}
+#endif
+#if MM_CFG_TASK_CACHE
+	// a chunk mm_free kept in the cache is still allocated in the heap, only
+	// chunks are left to look at
+	for (uint32_t j = 0; j < n; j++) {
+		if (mm_cache_holds(task_mm_cache_get(), ptrs[j])) {
+			die("MM: double free");
+		}
+	}
+#endif
+	// neighbours end up next to each other and get freed as one chunk
+	qsort(ptrs, n, sizeof(void *), mm_ptr_cmp);
+	while ((i < n) && (ptrs[i] == NULL)) {
+		i++;
+	}
+
 	mm_lock();
-	if (ptr != NULL) {
-		mm_chunk_t *chnk = mm_tochunk(ptr);
-		chnk->allocator = lr;
-		chnk->xorsum = mm_chunk_xorsum(chnk);
+	while (i < n) {
+		i += mm_chunk_free_run(&ptrs[i], n - i);
 	}
 	mm_unlock();
+#if MM_CFG_RECLAIM
+	mm_reclaim_rearm();
+#endif
+}
+
+void mm_allocator_set(void *ptr, void *lr)
+{
+#if MM_CFG_LEAK
+	mm_leak_site_set(ptr, lr);
+#endif
+#if MM_CFG_PROFILE
+	// the block moves over to its new call site
+	mm_lock();
+	mm_profile_block(ptr, false);
+	mm_block_allocator_set(ptr, lr);
+	mm_profile_block(ptr, true);
+	mm_unlock();
+#else
+	mm_block_allocator_set(ptr, lr);
+#endif
 }
 
 mm_info_t *mm_info_get(void)
@@ -289,15 +1134,15 @@ mm_info_t *mm_info_get(void)
 	if (infos != NULL) {
 		mm_info_t *it = infos;
 		mm_chunk_t *chnk = (mm_chunk_t *)gs_memmgr.heap;
-		mm_chunk_validate(chnk);
 		while (chnk != NULL) {
+			mm_chunk_validate(chnk);
 			it->allocated = chnk->allocated;
-			it->allocator = chnk->allocator;
+			it->allocator = mm_chunk_allocator_get(chnk);
 			it->csize = chnk->csize;
 			it->size = chnk->guard_offset;
 
 			it++;
-			chnk = mm_chunk_next_get(chnk);
+			chnk = mm_chunk_walk_next(chnk);
 		}
 	}
 	mm_unlock();
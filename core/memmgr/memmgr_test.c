@@ -25,11 +25,14 @@
 #include "tests/chunk_test_tools.h"
 #include "tests/memmgr_mock.h"
 #include "memmgr/chunk.h"
+#include "memmgr/handle.h"
+#include "memmgr/heap.h"
 #include "os/memmgr.h"
 #include "memmgr_conf.h"
 
 /* helpers -------------------------------------------------------------------*/
 #define			DEFAULT_SIZE		(11)
+#define			ATTACH_SIZE		(64*1024)
 
 static void *		mock_zalloc		(uint32_t size);
 static void		mock_zalloc_Setup	(void);
@@ -40,6 +43,15 @@ static void		eval_mm_info		(mm_info_t *expect,
 
 static uint8_t gs_heap[1024*1024];
 
+/* a heap that big is cut in chunks of CSIZE_MAX, wide headers take it whole */
+#if MM_CFG_WIDE_HEADER
+#define HEAP_FIRST_CSIZE	(sizeof(gs_heap) / MM_CFG_ALIGNMENT)
+#define HEAP_NEXT_CSIZE		(0)
+#else
+#define HEAP_FIRST_CSIZE	(CSIZE_MAX)
+#define HEAP_NEXT_CSIZE		(CSIZE_MAX)
+#endif
+
 static struct
 {
 	bool	 expect_call;
@@ -78,7 +90,7 @@ static void eval_mm_info(mm_info_t *expect, mm_info_t *val, uint32_t len)
 	uint32_t i = 0;
 	for(; i < len; i++)
 	{
-		TEST_ASSERT_EQUAL_UINT16(expect[i].csize, val->csize);
+		TEST_ASSERT_EQUAL_UINT32(expect[i].csize, val->csize);
 		TEST_ASSERT_EQUAL_UINT32(expect[i].size, val->size);
 		TEST_ASSERT_EQUAL(expect[i].allocated, val->allocated);
 		val++;
@@ -87,6 +99,23 @@ static void eval_mm_info(mm_info_t *expect, mm_info_t *val, uint32_t len)
 }
 
 /* Test group definitions ----------------------------------------------------*/
+static void *		gs_region_next = NULL;
+static void *		gs_region_put_last = NULL;
+
+static void *fake_region_get(void *hint, uint32_t *size)
+{
+	(void)hint;
+	void *region = gs_region_next;
+	gs_region_next = NULL;
+	return region;
+}
+
+static void fake_region_put(void *region, uint32_t size)
+{
+	(void)size;
+	gs_region_put_last = region;
+}
+
 TEST_GROUP(memmgr);
 
 TEST_GROUP_RUNNER(memmgr)
@@ -94,6 +123,23 @@ TEST_GROUP_RUNNER(memmgr)
 	RUN_TEST_GROUP(memmgr_alloc);
 	RUN_TEST_GROUP(memmgr_free);
 	RUN_TEST_GROUP(memmgr_realloc);
+	RUN_TEST_GROUP(memmgr_batch);
+	RUN_TEST_GROUP(memmgr_heap);
+	RUN_TEST_GROUP(mm_arena);
+	RUN_TEST_GROUP(mm_cache);
+	RUN_TEST_GROUP(mm_handle);
+	RUN_TEST_GROUP(mm_latency);
+	RUN_TEST_GROUP(mm_leak);
+	RUN_TEST_GROUP(mm_pool);
+#if MM_CFG_PROFILE
+	RUN_TEST_GROUP(mm_profile);
+#endif
+	RUN_TEST_GROUP(mm_reclaim);
+	RUN_TEST_GROUP(mm_remote);
+	RUN_TEST_GROUP(mm_scrub);
+	RUN_TEST_GROUP(mm_slab);
+	RUN_TEST_GROUP(mm_trace);
+	RUN_TEST_GROUP(mm_zone);
 
 	RUN_TEST_CASE(memmgr, allocator_set);
 	RUN_TEST_CASE(memmgr, allocator_set_null_does_not_hurt);
@@ -106,7 +152,19 @@ TEST_GROUP_RUNNER(memmgr)
 
 	RUN_TEST_CASE(memmgr, init);
 	RUN_TEST_CASE(memmgr, check);
+	RUN_TEST_CASE(memmgr, alloc_above_128k);
+	RUN_TEST_CASE(memmgr, halloc_null_selects_the_default_heap);
+	RUN_TEST_CASE(memmgr, attach_keeps_allocations);
+	RUN_TEST_CASE(memmgr, attach_moved_heap);
+	RUN_TEST_CASE(memmgr, attach_rejects_corruption);
+	RUN_TEST_CASE(memmgr, detach_releases_pools);
+	RUN_TEST_CASE(memmgr, add_region_grows_heap);
+	RUN_TEST_CASE(memmgr, region_hooks_grow_heap);
+	RUN_TEST_CASE(memmgr, region_hooks_put_refused);
+	RUN_TEST_CASE(memmgr, zalloc_from_zeroed_region);
+	RUN_TEST_CASE(memmgr, zalloc_reused_chunk);
 	RUN_TEST_CASE(memmgr, info)
+	RUN_TEST_CASE(memmgr, stats_follow_allocations);
 }
 
 TEST_SETUP(memmgr)
@@ -124,18 +182,19 @@ TEST_TEAR_DOWN(memmgr)
 /* Tests ---------------------------------------------------------------------*/
 TEST(memmgr, allocator_set)
 {
-	void *ptr = mm_alloc(DEFAULT_SIZE);
+	// a slot has no chunk of its own to record the call site
+	void *ptr = mm_alloc(CHUNK_TEST_UNCACHED);
 	void *lr = __builtin_return_address(0);
 	mm_chunk_t *chnk = mm_tochunk(ptr);
 
 	mm_allocator_set(ptr, lr);
 
 	mm_chunk_validate(chnk);
-	TEST_ASSERT_EQUAL_PTR(lr, chnk->allocator);
+	TEST_ASSERT_EQUAL_PTR(lr, mm_chunk_allocator_get(chnk));
 
 	mm_allocator_set(ptr, NULL);
 	mm_chunk_validate(chnk);
-	TEST_ASSERT_EQUAL_PTR(NULL, chnk->allocator);
+	TEST_ASSERT_EQUAL_PTR(NULL, mm_chunk_allocator_get(chnk));
 }
 
 TEST(memmgr, allocator_set_null_does_not_hurt)
@@ -183,16 +242,22 @@ TEST(memmgr, calloc_zalloc_failed)
 
 TEST(memmgr, init)
 {
+	uint32_t info_csize = mm_to_csize(224);
+#if MM_CFG_WIDE_HEADER
+	chunk_test_state_t a_expect[] = {
+			{info_csize, true}, {HEAP_FIRST_CSIZE-info_csize, false}};
+#else
 	chunk_test_state_t a_expect[] = {
-			{19, true}, {CSIZE_MAX-19, false},
+			{info_csize, true}, {CSIZE_MAX-info_csize, false},
 			{CSIZE_MAX, false}, {CSIZE_MAX, false},
 			{CSIZE_MAX, false}, {CSIZE_MAX, false},
 			{CSIZE_MAX, false}, {CSIZE_MAX, false},
 			{CSIZE_MAX, false}, {8, false}};
+#endif
 	UT_PTR_SET(g_first, gs_heap);
 
 	mm_init(gs_heap, 1024*1024);
-	chunk_test_verify(a_expect, 10);
+	chunk_test_verify(a_expect, sizeof(a_expect) / sizeof(a_expect[0]));
 }
 
 TEST(memmgr, check)
@@ -201,34 +266,215 @@ TEST(memmgr, check)
 	mm_check();
 }
 
+TEST(memmgr, alloc_above_128k)
+{
+	uint32_t size = 200 * 1024;
+	mm_init(gs_heap, 1024*1024);
+
+	void *ptr = mm_alloc(size);
+#if MM_CFG_WIDE_HEADER
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_EQUAL_UINT32(mm_to_csize(size), mm_tochunk(ptr)->csize);
+	memset(ptr, 'A', size);
+	mm_check();
+	mm_free(ptr);
+	mm_check();
+#else
+	// more than CSIZE_MAX units
+	TEST_ASSERT_NULL(ptr);
+#endif
+}
+
+TEST(memmgr, halloc_null_selects_the_default_heap)
+{
+	mm_init(gs_heap, 4096);
+
+	mm_handle_t *handle = mm_heap_halloc(NULL, DEFAULT_SIZE);
+	TEST_ASSERT_NOT_NULL(handle);
+	uint8_t *ptr = mm_hlock(handle);
+	TEST_ASSERT_TRUE((ptr >= gs_heap) && (ptr < (gs_heap + 4096)));
+	mm_hunlock(handle);
+	mm_hfree(handle);
+	mm_check();
+}
+
+TEST(memmgr, attach_keeps_allocations)
+{
+	mm_init(gs_heap, ATTACH_SIZE);
+	char *a = mm_alloc(32);
+	char *b = mm_alloc(64);
+	strcpy(a, "kept");
+	mm_free(b);
+
+	TEST_ASSERT_TRUE(mm_attach(gs_heap, ATTACH_SIZE, NULL));
+	mm_check();
+	TEST_ASSERT_EQUAL_STRING("kept", a);
+	TEST_ASSERT_NULL(mm_chunk_allocator_get(mm_tochunk(a)));
+	/* free chunks went back to the free lists */
+	void *big = mm_alloc(ATTACH_SIZE / 2);
+	TEST_ASSERT_NOT_NULL(big);
+	mm_free(big);
+	mm_free(a);
+	mm_check();
+}
+
+TEST(memmgr, attach_moved_heap)
+{
+	uint8_t *moved = gs_heap + ATTACH_SIZE;
+	mm_init(gs_heap, ATTACH_SIZE);
+	char *a = mm_alloc(32);
+	strcpy(a, "moved");
+	memcpy(moved, gs_heap, ATTACH_SIZE);
+
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CHECKSUM
+	/* only the checksum knows where a header was written */
+	TEST_ASSERT_FALSE(mm_attach(moved, ATTACH_SIZE, NULL));
+#endif
+	TEST_ASSERT_TRUE(mm_attach(moved, ATTACH_SIZE, gs_heap));
+	mm_check();
+	a = (char *)moved + (a - (char *)gs_heap);
+	TEST_ASSERT_EQUAL_STRING("moved", a);
+	mm_free(a);
+	mm_check();
+}
+
+TEST(memmgr, attach_rejects_corruption)
+{
+	mm_init(gs_heap, ATTACH_SIZE);
+	char *a = mm_alloc(32);
+	mm_tochunk(a)->csize += 1;
+	TEST_ASSERT_FALSE(mm_attach(gs_heap, ATTACH_SIZE, NULL));
+
+	memset(gs_heap, 0, ATTACH_SIZE);
+	TEST_ASSERT_FALSE(mm_attach(gs_heap, ATTACH_SIZE, NULL));
+}
+
+TEST(memmgr, detach_releases_pools)
+{
+	mm_init(gs_heap, ATTACH_SIZE);
+	char *a = mm_alloc(32);
+	mm_detach();
+
+	/* the chunk of the mutex pool went back to the heap */
+	uint32_t allocated = 0;
+	mm_lock();
+	mm_chunk_t *chnk = mm_chunk_ctx_get()->boundary.first;
+	for (; chnk != NULL; chnk = mm_chunk_walk_next(chnk)) {
+		allocated += chnk->allocated;
+	}
+	TEST_ASSERT_TRUE(mm_tochunk(a)->allocated);
+	mm_unlock();
+	TEST_ASSERT_EQUAL_UINT32(1, allocated);
+}
+
+TEST(memmgr, add_region_grows_heap)
+{
+	mm_init(gs_heap, 4096);
+	TEST_ASSERT_NULL(mm_alloc(8192));
+
+	TEST_ASSERT_TRUE(mm_add_region(gs_heap + 16384, 16384));
+	char *a = mm_alloc(8192);
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_TRUE((uint8_t *)a > gs_heap + 16384);
+	mm_check();
+
+	/* overlapping regions are refused */
+	TEST_ASSERT_FALSE(mm_add_region(gs_heap + 2048, 4096));
+	mm_free(a);
+	mm_check();
+}
+
+TEST(memmgr, region_hooks_grow_heap)
+{
+	mm_init(gs_heap, 4096);
+	gs_region_next = gs_heap + 8192;
+	mm_region_hooks_set(fake_region_get, fake_region_put);
+
+	char *a = mm_alloc(8192);
+	mm_region_hooks_set(NULL, NULL);
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NULL(gs_region_next);
+	TEST_ASSERT_NULL(gs_region_put_last);
+	mm_check();
+	mm_free(a);
+}
+
+TEST(memmgr, region_hooks_put_refused)
+{
+	mm_init(gs_heap + 8192, 4096);
+	gs_region_next = gs_heap;
+	gs_region_put_last = NULL;
+	mm_region_hooks_set(fake_region_get, fake_region_put);
+
+	TEST_ASSERT_NULL(mm_alloc(8192));
+	mm_region_hooks_set(NULL, NULL);
+	TEST_ASSERT_EQUAL_PTR(gs_heap, gs_region_put_last);
+	mm_check();
+}
+
+TEST(memmgr, zalloc_from_zeroed_region)
+{
+	mm_init(gs_heap, 4096);
+	memset(gs_heap + 8192, 0, MM_CFG_REGION_SIZE);
+	gs_region_next = gs_heap + 8192;
+	mm_region_hooks_set(fake_region_get, fake_region_put);
+
+	uint8_t *a = mm_zalloc(8192);
+	mm_region_hooks_set(NULL, NULL);
+	TEST_ASSERT_NOT_NULL(a);
+	/* cleared while the chunk was taken, not by mm_zalloc */
+	TEST_ASSERT_EQUAL_PTR(a, mm_heap_default()->zeroed);
+	for (uint32_t i = 0; i < 8192; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, a[i]);
+	}
+	mm_check();
+	mm_free(a);
+}
+
+TEST(memmgr, zalloc_reused_chunk)
+{
+	mm_init(gs_heap, 4096);
+	uint8_t *a = mm_alloc(64);
+	memset(a, 0xAA, 64);
+	mm_free(a);
+
+	uint8_t *b = mm_calloc(16, 4);
+	TEST_ASSERT_EQUAL_PTR(a, b);
+	for (uint32_t i = 0; i < 64; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, b[i]);
+	}
+	mm_check();
+	mm_free(b);
+}
+
 TEST(memmgr, info)
 {
 	mm_init(gs_heap, 1024*1024);
+	// the table has a slot for each chunk, the last one and its own chunk
+	uint32_t infos_size = (mm_chunk_count() + 2) * sizeof(mm_info_t);
 
-	chunk_test_allocated_set(g_first, true);
-	chunk_test_fill_with_prepare(g_first, 'A');
 	mm_info_t a_expect[] = {
 			{
-				.size = 56,
-				.csize = 19,
+				.size = 224,
+				.csize = mm_to_csize(224),
 				.allocated = true,
 				.allocator = NULL
 			},
 			{
-				.size = 192,
-				.csize = 53,
+				.size = infos_size,
+				.csize = mm_to_csize(infos_size),
 				.allocated = true,
 				.allocator = NULL
 			},
 			{
 				.size = 0,
-				.csize = 32695,
+				.csize = HEAP_FIRST_CSIZE - mm_to_csize(224) - mm_to_csize(infos_size),
 				.allocated = false,
 				.allocator = NULL
 			},
 			{
 				.size = 0,
-				.csize = 32767,
+				.csize = HEAP_NEXT_CSIZE,
 				.allocated = false,
 				.allocator = NULL
 			},
@@ -239,8 +485,48 @@ TEST(memmgr, info)
 	mm_info_t *infos = mm_info_get();
 	eval_mm_info(a_expect, infos, 4);
 
+	infos_size = (mm_chunk_count() + 2) * sizeof(mm_info_t);
 	mock_memmgr_setup();
-	mock_mm_alloc_ExpectAndReturn(208, NULL);
+	mock_mm_alloc_ExpectAndReturn(infos_size, NULL);
 	TEST_ASSERT_NULL(mm_info_get());
 	mock_memmgr_verify();
 }
+
+TEST(memmgr, stats_follow_allocations)
+{
+	mm_stats_t stats;
+	mm_init(gs_heap, 4096);
+	mm_stats_get(&stats);
+	uint32_t free_size = stats.free_size;
+	uint32_t used = stats.heap_size - free_size;
+	TEST_ASSERT_TRUE(stats.heap_size <= 4096);
+	TEST_ASSERT_EQUAL_UINT32(free_size, stats.largest_free);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.free_count);
+	TEST_ASSERT_EQUAL_UINT32(0, stats.fragmentation);
+	TEST_ASSERT_EQUAL_UINT32(used, stats.peak_used);
+
+	uint32_t chunk = mm_to_csize(CHUNK_TEST_UNCACHED) * MM_CFG_ALIGNMENT;
+	void *a = mm_alloc(CHUNK_TEST_UNCACHED);
+	void *b = mm_alloc(CHUNK_TEST_UNCACHED);
+	void *c = mm_alloc(CHUNK_TEST_UNCACHED);
+	mm_free(b);
+	mm_stats_get(&stats);
+	TEST_ASSERT_EQUAL_UINT32(free_size - 2 * chunk, stats.free_size);
+	TEST_ASSERT_EQUAL_UINT32(free_size - 3 * chunk, stats.largest_free);
+	TEST_ASSERT_EQUAL_UINT32(2, stats.free_count);
+	TEST_ASSERT_EQUAL_UINT32((chunk * 1000) / stats.free_size, stats.fragmentation);
+	TEST_ASSERT_EQUAL_UINT32(used + 3 * chunk, stats.peak_used);
+
+	/* growing in place keeps the high-water mark exact */
+	a = mm_realloc(a, CHUNK_TEST_UNCACHED + chunk);
+	mm_stats_get(&stats);
+	TEST_ASSERT_EQUAL_UINT32(used + 3 * chunk, stats.peak_used);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.free_count);
+
+	mm_free(a);
+	mm_free(c);
+	mm_stats_get(&stats);
+	TEST_ASSERT_EQUAL_UINT32(free_size, stats.free_size);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.free_count);
+	TEST_ASSERT_EQUAL_UINT32(used + 3 * chunk, stats.peak_used);
+}
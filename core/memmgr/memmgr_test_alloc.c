@@ -28,7 +28,7 @@
 #include "memmgr_conf.h"
 
 /* helpers -------------------------------------------------------------------*/
-#define			DEFAULT_SIZE		(11)
+#define			DEFAULT_SIZE		(CHUNK_TEST_UNCACHED)
 
 static void		prepare_alloc		(void);
 
@@ -78,21 +78,25 @@ TEST(memmgr_alloc, alloc_zero)
 
 TEST(memmgr_alloc, alloc_too_big)
 {
-	TEST_ASSERT_NULL(mm_alloc(1024*1024));
+	TEST_ASSERT_NULL(mm_alloc(CHUNK_TEST_TOO_BIG));
 }
 
 TEST(memmgr_alloc, alloc_none_available)
 {
-	uint32_t size = 11;
+	uint32_t size = DEFAULT_SIZE;
 	uint16_t expect_csize = mm_to_csize(size);
 	mock_mm_find_first_free_ExpectAndReturn(expect_csize, NULL);
+#if MM_CFG_TASK_CACHE
+	// reclaiming drains the cache of the caller and looks again
+	mock_mm_find_first_free_ExpectAndReturn(expect_csize, NULL);
+#endif
 
 	TEST_ASSERT_NULL(mm_alloc(size));
 }
 
 TEST(memmgr_alloc, alloc_no_split)
 {
-	uint32_t size = 11;
+	uint32_t size = DEFAULT_SIZE;
 	uint16_t expect_csize = mm_to_csize(size);
 	chunk_test_state_t a_expect_state[] = {{128, true}, {128, false}};
 
@@ -111,7 +115,7 @@ TEST(memmgr_alloc, alloc_no_split)
 
 TEST(memmgr_alloc, alloc_no_merge_if_null)
 {
-	uint32_t size = 11;
+	uint32_t size = DEFAULT_SIZE;
 	uint16_t expect_csize = mm_to_csize(size);
 	chunk_test_state_t a_expect_state[] = {{128, false}, {expect_csize, true}, {128-expect_csize, false}};
 
@@ -132,7 +136,7 @@ TEST(memmgr_alloc, alloc_no_merge_if_null)
 
 TEST(memmgr_alloc, alloc_no_merge_if_allocated)
 {
-	uint32_t size = 11;
+	uint32_t size = DEFAULT_SIZE;
 	uint16_t expect_csize = mm_to_csize(size);
 	chunk_test_state_t a_expect_state[] = {{expect_csize, true}, {128-expect_csize, false}, {128, true}};
 
@@ -0,0 +1,150 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/chunk.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(memmgr_batch);
+
+TEST_GROUP_RUNNER(memmgr_batch)
+{
+	RUN_TEST_CASE(memmgr_batch, alloc_carves_one_chunk);
+	RUN_TEST_CASE(memmgr_batch, alloc_zero_size_gives_null);
+	RUN_TEST_CASE(memmgr_batch, alloc_falls_back_to_separate_chunks);
+	RUN_TEST_CASE(memmgr_batch, alloc_out_of_memory);
+	RUN_TEST_CASE(memmgr_batch, free_merges_runs_and_neighbours);
+	RUN_TEST_CASE(memmgr_batch, free_skips_null);
+	RUN_TEST_CASE(memmgr_batch, double_free_leads_to_death);
+}
+
+TEST_SETUP(memmgr_batch)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+}
+
+TEST_TEAR_DOWN(memmgr_batch)
+{
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(memmgr_batch, alloc_carves_one_chunk)
+{
+	uint32_t sizes[] = {10, 40, 4};
+	void *out[3];
+	uint16_t csize[3] = {mm_to_csize(10), mm_to_csize(40), mm_to_csize(4)};
+	chunk_test_state_t a_expect[] = {
+		{csize[0], true},
+		{csize[1], true},
+		{csize[2], true},
+		{256 - csize[0] - csize[1] - csize[2], false}
+	};
+
+	TEST_ASSERT_EQUAL_UINT32(3, mm_alloc_batch(3, sizes, out));
+	chunk_test_verify(a_expect, 4);
+	TEST_ASSERT_EQUAL_PTR(mm_toptr(g_first), out[0]);
+	TEST_ASSERT_EQUAL_UINT32(40, mm_tochunk(out[1])->guard_offset);
+	TEST_ASSERT_EQUAL_PTR((uint8_t *)out[0] + csize[0]*MM_CFG_ALIGNMENT, out[1]);
+}
+
+TEST(memmgr_batch, alloc_zero_size_gives_null)
+{
+	uint32_t sizes[] = {0, 16};
+	void *out[2];
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_alloc_batch(2, sizes, out));
+	TEST_ASSERT_NULL(out[0]);
+	TEST_ASSERT_EQUAL_PTR(mm_toptr(g_first), out[1]);
+}
+
+TEST(memmgr_batch, alloc_falls_back_to_separate_chunks)
+{
+	chunk_test_state_t a_state[] = {{64, false}, {128, true}, {64, false}};
+	chunk_test_prepare(a_state, 3);
+	uint32_t payload = (40 - mm_header_csize() - MM_GUARD_CSIZE) * MM_CFG_ALIGNMENT;
+	uint32_t sizes[] = {payload, payload};
+	void *out[2];
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_alloc_batch(2, sizes, out));
+	TEST_ASSERT_EQUAL_PTR(mm_toptr(g_first), out[0]);
+	TEST_ASSERT_EQUAL_PTR(mm_toptr(mm_compute_next(g_first, 192)), out[1]);
+}
+
+TEST(memmgr_batch, alloc_out_of_memory)
+{
+	uint32_t sizes[] = {16, 256*MM_CFG_ALIGNMENT};
+	void *out[2];
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_alloc_batch(2, sizes, out));
+	TEST_ASSERT_NOT_NULL(out[0]);
+	TEST_ASSERT_NULL(out[1]);
+}
+
+TEST(memmgr_batch, free_merges_runs_and_neighbours)
+{
+	chunk_test_state_t a_state[] = {
+		{32, true}, {32, true}, {32, false}, {32, true}, {64, true}, {64, true}
+	};
+	chunk_test_state_t a_expect[] = {{128, false}, {64, true}, {64, false}};
+	chunk_test_prepare(a_state, 6);
+
+	mm_chunk_t *chnk[6];
+	chnk[0] = g_first;
+	for (uint32_t i = 1; i < 6; i++) {
+		chnk[i] = mm_compute_next(chnk[i-1], chnk[i-1]->csize);
+	}
+	void *ptrs[] = {mm_toptr(chnk[5]), mm_toptr(chnk[3]), mm_toptr(chnk[0]),
+			mm_toptr(chnk[1])};
+
+	mm_free_batch(ptrs, 4);
+	chunk_test_verify(a_expect, 3);
+	mm_chunk_validate(chnk[4]);
+	TEST_ASSERT_EQUAL_UINT32(128, chnk[4]->prev_size);
+}
+
+TEST(memmgr_batch, free_skips_null)
+{
+	uint32_t sizes[] = {16, 16};
+	void *ptrs[4] = {NULL, NULL, NULL, NULL};
+	chunk_test_state_t a_expect[] = {{256, false}};
+
+	mm_alloc_batch(2, sizes, &ptrs[1]);
+	mm_free_batch(ptrs, 4);
+	chunk_test_verify(a_expect, 1);
+}
+
+TEST(memmgr_batch, double_free_leads_to_death)
+{
+	uint32_t sizes[] = {16, 16, 16};
+	void *ptrs[3];
+
+	mm_alloc_batch(3, sizes, ptrs);
+	mm_free(ptrs[1]);
+
+	EXPECT_ABORT_BEGIN
+	mm_free_batch(ptrs, 3);
+	VERIFY_FAILS_END("MM: double free");
+}
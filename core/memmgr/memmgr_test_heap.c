@@ -0,0 +1,241 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "unity_fixture.h"
+#include "tests/memmgr_unity.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			HEAP_SIZE		(4096)
+
+static uint8_t gs_buf_a[HEAP_SIZE] __attribute__((aligned(8)));
+static uint8_t gs_buf_b[HEAP_SIZE] __attribute__((aligned(8)));
+static mm_heap_t *gs_a = NULL;
+static mm_heap_t *gs_b = NULL;
+
+static bool		in_buffer		(uint8_t *buf,
+						 void *ptr);
+static mm_chunk_t *	chunk_of		(void *ptr);
+static void		idle			(void *arg);
+
+static bool in_buffer(uint8_t *buf, void *ptr)
+{
+	return ((uint8_t *)ptr >= buf) && ((uint8_t *)ptr < (buf + HEAP_SIZE));
+}
+
+static mm_chunk_t *chunk_of(void *ptr)
+{
+	return (mm_chunk_t *)((uint8_t *)ptr - (mm_header_csize() * MM_CFG_ALIGNMENT));
+}
+
+static void idle(void *arg)
+{
+	(void)arg;
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(memmgr_heap);
+
+TEST_GROUP_RUNNER(memmgr_heap)
+{
+	RUN_TEST_CASE(memmgr_heap, init_too_small_returns_null);
+	RUN_TEST_CASE(memmgr_heap, default_is_not_null);
+	RUN_TEST_CASE(memmgr_heap, alloc_from_own_buffer);
+	RUN_TEST_CASE(memmgr_heap, alloc_restores_chunk_context);
+	RUN_TEST_CASE(memmgr_heap, heaps_are_independent);
+	RUN_TEST_CASE(memmgr_heap, free_gives_memory_back);
+	RUN_TEST_CASE(memmgr_heap, free_to_wrong_heap_leads_to_death);
+	RUN_TEST_CASE(memmgr_heap, zalloc_clears_memory);
+	RUN_TEST_CASE(memmgr_heap, realloc_keeps_content);
+	RUN_TEST_CASE(memmgr_heap, foreign_free_waits_for_next_alloc);
+	RUN_TEST_CASE(memmgr_heap, foreign_free_of_tiny_block_is_direct);
+	RUN_TEST_CASE(memmgr_heap, foreign_double_free_leads_to_death);
+	RUN_TEST_CASE(memmgr_heap, stats_are_per_heap);
+}
+
+TEST_SETUP(memmgr_heap)
+{
+	unity_mock_setup();
+	gs_a = mm_heap_init(gs_buf_a, HEAP_SIZE);
+	gs_b = mm_heap_init(gs_buf_b, HEAP_SIZE);
+	TEST_ASSERT_NOT_NULL(gs_a);
+	TEST_ASSERT_NOT_NULL(gs_b);
+}
+
+TEST_TEAR_DOWN(memmgr_heap)
+{
+	mm_heap_release(gs_a);
+	mm_heap_release(gs_b);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(memmgr_heap, init_too_small_returns_null)
+{
+	TEST_ASSERT_NULL(mm_heap_init(NULL, HEAP_SIZE));
+	TEST_ASSERT_NULL(mm_heap_init(gs_buf_a, sizeof(mm_heap_t)));
+}
+
+TEST(memmgr_heap, default_is_not_null)
+{
+	TEST_ASSERT_NOT_NULL(mm_heap_default());
+	TEST_ASSERT_TRUE(mm_heap_default() != gs_a);
+}
+
+TEST(memmgr_heap, alloc_from_own_buffer)
+{
+	void *ptr = mm_heap_alloc(gs_a, 32);
+
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_TRUE(in_buffer(gs_buf_a, ptr));
+	TEST_ASSERT_NULL(mm_heap_alloc(gs_a, 0));
+	TEST_ASSERT_NULL(mm_heap_alloc(gs_a, HEAP_SIZE));
+}
+
+TEST(memmgr_heap, alloc_restores_chunk_context)
+{
+	mm_chunk_ctx_t *ctx = mm_chunk_ctx_get();
+
+	mm_heap_alloc(gs_a, 32);
+	TEST_ASSERT_EQUAL_PTR(ctx, mm_chunk_ctx_get());
+}
+
+TEST(memmgr_heap, heaps_are_independent)
+{
+	void *a = mm_heap_alloc(gs_a, 32);
+	void *b = mm_heap_alloc(gs_b, 32);
+
+	TEST_ASSERT_TRUE(in_buffer(gs_buf_a, a));
+	TEST_ASSERT_TRUE(in_buffer(gs_buf_b, b));
+	TEST_ASSERT_EQUAL_UINT32((uint8_t *)a - gs_buf_a, (uint8_t *)b - gs_buf_b);
+	mm_heap_check(gs_a);
+	mm_heap_check(gs_b);
+}
+
+TEST(memmgr_heap, free_gives_memory_back)
+{
+	void *a = mm_heap_alloc(gs_a, 32);
+	mm_heap_free(gs_a, a);
+	mm_heap_check(gs_a);
+
+	TEST_ASSERT_EQUAL_PTR(a, mm_heap_alloc(gs_a, 64));
+}
+
+TEST(memmgr_heap, free_to_wrong_heap_leads_to_death)
+{
+	void *a = mm_heap_alloc(gs_a, 32);
+
+	EXPECT_ABORT_BEGIN
+	mm_heap_free(gs_b, a);
+	VERIFY_FAILS_END("MM: out of bound");
+
+	/* die() left gs_b locked, with its chunk context selected */
+	mm_chunk_ctx_set(NULL);
+}
+
+TEST(memmgr_heap, zalloc_clears_memory)
+{
+	uint8_t *a = mm_heap_alloc(gs_a, 32);
+	memset(a, 0xA5, 32);
+	mm_heap_free(gs_a, a);
+
+	a = mm_heap_zalloc(gs_a, 32);
+	for (uint32_t i = 0; i < 32; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, a[i]);
+	}
+}
+
+TEST(memmgr_heap, realloc_keeps_content)
+{
+	uint8_t *a = mm_heap_realloc(gs_a, NULL, 16);
+	mm_heap_alloc(gs_a, 16);
+	for (uint32_t i = 0; i < 16; i++) {
+		a[i] = i;
+	}
+
+	uint8_t *b = mm_heap_realloc(gs_a, a, 256);
+	TEST_ASSERT_TRUE(in_buffer(gs_buf_a, b));
+	for (uint32_t i = 0; i < 16; i++) {
+		TEST_ASSERT_EQUAL_UINT8(i, b[i]);
+	}
+	mm_heap_check(gs_a);
+}
+
+TEST(memmgr_heap, foreign_free_waits_for_next_alloc)
+{
+	task_t *owner = task_create(idle, NULL, 0, 0, "test_owner");
+	void *a = mm_heap_alloc(gs_a, 32);
+
+	mm_heap_owner_set(gs_a, owner);
+	mm_heap_free(gs_a, a);
+	TEST_ASSERT_TRUE(chunk_of(a)->allocated);
+
+	mm_heap_owner_set(gs_a, NULL);
+	TEST_ASSERT_EQUAL_PTR(a, mm_heap_alloc(gs_a, 64));
+	mm_heap_check(gs_a);
+	object_delete(&owner->base);
+}
+
+TEST(memmgr_heap, foreign_free_of_tiny_block_is_direct)
+{
+	task_t *owner = task_create(idle, NULL, 0, 0, "test_owner");
+	void *a = mm_heap_alloc(gs_a, 1);
+
+	mm_heap_owner_set(gs_a, owner);
+	mm_heap_free(gs_a, a);
+	TEST_ASSERT_FALSE(chunk_of(a)->allocated);
+	mm_heap_owner_set(gs_a, NULL);
+	object_delete(&owner->base);
+}
+
+TEST(memmgr_heap, foreign_double_free_leads_to_death)
+{
+	void *a = mm_heap_alloc(gs_a, 32);
+	mm_heap_free(gs_a, a);
+
+	EXPECT_ABORT_BEGIN
+	mm_heap_remote_push(gs_a, a);
+	VERIFY_FAILS_END("MM: double free");
+}
+
+TEST(memmgr_heap, stats_are_per_heap)
+{
+	mm_stats_t stats_a;
+	mm_stats_t stats_b;
+	mm_heap_stats_get(gs_a, &stats_a);
+	uint32_t free_size = stats_a.free_size;
+	TEST_ASSERT_TRUE(stats_a.heap_size <= HEAP_SIZE);
+	TEST_ASSERT_EQUAL_UINT32(stats_a.heap_size, free_size);
+
+	void *ptr = mm_heap_alloc(gs_a, 100);
+	mm_heap_stats_get(gs_a, &stats_a);
+	mm_heap_stats_get(gs_b, &stats_b);
+	TEST_ASSERT_EQUAL_UINT32(free_size - mm_to_csize(100) * MM_CFG_ALIGNMENT,
+				 stats_a.free_size);
+	TEST_ASSERT_EQUAL_UINT32(stats_a.free_size, stats_a.largest_free);
+	TEST_ASSERT_EQUAL_UINT32(free_size, stats_b.free_size);
+
+	mm_heap_free(gs_a, ptr);
+	mm_heap_stats_get(gs_a, &stats_a);
+	TEST_ASSERT_EQUAL_UINT32(free_size, stats_a.free_size);
+}
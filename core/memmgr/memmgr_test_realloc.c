@@ -70,7 +70,7 @@ TEST_SETUP(memmgr_realloc)
 	chunk_test_prepare(a_state, 4);
 	
 	mm_chunk_t *second = mm_chunk_next_get(g_first);
-	gs_chunk_envelop = mm_header_csize()+MM_CFG_GUARD_SIZE;
+	gs_chunk_envelop = mm_header_csize()+MM_GUARD_CSIZE;
 	
 	gs_size = 51;
 	mm_chunk_guard_set(second, gs_size);
@@ -125,14 +125,15 @@ TEST(memmgr_realloc_new, from_null_zero)
 
 TEST(memmgr_realloc_new, from_null_some)
 {
-	chunk_test_state_t a_expect[] = {{11, true}, {245, false}};
-	mock_mm_find_first_free_ExpectAndReturn(11, g_first);
-	mock_mm_chunk_split_ExpectAndReturn(g_first, 11, false);
-	mock_mm_chunk_merge_Expect(mm_compute_next(g_first, 11));
+	uint32_t csize = mm_to_csize(CHUNK_TEST_UNCACHED);
+	chunk_test_state_t a_expect[] = {{csize, true}, {256 - csize, false}};
+	mock_mm_find_first_free_ExpectAndReturn(csize, g_first);
+	mock_mm_chunk_split_ExpectAndReturn(g_first, csize, false);
+	mock_mm_chunk_merge_Expect(mm_compute_next(g_first, csize));
 
-	uint8_t *ptr = mm_realloc(NULL, 22);
+	uint8_t *ptr = mm_realloc(NULL, CHUNK_TEST_UNCACHED);
 	TEST_ASSERT_EQUAL_PTR(mm_toptr(g_first), ptr);
-	memset(ptr, 'A', 22);
+	memset(ptr, 'A', CHUNK_TEST_UNCACHED);
 
 	chunk_test_verify(a_expect, 2);
 }
@@ -140,7 +141,7 @@ TEST(memmgr_realloc_new, from_null_some)
 TEST(memmgr_realloc_new, from_null_too_much)
 {
 	chunk_test_state_t a_expect[] = {{128, false}, {128, false}};
-	TEST_ASSERT_NULL(mm_realloc(NULL, 1024*1024));
+	TEST_ASSERT_NULL(mm_realloc(NULL, CHUNK_TEST_TOO_BIG));
 	chunk_test_verify(a_expect, 2);
 }
 
@@ -157,22 +158,33 @@ TEST(memmgr_realloc, to_zero_should_free)
 TEST(memmgr_realloc, too_much_does_nothing)
 {
 	chunk_test_state_t a_expect[] = {{30, false}, {20, true}, {20, false}, {186, false}};
-	TEST_ASSERT_NULL(mm_realloc(gs_ptr, 1024*1024));
+	TEST_ASSERT_NULL(mm_realloc(gs_ptr, CHUNK_TEST_TOO_BIG));
 	chunk_test_verify(a_expect, 4);
 }
 
 TEST(memmgr_realloc, same_csize)
 {
-	mock_mm_chunk_split_ExpectAndReturn(mm_tochunk(gs_ptr), 18, false);
+	uint32_t csize = mm_to_csize(gs_size);
+	mm_chunk_t *chnk = mm_tochunk(gs_ptr);
+	mock_mm_chunk_split_ExpectAndReturn(chnk, csize, false);
+	if (20 - csize >= mm_min_csize()) {
+		/* without a guard word the payload leaves room for a chunk */
+		mock_mm_chunk_merge_Expect(mm_compute_next(chnk, csize));
+	}
 	uint8_t *ptr = mm_realloc(gs_ptr, gs_size);
 	TEST_ASSERT_EQUAL_PTR(gs_ptr, ptr);
 }
 
 TEST(memmgr_realloc, shrink_a_bit)
 {
-	uint32_t csize = 17;
-	mock_mm_chunk_split_ExpectAndReturn(mm_tochunk(gs_ptr), csize, false);
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t csize = mm_to_csize(gs_size) - 1;
+	mm_chunk_t *chnk = mm_tochunk(gs_ptr);
+	mock_mm_chunk_split_ExpectAndReturn(chnk, csize, false);
+	if (20 - csize >= mm_min_csize()) {
+		/* small headers leave room for a chunk even then */
+		mock_mm_chunk_merge_Expect(mm_compute_next(chnk, csize));
+	}
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	uint8_t *ptr = mm_realloc(gs_ptr, new_payload);
 	TEST_ASSERT_EQUAL_PTR(gs_ptr, ptr);
@@ -181,30 +193,32 @@ TEST(memmgr_realloc, shrink_a_bit)
 
 TEST(memmgr_realloc, shrink_a_lot)
 {
-	uint32_t csize = 14;
+	uint32_t csize = 20 - mm_min_csize();
 	mm_chunk_t *chnk = mm_tochunk(gs_ptr);
 	mm_chunk_t *new = mm_compute_next(chnk, csize);
 	mock_mm_chunk_split_ExpectAndReturn(chnk, csize, false);
 	mock_mm_chunk_merge_Expect(new);
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	uint8_t *ptr = mm_realloc(gs_ptr, new_payload);
 	TEST_ASSERT_EQUAL_PTR(gs_ptr, ptr);
-	gs_size = new_payload;
+	/* without a guard word even that payload may hold all that was written */
+	gs_size = umin(gs_size, new_payload);
 }
 
 TEST(memmgr_realloc, shrink_a_lot_but_cant_merge)
 {
-	uint32_t csize = 14;
+	uint32_t csize = 20 - mm_min_csize();
 	mm_chunk_t *chnk = mm_tochunk(gs_ptr);
 	mm_chunk_t *next = mm_chunk_next_get(chnk);
 	chunk_test_allocated_set(next, true);
 	mock_mm_chunk_split_ExpectAndReturn(chnk, csize, false);
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	uint8_t *ptr = mm_realloc(gs_ptr, new_payload);
 	TEST_ASSERT_EQUAL_PTR(gs_ptr, ptr);
-	gs_size = new_payload;
+	/* without a guard word even that payload may hold all that was written */
+	gs_size = umin(gs_size, new_payload);
 }
 
 TEST(memmgr_realloc, grow_a_bit)
@@ -212,7 +226,7 @@ TEST(memmgr_realloc, grow_a_bit)
 	uint32_t csize = 18;
 	mm_chunk_t *chnk = mm_tochunk(gs_ptr);
 	mock_mm_chunk_split_ExpectAndReturn(chnk, csize, false);
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	uint8_t *ptr = mm_realloc(gs_ptr, new_payload);
 	TEST_ASSERT_EQUAL_PTR(gs_ptr, ptr);
@@ -230,7 +244,7 @@ TEST(memmgr_realloc, grow_a_lot_eat_next)
 	mock_mm_chunk_merge_Expect(chnk);
 	mock_mm_chunk_split_ExpectAndReturn(chnk, csize, false);
 	mock_mm_chunk_merge_Expect(new);
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	uint8_t *ptr = mm_realloc(gs_ptr, new_payload);
 	TEST_ASSERT_EQUAL_PTR(gs_ptr, ptr);
@@ -250,7 +264,7 @@ TEST(memmgr_realloc, grow_a_lot_eat_prev)
 	mock_mm_chunk_merge_Expect(prev);
 	mock_mm_chunk_split_ExpectAndReturn(prev, csize, false);
 	mock_mm_chunk_merge_Expect(new);
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	uint8_t *ptr = mm_realloc(gs_ptr, new_payload);
 	TEST_ASSERT_EQUAL_PTR(mm_toptr(prev), ptr);
@@ -273,7 +287,7 @@ TEST(memmgr_realloc, grow_a_lot_eat_both)
 	mock_mm_chunk_merge_Expect(prev);
 	mock_mm_chunk_split_ExpectAndReturn(prev, csize, false);
 	mock_mm_chunk_merge_Expect(new);
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	uint8_t *ptr = mm_realloc(gs_ptr, new_payload);
 	TEST_ASSERT_EQUAL_PTR(mm_toptr(prev), ptr);
@@ -285,7 +299,7 @@ TEST(memmgr_realloc, grow_a_lot_eat_both)
 TEST(memmgr_realloc, grow_a_lot_cant_eat)
 {
 	uint32_t csize = 30;
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	mock_memmgr_setup();
 
@@ -323,7 +337,7 @@ TEST(memmgr_realloc, grow_a_lot_cant_eat_but_malloc_failed)
 	chunk_test_allocated_set(next, true);
 	
 	uint32_t csize = 30;
-	uint32_t new_payload = (csize - (mm_header_csize() + MM_CFG_GUARD_SIZE)) * MM_CFG_ALIGNMENT;
+	uint32_t new_payload = (csize - (mm_header_csize() + MM_GUARD_CSIZE)) * MM_CFG_ALIGNMENT;
 
 	mock_memmgr_setup();
 
@@ -0,0 +1,232 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "os/memmgr.h"
+#include "memmgr/heap.h"
+#include "memmgr/pool.h"
+#include "memmgr/reclaim.h"
+#include "memmgr_conf.h"
+
+/*
+ * A carved pool keeps its chunk while idle, so that a pool whose last block
+ * comes and goes does not split and merge a heap chunk each time. Idle pools
+ * give it back when the default heap runs out of room.
+ */
+
+/* Prototypes ----------------------------------------------------------------*/
+static void		mm_pool_carve		(mm_pool_t *this);
+static void		mm_pool_release		(mm_pool_t *this);
+#if MM_CFG_RECLAIM
+static uint32_t		mm_pool_shrink		(void *arg,
+						 uint32_t size);
+#endif
+
+/* Variables -----------------------------------------------------------------*/
+static mm_pool_t	*gs_pools = NULL;
+#if MM_CFG_RECLAIM
+static mm_shrinker_t	gs_shrinker;
+#endif
+
+/* Private functions definitions ---------------------------------------------*/
+static void mm_pool_carve(mm_pool_t *this)
+{
+	this->blocks = mm_alloc(this->block_size * this->count);
+	if (this->blocks != NULL) {
+		this->free = NULL;
+		this->carved = 0;
+		this->next = gs_pools;
+		gs_pools = this;
+	}
+#if MM_CFG_RECLAIM
+	if (this->blocks != NULL) {
+		// mm_reclaim_reset may have dropped it since the last carve, idle
+		// pools are the cheapest to rebuild
+		mm_shrinker_unregister(&gs_shrinker);
+		mm_shrinker_register(&gs_shrinker, mm_pool_shrink, NULL, 0);
+	}
+#endif
+}
+
+static void mm_pool_release(mm_pool_t *this)
+{
+	mm_pool_t **it = &gs_pools;
+	while ((*it != NULL) && (*it != this)) {
+		it = &(*it)->next;
+	}
+	if (*it != NULL) {
+		*it = this->next;
+	}
+
+	mm_free(this->blocks);
+	this->blocks = NULL;
+	this->free = NULL;
+	this->carved = 0;
+	this->next = NULL;
+}
+
+#if MM_CFG_RECLAIM
+static uint32_t mm_pool_shrink(void *arg, uint32_t size)
+{
+	(void)arg;
+	(void)size;
+	uint32_t released = 0;
+	mm_pool_t *it = gs_pools;
+	while (it != NULL) {
+		mm_pool_t *next = it->next;
+		if (it->used == 0) {
+			released += it->block_size * it->count;
+			mm_pool_release(it);
+		}
+		it = next;
+	}
+	return released;
+}
+#endif
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_pool_init(mm_pool_t *this, uint32_t block_size, uint32_t count)
+{
+	memset(this, 0, sizeof(mm_pool_t));
+	this->block_size = MM_POOL_BLOCK_SIZE(block_size);
+	this->count = count;
+}
+
+void *mm_pool_alloc(mm_pool_t *this)
+{
+	void *ptr = NULL;
+
+	mm_lock();
+	if ((this->blocks == NULL) && (this->count > 0)) {
+		mm_pool_carve(this);
+	}
+
+	if (this->free != NULL) {
+		ptr = this->free;
+		this->free = *(void **)ptr;
+	} else if ((this->blocks != NULL) && (this->carved < this->count)) {
+		ptr = this->blocks + (this->carved * this->block_size);
+		this->carved++;
+	}
+
+	if (ptr != NULL) {
+		this->used++;
+#if MM_CFG_POOL_STATS
+		this->stats.peak = umax(this->stats.peak, this->used);
+#endif
+	} else {
+		ptr = mm_alloc(this->block_size);
+#if MM_CFG_POOL_STATS
+		if (ptr != NULL) {
+			this->stats.overflows++;
+		}
+#endif
+	}
+#if MM_CFG_POOL_STATS
+	if (ptr != NULL) {
+		this->stats.allocs++;
+	}
+#endif
+	mm_unlock();
+	return ptr;
+}
+
+void *mm_pool_zalloc(mm_pool_t *this)
+{
+	void *ptr = mm_pool_alloc(this);
+	if (ptr != NULL) {
+		memset(ptr, 0, this->block_size);
+	}
+	return ptr;
+}
+
+void mm_pool_free(mm_pool_t *this, void *ptr)
+{
+	if (ptr == NULL) {
+		return;
+	}
+
+	mm_lock();
+	if (mm_pool_owns(this, ptr)) {
+		if ((((uint8_t *)ptr - this->blocks) % this->block_size) != 0) {
+			die("MM: pool misaligned free");
+		}
+		*(void **)ptr = this->free;
+		this->free = ptr;
+		this->used--;
+	} else {
+		mm_free(ptr);
+	}
+#if MM_CFG_POOL_STATS
+	this->stats.frees++;
+#endif
+	mm_unlock();
+}
+
+bool mm_pool_owns(mm_pool_t *this, void *ptr)
+{
+	uint8_t *p = ptr;
+	return (this->blocks != NULL) && (p >= this->blocks) &&
+	       (p < (this->blocks + (this->block_size * this->count)));
+}
+
+#if MM_CFG_POOL_STATS
+void mm_pool_stats_get(mm_pool_t *this, mm_pool_stats_t *stats)
+{
+	mm_lock();
+	*stats = this->stats;
+	stats->used = this->used;
+	mm_unlock();
+}
+#endif
+
+void mm_pool_deinit(mm_pool_t *this)
+{
+	mm_lock();
+	if (this->blocks != NULL) {
+		mm_pool_release(this);
+	}
+	this->used = 0;
+	mm_unlock();
+}
+
+void mm_pool_forget_all(void)
+{
+	mm_pool_t *it = gs_pools;
+	while (it != NULL) {
+		mm_pool_t *next = it->next;
+		it->blocks = NULL;
+		it->free = NULL;
+		it->carved = 0;
+		it->used = 0;
+		it->next = NULL;
+		it = next;
+	}
+	gs_pools = NULL;
+}
+
+void mm_pool_release_all(void)
+{
+	while (gs_pools != NULL) {
+		gs_pools->used = 0;
+		mm_pool_release(gs_pools);
+	}
+}
@@ -0,0 +1,222 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/memmgr_unity.h"
+#include "memmgr/pool.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			BLOCK_SIZE		(12)
+#define			BLOCK_COUNT		(3)
+
+static mm_pool_t gs_pool;
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_pool);
+
+TEST_GROUP_RUNNER(mm_pool)
+{
+	RUN_TEST_CASE(mm_pool, init_rounds_block_size);
+	RUN_TEST_CASE(mm_pool, alloc_carves_lazily);
+	RUN_TEST_CASE(mm_pool, alloc_fails_if_heap_is_exhausted);
+	RUN_TEST_CASE(mm_pool, blocks_are_distinct);
+	RUN_TEST_CASE(mm_pool, free_reuses_last_block);
+	RUN_TEST_CASE(mm_pool, full_pool_overflows_to_heap);
+	RUN_TEST_CASE(mm_pool, last_free_keeps_chunk);
+	RUN_TEST_CASE(mm_pool, deinit_releases_chunk);
+	RUN_TEST_CASE(mm_pool, zalloc_clears_block);
+	RUN_TEST_CASE(mm_pool, free_null_does_no_harm);
+	RUN_TEST_CASE(mm_pool, misaligned_free_leads_to_death);
+	RUN_TEST_CASE(mm_pool, forget_all);
+#if MM_CFG_POOL_STATS
+	RUN_TEST_CASE(mm_pool, stats);
+#endif
+}
+
+TEST_SETUP(mm_pool)
+{
+	unity_mock_setup();
+	mm_pool_init(&gs_pool, BLOCK_SIZE, BLOCK_COUNT);
+}
+
+TEST_TEAR_DOWN(mm_pool)
+{
+	mm_pool_deinit(&gs_pool);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_pool, init_rounds_block_size)
+{
+	TEST_ASSERT_EQUAL_UINT32(0, gs_pool.block_size % sizeof(void *));
+	TEST_ASSERT_TRUE(gs_pool.block_size >= BLOCK_SIZE);
+	TEST_ASSERT_NULL(gs_pool.blocks);
+}
+
+TEST(mm_pool, alloc_carves_lazily)
+{
+	void *ptr = mm_pool_alloc(&gs_pool);
+
+	TEST_ASSERT_NOT_NULL(gs_pool.blocks);
+	TEST_ASSERT_EQUAL_PTR(gs_pool.blocks, ptr);
+	TEST_ASSERT_TRUE(mm_pool_owns(&gs_pool, ptr));
+	mm_pool_free(&gs_pool, ptr);
+}
+
+TEST(mm_pool, alloc_fails_if_heap_is_exhausted)
+{
+	UnityMalloc_MakeMallocFailAfterCount(0);
+	TEST_ASSERT_NULL(mm_pool_alloc(&gs_pool));
+	TEST_ASSERT_NULL(gs_pool.blocks);
+}
+
+TEST(mm_pool, blocks_are_distinct)
+{
+	uint8_t *a = mm_pool_alloc(&gs_pool);
+	uint8_t *b = mm_pool_alloc(&gs_pool);
+	uint8_t *c = mm_pool_alloc(&gs_pool);
+
+	TEST_ASSERT_EQUAL_PTR(a + gs_pool.block_size, b);
+	TEST_ASSERT_EQUAL_PTR(b + gs_pool.block_size, c);
+	mm_pool_free(&gs_pool, a);
+	mm_pool_free(&gs_pool, b);
+	mm_pool_free(&gs_pool, c);
+}
+
+TEST(mm_pool, free_reuses_last_block)
+{
+	void *a = mm_pool_alloc(&gs_pool);
+	void *b = mm_pool_alloc(&gs_pool);
+
+	mm_pool_free(&gs_pool, b);
+	TEST_ASSERT_EQUAL_PTR(b, mm_pool_alloc(&gs_pool));
+	mm_pool_free(&gs_pool, a);
+	mm_pool_free(&gs_pool, b);
+}
+
+TEST(mm_pool, full_pool_overflows_to_heap)
+{
+	void *ptrs[BLOCK_COUNT + 1];
+
+	for (uint32_t i = 0; i < BLOCK_COUNT + 1; i++) {
+		ptrs[i] = mm_pool_alloc(&gs_pool);
+		TEST_ASSERT_NOT_NULL(ptrs[i]);
+	}
+	TEST_ASSERT_FALSE(mm_pool_owns(&gs_pool, ptrs[BLOCK_COUNT]));
+	TEST_ASSERT_EQUAL_UINT32(BLOCK_COUNT, gs_pool.used);
+
+	for (uint32_t i = 0; i < BLOCK_COUNT + 1; i++) {
+		mm_pool_free(&gs_pool, ptrs[i]);
+	}
+}
+
+TEST(mm_pool, last_free_keeps_chunk)
+{
+	void *a = mm_pool_alloc(&gs_pool);
+	void *b = mm_pool_alloc(&gs_pool);
+	uint8_t *blocks = gs_pool.blocks;
+
+	mm_pool_free(&gs_pool, a);
+	mm_pool_free(&gs_pool, b);
+	TEST_ASSERT_EQUAL_PTR(blocks, gs_pool.blocks);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_pool.used);
+	TEST_ASSERT_EQUAL_PTR(b, mm_pool_alloc(&gs_pool));
+	mm_pool_free(&gs_pool, b);
+}
+
+TEST(mm_pool, deinit_releases_chunk)
+{
+	void *a = mm_pool_alloc(&gs_pool);
+
+	mm_pool_deinit(&gs_pool);
+	TEST_ASSERT_NULL(gs_pool.blocks);
+	TEST_ASSERT_NULL(gs_pool.free);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_pool.used);
+	TEST_ASSERT_FALSE(mm_pool_owns(&gs_pool, a));
+
+	TEST_ASSERT_NOT_NULL(mm_pool_alloc(&gs_pool));
+	TEST_ASSERT_NOT_NULL(gs_pool.blocks);
+}
+
+TEST(mm_pool, zalloc_clears_block)
+{
+	uint8_t *a = mm_pool_alloc(&gs_pool);
+	uint8_t *b = mm_pool_alloc(&gs_pool);
+
+	memset(b, 0xA5, gs_pool.block_size);
+	mm_pool_free(&gs_pool, b);
+	b = mm_pool_zalloc(&gs_pool);
+	for (uint32_t i = 0; i < gs_pool.block_size; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, b[i]);
+	}
+	mm_pool_free(&gs_pool, a);
+	mm_pool_free(&gs_pool, b);
+}
+
+TEST(mm_pool, free_null_does_no_harm)
+{
+	mm_pool_free(&gs_pool, NULL);
+}
+
+TEST(mm_pool, misaligned_free_leads_to_death)
+{
+	uint8_t *a = mm_pool_alloc(&gs_pool);
+
+	EXPECT_ABORT_BEGIN
+	mm_pool_free(&gs_pool, a + 1);
+	VERIFY_FAILS_END("MM: pool misaligned free");
+
+	mm_pool_free(&gs_pool, a);
+}
+
+TEST(mm_pool, forget_all)
+{
+	void *a = mm_pool_alloc(&gs_pool);
+
+	mm_pool_forget_all();
+	TEST_ASSERT_NULL(gs_pool.blocks);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_pool.used);
+	TEST_ASSERT_FALSE(mm_pool_owns(&gs_pool, a));
+	mm_free(a);
+}
+
+#if MM_CFG_POOL_STATS
+TEST(mm_pool, stats)
+{
+	mm_pool_stats_t stats;
+	void *ptrs[BLOCK_COUNT + 1];
+
+	for (uint32_t i = 0; i < BLOCK_COUNT + 1; i++) {
+		ptrs[i] = mm_pool_alloc(&gs_pool);
+	}
+	mm_pool_free(&gs_pool, ptrs[0]);
+
+	mm_pool_stats_get(&gs_pool, &stats);
+	TEST_ASSERT_EQUAL_UINT32(BLOCK_COUNT - 1, stats.used);
+	TEST_ASSERT_EQUAL_UINT32(BLOCK_COUNT, stats.peak);
+	TEST_ASSERT_EQUAL_UINT32(BLOCK_COUNT + 1, stats.allocs);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.frees);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.overflows);
+
+	for (uint32_t i = 1; i < BLOCK_COUNT + 1; i++) {
+		mm_pool_free(&gs_pool, ptrs[i]);
+	}
+}
+#endif
@@ -0,0 +1,190 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os/system.h"
+#include "memmgr/heap.h"
+#include "memmgr/profile.h"
+
+#include "memmgr_conf.h"
+
+#if MM_CFG_PROFILE
+/*
+ * Open addressing table of call sites, linear probing. Entries are never
+ * removed, a slot is taken once a site allocated something.
+ */
+
+/* Macro definitions ---------------------------------------------------------*/
+#if (MM_CFG_PROFILE_SITES & (MM_CFG_PROFILE_SITES - 1)) != 0
+#error "MM_CFG_PROFILE_SITES must be a power of two"
+#endif
+
+#define MM_PROFILE_LINE		(128)
+
+/* Prototypes ----------------------------------------------------------------*/
+static mm_profile_site_t *	mm_profile_find		(void *site,
+							 bool insert);
+static uint32_t			mm_profile_key		(mm_profile_site_t *this,
+							 mm_profile_order_t order);
+
+/* Variables -----------------------------------------------------------------*/
+static mm_profile_site_t	gs_sites[MM_CFG_PROFILE_SITES];
+static uint32_t			gs_dropped = 0;
+
+/* Private functions definitions ---------------------------------------------*/
+static mm_profile_site_t *mm_profile_find(void *site, bool insert)
+{
+	uint32_t i = ((uintptr_t)site >> 2) * 2654435761u;
+	for (uint32_t n = 0; n < MM_CFG_PROFILE_SITES; n++, i++) {
+		mm_profile_site_t *slot = &gs_sites[i & (MM_CFG_PROFILE_SITES - 1)];
+		if ((slot->allocs != 0) && (slot->site == site)) {
+			return slot;
+		}
+		if (slot->allocs == 0) {
+			if (!insert) {
+				return NULL;
+			}
+			slot->site = site;
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+static uint32_t mm_profile_key(mm_profile_site_t *this, mm_profile_order_t order)
+{
+	switch (order) {
+	case MM_PROFILE_BY_ALLOCS:
+		return this->allocs;
+	case MM_PROFILE_BY_PEAK:
+		return this->peak_bytes;
+	default:
+		return this->live_bytes;
+	}
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_profile_reset(void)
+{
+	memset(gs_sites, 0, sizeof(gs_sites));
+	gs_dropped = 0;
+}
+
+void mm_profile_alloc(void *site, uint32_t size)
+{
+	mm_profile_site_t *entry = mm_profile_find(site, true);
+	if (entry == NULL) {
+		gs_dropped++;
+		return;
+	}
+	entry->allocs++;
+	entry->live_count++;
+	entry->live_bytes += size;
+	if (entry->live_bytes > entry->peak_bytes) {
+		entry->peak_bytes = entry->live_bytes;
+	}
+}
+
+void mm_profile_free(void *site, uint32_t size)
+{
+	mm_profile_site_t *entry = mm_profile_find(site, false);
+	// allocated before the profile was reset, or dropped
+	if ((entry == NULL) || (entry->live_count == 0)) {
+		return;
+	}
+	entry->live_count--;
+	entry->live_bytes -= (size < entry->live_bytes) ? size : entry->live_bytes;
+}
+
+uint32_t mm_profile_top(mm_profile_site_t *out, uint32_t n,
+			mm_profile_order_t order)
+{
+	uint32_t count = 0;
+
+	mm_lock();
+	for (uint32_t i = 0; i < MM_CFG_PROFILE_SITES; i++) {
+		mm_profile_site_t *entry = &gs_sites[i];
+		uint32_t key = mm_profile_key(entry, order);
+		if ((entry->allocs == 0) ||
+		    ((count == n) && ((n == 0) || (key <= mm_profile_key(&out[n - 1], order))))) {
+			continue;
+		}
+
+		// insertion sort, the smallest one falls off the end
+		uint32_t j = (count < n) ? count++ : n - 1;
+		while ((j > 0) && (mm_profile_key(&out[j - 1], order) < key)) {
+			out[j] = out[j - 1];
+			j--;
+		}
+		out[j] = *entry;
+	}
+	mm_unlock();
+	return count;
+}
+
+uint32_t mm_profile_dropped(void)
+{
+	return gs_dropped;
+}
+
+uint32_t mm_profile_dump(mm_profile_write_f write, void *arg)
+{
+	uint32_t lines = 0;
+
+	for (uint32_t i = 0; i < MM_CFG_PROFILE_SITES; i++) {
+		mm_lock();
+		mm_profile_site_t entry = gs_sites[i];
+		mm_unlock();
+		if (entry.allocs == 0) {
+			continue;
+		}
+
+		// written without the lock, the sink may well allocate
+		char line[MM_PROFILE_LINE];
+		const char *name = NULL;
+		uintptr_t offset = 0;
+		int len = 0;
+		if (system_symbol_get(entry.site, &name, &offset)) {
+			len = snprintf(line, sizeof(line), "%s+0x%lx", name,
+				       (unsigned long)offset);
+		} else {
+			len = snprintf(line, sizeof(line), "%p", entry.site);
+		}
+		if ((len >= 0) && (len < (int)sizeof(line))) {
+			len += snprintf(line + len, sizeof(line) - len,
+					" live=%u count=%u allocs=%u peak=%u\n",
+					(unsigned)entry.live_bytes,
+					(unsigned)entry.live_count,
+					(unsigned)entry.allocs,
+					(unsigned)entry.peak_bytes);
+		}
+		if (len >= (int)sizeof(line)) {
+			len = sizeof(line) - 1;
+		}
+		if (!write(arg, line, len)) {
+			break;
+		}
+		lines++;
+	}
+	return lines;
+}
+#endif
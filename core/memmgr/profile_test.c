@@ -0,0 +1,275 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/profile.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+#if MM_CFG_PROFILE
+/* helpers -------------------------------------------------------------------*/
+#define			OUT_SIZE		(512)
+
+static char gs_out[OUT_SIZE];
+static uint32_t gs_out_len = 0;
+static uint32_t gs_out_lines = 0;
+
+static void *		alloc_here		(uint32_t size);
+static void *		alloc_there		(uint32_t size);
+static void *		zalloc_here		(uint32_t size);
+static bool		write_out		(void *arg,
+						 const char *line,
+						 uint32_t len);
+
+/* two distinct call sites */
+__attribute__((noinline)) static void *alloc_here(uint32_t size)
+{
+	return mm_alloc(size);
+}
+
+__attribute__((noinline)) static void *alloc_there(uint32_t size)
+{
+	return mm_alloc(size);
+}
+
+__attribute__((noinline)) static void *zalloc_here(uint32_t size)
+{
+	return mm_zalloc(size);
+}
+
+static bool write_out(void *arg, const char *line, uint32_t len)
+{
+	uint32_t *limit = arg;
+	if ((gs_out_len + len >= OUT_SIZE) ||
+	    ((limit != NULL) && (gs_out_lines == *limit))) {
+		return false;
+	}
+	memcpy(gs_out + gs_out_len, line, len);
+	gs_out_len += len;
+	gs_out[gs_out_len] = '\0';
+	gs_out_lines++;
+	return true;
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_profile);
+
+TEST_GROUP_RUNNER(mm_profile)
+{
+	RUN_TEST_CASE(mm_profile, counts_per_call_site);
+	RUN_TEST_CASE(mm_profile, free_keeps_the_peak);
+	RUN_TEST_CASE(mm_profile, realloc_moves_block_to_its_site);
+	RUN_TEST_CASE(mm_profile, zalloc_counts_for_its_caller);
+	RUN_TEST_CASE(mm_profile, batch_counts_each_block);
+	RUN_TEST_CASE(mm_profile, top_follows_order);
+	RUN_TEST_CASE(mm_profile, unknown_free_is_ignored);
+	RUN_TEST_CASE(mm_profile, full_table_drops_sites);
+	RUN_TEST_CASE(mm_profile, dump_writes_a_line_per_site);
+	RUN_TEST_CASE(mm_profile, dump_stops_on_write_failure);
+}
+
+TEST_SETUP(mm_profile)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_profile_reset();
+	gs_out_len = 0;
+	gs_out_lines = 0;
+	gs_out[0] = '\0';
+}
+
+TEST_TEAR_DOWN(mm_profile)
+{
+	mm_profile_reset();
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_profile, counts_per_call_site)
+{
+	mm_profile_site_t top[3];
+	void *a = alloc_here(10);
+	void *b = alloc_here(20);
+	void *c = alloc_there(5);
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_profile_top(top, 3, MM_PROFILE_BY_LIVE));
+	TEST_ASSERT_TRUE(top[0].site != top[1].site);
+	TEST_ASSERT_EQUAL_PTR(mm_chunk_allocator_get(mm_tochunk(a)), top[0].site);
+	TEST_ASSERT_EQUAL_UINT32(30, top[0].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, top[0].live_count);
+	TEST_ASSERT_EQUAL_UINT32(2, top[0].allocs);
+	TEST_ASSERT_EQUAL_UINT32(5, top[1].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, top[1].live_count);
+
+	mm_free(a);
+	mm_free(b);
+	mm_free(c);
+}
+
+TEST(mm_profile, free_keeps_the_peak)
+{
+	mm_profile_site_t top[1];
+	void *a = alloc_here(10);
+	void *b = alloc_here(20);
+	mm_free(a);
+	mm_free(b);
+	a = alloc_here(4);
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_profile_top(top, 1, MM_PROFILE_BY_LIVE));
+	TEST_ASSERT_EQUAL_UINT32(4, top[0].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, top[0].live_count);
+	TEST_ASSERT_EQUAL_UINT32(3, top[0].allocs);
+	TEST_ASSERT_EQUAL_UINT32(30, top[0].peak_bytes);
+	mm_free(a);
+}
+
+TEST(mm_profile, realloc_moves_block_to_its_site)
+{
+	mm_profile_site_t top[2];
+	void *a = alloc_here(10);
+	void *c = alloc_there(10);
+	// too big to grow in place, moved by a nested mm_alloc and mm_free
+	void *b = mm_realloc(a, 100);
+	TEST_ASSERT_TRUE(a != b);
+
+	TEST_ASSERT_EQUAL_UINT32(3, mm_profile_top(top, 2, MM_PROFILE_BY_LIVE) + 1);
+	TEST_ASSERT_EQUAL_PTR(mm_chunk_allocator_get(mm_tochunk(b)), top[0].site);
+	TEST_ASSERT_EQUAL_UINT32(100, top[0].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, top[0].allocs);
+	TEST_ASSERT_EQUAL_UINT32(10, top[1].live_bytes);
+
+	// a failed realloc leaves the block where it was
+	TEST_ASSERT_NULL(mm_realloc(b, 100000));
+	mm_profile_top(top, 1, MM_PROFILE_BY_LIVE);
+	TEST_ASSERT_EQUAL_UINT32(100, top[0].live_bytes);
+
+	mm_free(b);
+	mm_free(c);
+	mm_profile_top(top, 1, MM_PROFILE_BY_LIVE);
+	TEST_ASSERT_EQUAL_UINT32(0, top[0].live_bytes);
+}
+
+TEST(mm_profile, zalloc_counts_for_its_caller)
+{
+	mm_profile_site_t top[2];
+	void *a = zalloc_here(10);
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_profile_top(top, 2, MM_PROFILE_BY_LIVE));
+	TEST_ASSERT_EQUAL_PTR(mm_chunk_allocator_get(mm_tochunk(a)), top[0].site);
+	TEST_ASSERT_EQUAL_UINT32(10, top[0].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, top[0].live_count);
+	TEST_ASSERT_EQUAL_UINT32(0, top[1].live_count);
+	mm_free(a);
+}
+
+TEST(mm_profile, batch_counts_each_block)
+{
+	mm_profile_site_t top[1];
+	uint32_t sizes[] = {10, 0, 20};
+	void *out[3];
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_alloc_batch(3, sizes, out));
+	TEST_ASSERT_EQUAL_UINT32(1, mm_profile_top(top, 1, MM_PROFILE_BY_LIVE));
+	TEST_ASSERT_EQUAL_UINT32(30, top[0].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, top[0].live_count);
+
+	mm_free_batch(out, 3);
+	mm_profile_top(top, 1, MM_PROFILE_BY_LIVE);
+	TEST_ASSERT_EQUAL_UINT32(0, top[0].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(0, top[0].live_count);
+}
+
+TEST(mm_profile, top_follows_order)
+{
+	mm_profile_site_t top[4];
+	mm_lock();
+	mm_profile_alloc((void *)0x100, 50);
+	mm_profile_alloc((void *)0x200, 10);
+	mm_profile_alloc((void *)0x200, 10);
+	mm_profile_alloc((void *)0x200, 10);
+	mm_profile_alloc((void *)0x300, 100);
+	mm_profile_free((void *)0x300, 100);
+	mm_unlock();
+
+	TEST_ASSERT_EQUAL_UINT32(3, mm_profile_top(top, 4, MM_PROFILE_BY_LIVE));
+	TEST_ASSERT_EQUAL_PTR((void *)0x100, top[0].site);
+	TEST_ASSERT_EQUAL_PTR((void *)0x200, top[1].site);
+	TEST_ASSERT_EQUAL_PTR((void *)0x300, top[2].site);
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_profile_top(top, 2, MM_PROFILE_BY_ALLOCS));
+	TEST_ASSERT_EQUAL_PTR((void *)0x200, top[0].site);
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_profile_top(top, 1, MM_PROFILE_BY_PEAK));
+	TEST_ASSERT_EQUAL_PTR((void *)0x300, top[0].site);
+	TEST_ASSERT_EQUAL_UINT32(0, mm_profile_top(top, 0, MM_PROFILE_BY_PEAK));
+}
+
+TEST(mm_profile, unknown_free_is_ignored)
+{
+	mm_profile_site_t top[2];
+	void *a = alloc_there(10);
+	mm_profile_reset();
+	void *b = alloc_here(20);
+	mm_free(a);
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_profile_top(top, 2, MM_PROFILE_BY_LIVE));
+	TEST_ASSERT_EQUAL_UINT32(20, top[0].live_bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, top[0].live_count);
+	mm_free(b);
+}
+
+TEST(mm_profile, full_table_drops_sites)
+{
+	mm_lock();
+	for (uintptr_t i = 1; i <= MM_CFG_PROFILE_SITES + 2; i++) {
+		mm_profile_alloc((void *)(i * 16), 1);
+	}
+	mm_unlock();
+	TEST_ASSERT_EQUAL_UINT32(2, mm_profile_dropped());
+	mm_profile_reset();
+	TEST_ASSERT_EQUAL_UINT32(0, mm_profile_dropped());
+}
+
+TEST(mm_profile, dump_writes_a_line_per_site)
+{
+	mm_lock();
+	mm_profile_alloc((void *)0x100, 10);
+	mm_profile_alloc((void *)0x200, 20);
+	mm_unlock();
+
+	TEST_ASSERT_EQUAL_UINT32(2, mm_profile_dump(write_out, NULL));
+	TEST_ASSERT_NOT_NULL(strstr(gs_out, " live=10 count=1 allocs=1 peak=10\n"));
+	TEST_ASSERT_NOT_NULL(strstr(gs_out, " live=20 count=1 allocs=1 peak=20\n"));
+}
+
+TEST(mm_profile, dump_stops_on_write_failure)
+{
+	uint32_t limit = 1;
+	mm_lock();
+	mm_profile_alloc((void *)0x100, 10);
+	mm_profile_alloc((void *)0x200, 20);
+	mm_unlock();
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_profile_dump(write_out, &limit));
+	TEST_ASSERT_EQUAL_UINT32(1, gs_out_lines);
+}
+#endif
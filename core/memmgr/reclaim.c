@@ -0,0 +1,213 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "os/memmgr.h"
+#include "os/task.h"
+#include "memmgr/cache.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/reclaim.h"
+
+#include "memmgr_conf.h"
+
+#if MM_CFG_RECLAIM
+/*
+ * Everything here runs under the lock of the default heap, which is
+ * recursive: shrinkers free straight into the heap that is being searched.
+ * While a run or the reserve is in progress, nested allocations fail instead
+ * of reclaiming again and frees do not take the reserve back.
+ */
+
+/* Prototypes ----------------------------------------------------------------*/
+static mm_chunk_t *	mm_reclaim_find		(uint32_t csize);
+static void		mm_reclaim_take		(void);
+
+/* Variables -----------------------------------------------------------------*/
+static mm_shrinker_t	*gs_shrinkers = NULL;
+static mm_reclaim_stats_t gs_stats;
+static void		*gs_reserve = NULL;
+static uint32_t		gs_reserve_size = 0;
+/* set by mm_alloc_critical */
+static bool		gs_critical = false;
+static bool		gs_reclaiming = false;
+
+/* Private functions definitions ---------------------------------------------*/
+static mm_chunk_t *mm_reclaim_find(uint32_t csize)
+{
+#if MM_CFG_TASK_CACHE
+	// what was just freed may sit in the cache of the caller
+	mm_cache_drain(task_mm_cache_get());
+#endif
+	return mm_find_first_free(csize);
+}
+
+/* the lock is held and gs_reserve is NULL */
+static void mm_reclaim_take(void)
+{
+	gs_reclaiming = true;
+	gs_reserve = mm_alloc_uncached(gs_reserve_size, NULL);
+	gs_reclaiming = false;
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_shrinker_register(mm_shrinker_t *this, mm_shrink_f shrink, void *arg,
+			  uint32_t priority)
+{
+	this->shrink = shrink;
+	this->arg = arg;
+	this->priority = priority;
+
+	mm_lock();
+	mm_shrinker_t **it = &gs_shrinkers;
+	while ((*it != NULL) && ((*it)->priority <= priority)) {
+		it = &(*it)->next;
+	}
+	this->next = *it;
+	*it = this;
+	mm_unlock();
+}
+
+void mm_shrinker_unregister(mm_shrinker_t *this)
+{
+	mm_lock();
+	mm_shrinker_t **it = &gs_shrinkers;
+	while ((*it != NULL) && (*it != this)) {
+		it = &(*it)->next;
+	}
+	if (*it != NULL) {
+		*it = this->next;
+	}
+	this->next = NULL;
+	mm_unlock();
+}
+
+bool mm_reserve_set(uint32_t size)
+{
+	mm_lock();
+	gs_reserve_size = 0;
+	if (gs_reserve != NULL) {
+		void *reserve = gs_reserve;
+		gs_reserve = NULL;
+		mm_free_uncached(reserve);
+	}
+	gs_reserve_size = size;
+	if (size != 0) {
+		mm_reclaim_take();
+	}
+	bool held = (size == 0) || (gs_reserve != NULL);
+	mm_unlock();
+	return held;
+}
+
+uint32_t mm_reserve_get(void)
+{
+	mm_lock();
+	uint32_t size = (gs_reserve != NULL) ? gs_reserve_size : 0;
+	mm_unlock();
+	return size;
+}
+
+void *mm_alloc_critical(uint32_t size)
+{
+	mm_lock();
+	bool critical = gs_critical;
+	gs_critical = true;
+	void *ptr = mm_alloc(size);
+	gs_critical = critical;
+	if (ptr != NULL) {
+		mm_allocator_update(ptr);
+	}
+	mm_unlock();
+	return ptr;
+}
+
+void mm_reclaim_stats_get(mm_reclaim_stats_t *stats)
+{
+	mm_lock();
+	*stats = gs_stats;
+	mm_unlock();
+}
+
+void mm_reclaim_reset(void)
+{
+	gs_shrinkers = NULL;
+	memset(&gs_stats, 0, sizeof(gs_stats));
+	// the heap is laid out again, the reserve went with it
+	gs_reserve = NULL;
+	gs_reserve_size = 0;
+	gs_critical = false;
+	gs_reclaiming = false;
+}
+
+mm_chunk_t *mm_reclaim_run(uint32_t csize)
+{
+	if (gs_reclaiming) {
+		return NULL;
+	}
+	gs_reclaiming = true;
+	gs_stats.runs++;
+
+	// frees of the shrinkers are watched even under a moving mm_realloc
+	mm_heap_t *heap = mm_heap_default();
+	task_t *untraced = heap->untraced;
+	heap->untraced = NULL;
+
+	mm_chunk_t *chnk = NULL;
+#if MM_CFG_TASK_CACHE
+	chnk = mm_reclaim_find(csize);
+#endif
+	mm_shrinker_t *it = gs_shrinkers;
+	for (; (chnk == NULL) && (it != NULL); it = it->next) {
+		if (it->shrink(it->arg, csize * MM_CFG_ALIGNMENT) != 0) {
+			chnk = mm_reclaim_find(csize);
+		}
+	}
+	if ((chnk == NULL) && gs_critical && (gs_reserve != NULL)) {
+		void *reserve = gs_reserve;
+		gs_reserve = NULL;
+		mm_free_uncached(reserve);
+		gs_stats.reserve_used++;
+		chnk = mm_find_first_free(csize);
+	}
+
+	heap->untraced = untraced;
+	// the block a zeroing allocation cleared may have gone back to the heap
+	heap->zeroed = NULL;
+	gs_stats.rescued += (chnk != NULL);
+	gs_reclaiming = false;
+	return chnk;
+}
+
+void mm_reclaim_rearm(void)
+{
+	// only a spent reserve takes the lock
+	if ((gs_reserve != NULL) || (gs_reserve_size == 0)) {
+		return;
+	}
+	mm_lock();
+	if ((gs_reserve == NULL) && (gs_reserve_size != 0) && !gs_reclaiming) {
+		mm_reclaim_take();
+	}
+	mm_unlock();
+}
+#endif
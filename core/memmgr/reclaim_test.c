@@ -0,0 +1,267 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/chunk.h"
+#include "memmgr/pool.h"
+#include "memmgr/reclaim.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+static mm_shrinker_t gs_shrinkers[4];
+static void *gs_held[4];
+static uintptr_t gs_order[8];
+static uint32_t gs_calls = 0;
+static void *gs_inner = NULL;
+
+static uint32_t		release_held		(void *arg,
+						 uint32_t size);
+static uint32_t		alloc_inside		(void *arg,
+						 uint32_t size);
+
+/* frees the block held at index arg */
+static uint32_t release_held(void *arg, uint32_t size)
+{
+	(void)size;
+	uintptr_t i = (uintptr_t)arg;
+	gs_order[gs_calls++] = i;
+	if (gs_held[i] == NULL) {
+		return 0;
+	}
+	mm_free(gs_held[i]);
+	gs_held[i] = NULL;
+	return 1;
+}
+
+static uint32_t alloc_inside(void *arg, uint32_t size)
+{
+	(void)arg;
+	gs_calls++;
+	gs_inner = mm_alloc(size);
+	return 0;
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_reclaim);
+
+TEST_GROUP_RUNNER(mm_reclaim)
+{
+	RUN_TEST_CASE(mm_reclaim, shrinkers_run_in_priority_order);
+	RUN_TEST_CASE(mm_reclaim, stops_once_room_is_found);
+	RUN_TEST_CASE(mm_reclaim, goes_on_until_room_is_found);
+	RUN_TEST_CASE(mm_reclaim, unregistered_shrinker_is_not_called);
+	RUN_TEST_CASE(mm_reclaim, nested_allocation_does_not_reclaim);
+	RUN_TEST_CASE(mm_reclaim, moving_realloc_reclaims);
+	RUN_TEST_CASE(mm_reclaim, idle_pools_are_given_back);
+	RUN_TEST_CASE(mm_reclaim, reserve_is_for_critical_callers);
+	RUN_TEST_CASE(mm_reclaim, reserve_is_taken_again_by_a_free);
+	RUN_TEST_CASE(mm_reclaim, reserve_set_gives_it_back);
+}
+
+TEST_SETUP(mm_reclaim)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_reclaim_reset();
+	memset(gs_held, 0, sizeof(gs_held));
+	gs_calls = 0;
+	gs_inner = NULL;
+}
+
+TEST_TEAR_DOWN(mm_reclaim)
+{
+	mm_reclaim_reset();
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_reclaim, shrinkers_run_in_priority_order)
+{
+	mm_reclaim_stats_t stats;
+	void *filler = mm_alloc(900);
+	mm_shrinker_register(&gs_shrinkers[0], release_held, (void *)0, 5);
+	mm_shrinker_register(&gs_shrinkers[1], release_held, (void *)1, 1);
+	mm_shrinker_register(&gs_shrinkers[2], release_held, (void *)2, 3);
+	mm_shrinker_register(&gs_shrinkers[3], release_held, (void *)3, 1);
+
+	TEST_ASSERT_NOT_NULL(filler);
+	TEST_ASSERT_NULL(mm_alloc(200));
+	TEST_ASSERT_EQUAL_UINT32(4, gs_calls);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_order[0]);
+	TEST_ASSERT_EQUAL_UINT32(3, gs_order[1]);
+	TEST_ASSERT_EQUAL_UINT32(2, gs_order[2]);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_order[3]);
+
+	mm_reclaim_stats_get(&stats);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.runs);
+	TEST_ASSERT_EQUAL_UINT32(0, stats.rescued);
+	mm_free(filler);
+}
+
+TEST(mm_reclaim, stops_once_room_is_found)
+{
+	mm_reclaim_stats_t stats;
+	for (uint32_t i = 0; i < 3; i++) {
+		gs_held[i] = mm_alloc(300);
+		TEST_ASSERT_NOT_NULL(gs_held[i]);
+		mm_shrinker_register(&gs_shrinkers[i], release_held, (void *)(uintptr_t)i, i);
+	}
+
+	void *ptr = mm_alloc(200);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_calls);
+	TEST_ASSERT_NULL(gs_held[0]);
+	TEST_ASSERT_NOT_NULL(gs_held[1]);
+
+	mm_reclaim_stats_get(&stats);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.runs);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.rescued);
+	mm_free(ptr);
+	mm_free(gs_held[1]);
+	mm_free(gs_held[2]);
+}
+
+TEST(mm_reclaim, goes_on_until_room_is_found)
+{
+	gs_held[0] = mm_alloc(100);
+	gs_held[1] = mm_alloc(400);
+	void *filler = mm_alloc(400);
+	mm_shrinker_register(&gs_shrinkers[0], release_held, (void *)0, 0);
+	mm_shrinker_register(&gs_shrinkers[1], release_held, (void *)1, 1);
+
+	// the first block alone is too small
+	void *ptr = mm_alloc(300);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_EQUAL_UINT32(2, gs_calls);
+	TEST_ASSERT_NULL(gs_held[1]);
+	mm_free(ptr);
+	mm_free(filler);
+}
+
+TEST(mm_reclaim, unregistered_shrinker_is_not_called)
+{
+	void *filler = mm_alloc(900);
+	mm_shrinker_register(&gs_shrinkers[0], release_held, (void *)0, 0);
+	mm_shrinker_register(&gs_shrinkers[1], release_held, (void *)1, 1);
+	mm_shrinker_unregister(&gs_shrinkers[0]);
+
+	TEST_ASSERT_NULL(mm_alloc(200));
+	TEST_ASSERT_EQUAL_UINT32(1, gs_calls);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_order[0]);
+	mm_free(filler);
+}
+
+TEST(mm_reclaim, nested_allocation_does_not_reclaim)
+{
+	void *filler = mm_alloc(900);
+	mm_shrinker_register(&gs_shrinkers[0], alloc_inside, NULL, 0);
+
+	TEST_ASSERT_NULL(mm_alloc(200));
+	TEST_ASSERT_EQUAL_UINT32(1, gs_calls);
+	TEST_ASSERT_NULL(gs_inner);
+	mm_free(filler);
+}
+
+TEST(mm_reclaim, moving_realloc_reclaims)
+{
+	gs_held[0] = mm_alloc(500);
+	uint8_t *ptr = mm_alloc(CHUNK_TEST_UNCACHED);
+	void *filler = mm_alloc(300);
+	mm_shrinker_register(&gs_shrinkers[0], release_held, (void *)0, 0);
+	memset(ptr, 0x5A, CHUNK_TEST_UNCACHED);
+
+	ptr = mm_realloc(ptr, 450);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_NULL(gs_held[0]);
+	for (uint32_t i = 0; i < CHUNK_TEST_UNCACHED; i++) {
+		TEST_ASSERT_EQUAL_UINT32(0x5A, ptr[i]);
+	}
+	mm_free(ptr);
+	mm_free(filler);
+}
+
+TEST(mm_reclaim, idle_pools_are_given_back)
+{
+	mm_pool_t pool;
+	mm_pool_init(&pool, 64, 8);
+	mm_pool_free(&pool, mm_pool_alloc(&pool));
+	TEST_ASSERT_NOT_NULL(pool.blocks);
+
+	void *ptr = mm_alloc(600);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_NULL(pool.blocks);
+	mm_free(ptr);
+}
+
+TEST(mm_reclaim, reserve_is_for_critical_callers)
+{
+	mm_reclaim_stats_t stats;
+	TEST_ASSERT_TRUE(mm_reserve_set(200));
+	TEST_ASSERT_EQUAL_UINT32(200, mm_reserve_get());
+	void *filler = mm_alloc(700);
+	TEST_ASSERT_NOT_NULL(filler);
+
+	TEST_ASSERT_NULL(mm_alloc(150));
+	TEST_ASSERT_EQUAL_UINT32(200, mm_reserve_get());
+	void *ptr = mm_alloc_critical(150);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_EQUAL_UINT32(0, mm_reserve_get());
+
+	mm_reclaim_stats_get(&stats);
+	TEST_ASSERT_EQUAL_UINT32(2, stats.runs);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.rescued);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.reserve_used);
+	mm_free(filler);
+	mm_free(ptr);
+}
+
+TEST(mm_reclaim, reserve_is_taken_again_by_a_free)
+{
+	mm_reserve_set(200);
+	void *filler = mm_alloc(700);
+	void *ptr = mm_alloc_critical(150);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_EQUAL_UINT32(0, mm_reserve_get());
+
+	mm_free(ptr);
+	TEST_ASSERT_EQUAL_UINT32(200, mm_reserve_get());
+	// critical callers do not spend more than they need
+	TEST_ASSERT_NULL(mm_alloc(150));
+	mm_free(filler);
+}
+
+TEST(mm_reclaim, reserve_set_gives_it_back)
+{
+	TEST_ASSERT_TRUE(mm_reserve_set(900));
+	TEST_ASSERT_NULL(mm_alloc(800));
+	TEST_ASSERT_TRUE(mm_reserve_set(0));
+	TEST_ASSERT_EQUAL_UINT32(0, mm_reserve_get());
+
+	void *ptr = mm_alloc(800);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_FALSE(mm_reserve_set(900));
+	TEST_ASSERT_EQUAL_UINT32(0, mm_reserve_get());
+	mm_free(ptr);
+	// the size is kept, a free takes it as soon as it fits
+	TEST_ASSERT_EQUAL_UINT32(900, mm_reserve_get());
+}
@@ -0,0 +1,44 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memmgr/remote.h"
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_remote_init(mm_remote_t *this)
+{
+	__atomic_store_n(&this->head, NULL, __ATOMIC_RELEASE);
+}
+
+void mm_remote_push(mm_remote_t *this, mm_remote_node_t *first,
+		    mm_remote_node_t *last)
+{
+	mm_remote_node_t *head = __atomic_load_n(&this->head, __ATOMIC_RELAXED);
+	do {
+		last->next = head;
+	} while (!__atomic_compare_exchange_n(&this->head, &head, first, true,
+					      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+mm_remote_node_t *mm_remote_take(mm_remote_t *this)
+{
+	// taking everything at once leaves no room for ABA
+	return __atomic_exchange_n(&this->head, NULL, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,124 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "unity_fixture.h"
+#include "memmgr/remote.h"
+#include "os/task.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			TASK_COUNT		(4)
+#define			NODE_COUNT		(1000)
+
+static void		push_nodes		(void *arg);
+static uint32_t		chain_length		(mm_remote_node_t *node);
+
+static mm_remote_t gs_remote;
+static mm_remote_node_t gs_nodes[TASK_COUNT][NODE_COUNT];
+
+static void push_nodes(void *arg)
+{
+	mm_remote_node_t *nodes = arg;
+	for (uint32_t i = 0; i < NODE_COUNT; i++) {
+		mm_remote_push(&gs_remote, &nodes[i], &nodes[i]);
+	}
+}
+
+static uint32_t chain_length(mm_remote_node_t *node)
+{
+	uint32_t len = 0;
+	while (node != NULL) {
+		len++;
+		node = node->next;
+	}
+	return len;
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_remote);
+
+TEST_GROUP_RUNNER(mm_remote)
+{
+	RUN_TEST_CASE(mm_remote, take_empty_gives_null);
+	RUN_TEST_CASE(mm_remote, take_is_last_in_first_out);
+	RUN_TEST_CASE(mm_remote, push_a_chain);
+	RUN_TEST_CASE(mm_remote, concurrent_pushes_are_not_lost);
+}
+
+TEST_SETUP(mm_remote)
+{
+	mm_remote_init(&gs_remote);
+}
+
+TEST_TEAR_DOWN(mm_remote)
+{
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_remote, take_empty_gives_null)
+{
+	TEST_ASSERT_NULL(mm_remote_take(&gs_remote));
+}
+
+TEST(mm_remote, take_is_last_in_first_out)
+{
+	mm_remote_push(&gs_remote, &gs_nodes[0][0], &gs_nodes[0][0]);
+	mm_remote_push(&gs_remote, &gs_nodes[0][1], &gs_nodes[0][1]);
+
+	mm_remote_node_t *node = mm_remote_take(&gs_remote);
+	TEST_ASSERT_EQUAL_PTR(&gs_nodes[0][1], node);
+	TEST_ASSERT_EQUAL_PTR(&gs_nodes[0][0], node->next);
+	TEST_ASSERT_NULL(node->next->next);
+	TEST_ASSERT_NULL(mm_remote_take(&gs_remote));
+}
+
+TEST(mm_remote, push_a_chain)
+{
+	gs_nodes[0][0].next = &gs_nodes[0][1];
+	gs_nodes[0][1].next = &gs_nodes[0][2];
+	mm_remote_push(&gs_remote, &gs_nodes[1][0], &gs_nodes[1][0]);
+	mm_remote_push(&gs_remote, &gs_nodes[0][0], &gs_nodes[0][2]);
+
+	mm_remote_node_t *node = mm_remote_take(&gs_remote);
+	TEST_ASSERT_EQUAL_PTR(&gs_nodes[0][0], node);
+	TEST_ASSERT_EQUAL_PTR(&gs_nodes[1][0], gs_nodes[0][2].next);
+	TEST_ASSERT_EQUAL_UINT32(4, chain_length(node));
+}
+
+TEST(mm_remote, concurrent_pushes_are_not_lost)
+{
+	task_t *tsk[TASK_COUNT];
+	uint32_t len = 0;
+
+	for (uint32_t i = 0; i < TASK_COUNT; i++) {
+		tsk[i] = task_create(push_nodes, gs_nodes[i], 0, 0, "test_remote");
+		TEST_ASSERT_NOT_NULL(tsk[i]);
+		TEST_ASSERT_TRUE(task_start(tsk[i]));
+	}
+	// drain while the others push
+	while (len < TASK_COUNT*NODE_COUNT) {
+		len += chain_length(mm_remote_take(&gs_remote));
+	}
+	for (uint32_t i = 0; i < TASK_COUNT; i++) {
+		object_delete(&tsk[i]->base);
+	}
+	TEST_ASSERT_EQUAL_UINT32(TASK_COUNT*NODE_COUNT, len);
+	TEST_ASSERT_NULL(mm_remote_take(&gs_remote));
+}
@@ -0,0 +1,107 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/common.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/scrub.h"
+
+#include "memmgr_conf.h"
+
+/* Prototypes ----------------------------------------------------------------*/
+static void		mm_scrub_task		(void *arg);
+
+/* Private functions definitions ---------------------------------------------*/
+static void mm_scrub_task(void *arg)
+{
+	mm_scrub_t *this = arg;
+	while (!task_must_stop(this->task)) {
+		mm_scrub_step(this);
+		task_delay_ms(this->period_ms);
+	}
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_scrub_init(mm_scrub_t *this, mm_heap_t *heap, uint32_t chunks)
+{
+	this->heap = (heap != NULL) ? heap : mm_heap_default();
+	this->chunks = umax(chunks, 1);
+	this->period_ms = 0;
+	this->task = NULL;
+	this->zero_free = false;
+	this->steps = 0;
+	this->passes = 0;
+}
+
+bool mm_scrub_step(mm_scrub_t *this)
+{
+	mm_heap_lock(this->heap);
+	mm_chunk_ctx_t *ctx = mm_chunk_ctx_get();
+	mm_chunk_t *chnk = ctx->cursor;
+	if (chnk == NULL) {
+		chnk = ctx->boundary.first;
+	}
+
+	for (uint32_t i = 0; (i < this->chunks) && (chnk != NULL); i++) {
+		mm_chunk_validate(chnk);
+		if (this->zero_free && mm_chunk_is_available(chnk) &&
+		    !mm_chunk_zeroed_get(chnk)) {
+			mm_chunk_zero(chnk);
+		}
+		chnk = mm_chunk_walk_next(chnk);
+	}
+
+	ctx->cursor = chnk;
+	this->steps ++;
+	if (chnk == NULL) {
+		this->passes ++;
+	}
+	mm_heap_unlock(this->heap);
+	return (chnk == NULL);
+}
+
+bool mm_scrub_start(mm_scrub_t *this, uint32_t period_ms, uint32_t priority)
+{
+	// a task that never sleeps would hold the heap lock back to back
+	if ((this->task != NULL) || (period_ms == 0)) {
+		return false;
+	}
+
+	this->period_ms = period_ms;
+	this->task = task_create(mm_scrub_task, this, MM_CFG_SCRUB_STACK_SIZE,
+				 priority, "mm scrub");
+	if (this->task == NULL) {
+		return false;
+	}
+	if (!task_start(this->task)) {
+		object_delete(&this->task->base);
+		this->task = NULL;
+		return false;
+	}
+	return true;
+}
+
+void mm_scrub_stop(mm_scrub_t *this)
+{
+	if (this->task != NULL) {
+		object_delete(&this->task->base);
+		this->task = NULL;
+	}
+}
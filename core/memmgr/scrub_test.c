@@ -0,0 +1,172 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <unistd.h>
+
+#include "unity_fixture.h"
+#include "tests/memmgr_unity.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/scrub.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			HEAP_SIZE		(4096)
+
+static uint8_t gs_buf[HEAP_SIZE] __attribute__((aligned(8)));
+static mm_heap_t *gs_heap = NULL;
+static mm_scrub_t gs_scrub;
+
+static mm_chunk_t *	chunk_of		(void *ptr);
+
+static mm_chunk_t *chunk_of(void *ptr)
+{
+	return (mm_chunk_t *)((uint8_t *)ptr - (mm_header_csize() * MM_CFG_ALIGNMENT));
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_scrub);
+
+TEST_GROUP_RUNNER(mm_scrub)
+{
+	RUN_TEST_CASE(mm_scrub, step_is_bounded);
+	RUN_TEST_CASE(mm_scrub, passes_restart_from_first_chunk);
+	RUN_TEST_CASE(mm_scrub, cursor_survives_merge);
+	RUN_TEST_CASE(mm_scrub, corruption_leads_to_death);
+	RUN_TEST_CASE(mm_scrub, task_scrubs_in_background);
+	RUN_TEST_CASE(mm_scrub, zero_period_is_refused);
+	RUN_TEST_CASE(mm_scrub, zero_free_clears_free_chunks);
+}
+
+TEST_SETUP(mm_scrub)
+{
+	unity_mock_setup();
+	gs_heap = mm_heap_init(gs_buf, HEAP_SIZE);
+	TEST_ASSERT_NOT_NULL(gs_heap);
+	mm_scrub_init(&gs_scrub, gs_heap, 1);
+}
+
+TEST_TEAR_DOWN(mm_scrub)
+{
+	mm_scrub_stop(&gs_scrub);
+	mm_heap_release(gs_heap);
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_scrub, step_is_bounded)
+{
+	mm_heap_alloc(gs_heap, 32);
+	mm_heap_alloc(gs_heap, 32);
+	mm_heap_alloc(gs_heap, 32);
+
+	/* 3 allocated chunks and the remaining free one */
+	TEST_ASSERT_FALSE(mm_scrub_step(&gs_scrub));
+	TEST_ASSERT_FALSE(mm_scrub_step(&gs_scrub));
+	TEST_ASSERT_FALSE(mm_scrub_step(&gs_scrub));
+	TEST_ASSERT_TRUE(mm_scrub_step(&gs_scrub));
+	TEST_ASSERT_EQUAL_UINT32(4, gs_scrub.steps);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_scrub.passes);
+}
+
+TEST(mm_scrub, passes_restart_from_first_chunk)
+{
+	mm_scrub_init(&gs_scrub, gs_heap, 8);
+	mm_heap_alloc(gs_heap, 32);
+
+	TEST_ASSERT_TRUE(mm_scrub_step(&gs_scrub));
+	TEST_ASSERT_TRUE(mm_scrub_step(&gs_scrub));
+	TEST_ASSERT_EQUAL_UINT32(2, gs_scrub.passes);
+}
+
+TEST(mm_scrub, cursor_survives_merge)
+{
+	mm_heap_alloc(gs_heap, 32);
+	void *b = mm_heap_alloc(gs_heap, 32);
+	void *c = mm_heap_alloc(gs_heap, 32);
+
+	mm_scrub_step(&gs_scrub);
+	mm_scrub_step(&gs_scrub);
+	/* the cursor now is c, which gets merged into b */
+	mm_heap_free(gs_heap, b);
+	mm_heap_free(gs_heap, c);
+
+	/* b absorbed everything after it */
+	TEST_ASSERT_TRUE(mm_scrub_step(&gs_scrub));
+}
+
+TEST(mm_scrub, corruption_leads_to_death)
+{
+	mm_heap_alloc(gs_heap, 32);
+	void *b = mm_heap_alloc(gs_heap, 32);
+	chunk_of(b)->xorsum ^= 1;
+
+	mm_scrub_step(&gs_scrub);
+#if MM_CFG_INTEGRITY >= MM_INTEGRITY_CHECKSUM
+	EXPECT_ABORT_BEGIN
+	mm_scrub_step(&gs_scrub);
+	VERIFY_FAILS_END("MM: xorsum");
+
+	/* die() left gs_heap locked, with its chunk context selected */
+	mm_chunk_ctx_set(NULL);
+#else
+	/* nothing checks the header */
+	mm_scrub_step(&gs_scrub);
+#endif
+}
+
+TEST(mm_scrub, task_scrubs_in_background)
+{
+	TEST_ASSERT_TRUE(mm_scrub_start(&gs_scrub, 1, 0));
+	TEST_ASSERT_FALSE(mm_scrub_start(&gs_scrub, 1, 0));
+
+	for (uint32_t i = 0; (i < 1000) && (gs_scrub.passes == 0); i++) {
+		usleep(1000);
+	}
+	mm_scrub_stop(&gs_scrub);
+	TEST_ASSERT_TRUE(gs_scrub.passes > 0);
+}
+
+TEST(mm_scrub, zero_period_is_refused)
+{
+	TEST_ASSERT_FALSE(mm_scrub_start(&gs_scrub, 0, 0));
+	TEST_ASSERT_NULL(gs_scrub.task);
+}
+
+TEST(mm_scrub, zero_free_clears_free_chunks)
+{
+	uint8_t *a = mm_heap_alloc(gs_heap, 32);
+	uint8_t *b = mm_heap_alloc(gs_heap, 32);
+	memset(a, 0xAA, 32);
+	mm_heap_free(gs_heap, a);
+
+	gs_scrub.zero_free = true;
+	gs_scrub.chunks = 8;
+	TEST_ASSERT_TRUE(mm_scrub_step(&gs_scrub));
+
+	mm_heap_lock(gs_heap);
+	TEST_ASSERT_TRUE(mm_chunk_zeroed_get(chunk_of(a)));
+	TEST_ASSERT_FALSE(mm_chunk_zeroed_get(chunk_of(b)));
+	mm_heap_unlock(gs_heap);
+
+	uint8_t *c = mm_heap_zalloc(gs_heap, 32);
+	TEST_ASSERT_EQUAL_PTR(a, c);
+	for (uint32_t i = 0; i < 32; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, c[i]);
+	}
+}
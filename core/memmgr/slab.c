@@ -0,0 +1,326 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "os/memmgr.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/slab.h"
+#include "memmgr_conf.h"
+
+/*
+ * A slab is a chunk of the default heap holding MM_SLAB_SLOTS slots of one
+ * size after its header. Slabs are kept sorted by address so that a free
+ * rejects pointers out of [lo, hi) at once and finds the slab of the others
+ * with a binary search. The bounds are read without the lock: they only move
+ * when a slab is carved or released, neither of which can happen to the slab
+ * of a slot the caller still holds.
+ *
+ * The registry and the bitmaps have their own spinning lock so tiny requests
+ * never wait on the heap mutex. The heap lock is only taken to carve or
+ * release a slab, always after the slab lock was dropped, so the heap lock
+ * may be held while taking the slab lock but never the other way around.
+ */
+
+/* Macro definitions ---------------------------------------------------------*/
+#if (MM_CFG_SLAB_MAX_PAYLOAD % MM_CFG_ALIGNMENT) != 0
+#error "MM_CFG_SLAB_MAX_PAYLOAD must be a multiple of MM_CFG_ALIGNMENT"
+#endif
+
+#define MM_SLAB_MAGIC		(0x534C4142)
+#define MM_SLAB_FULL_MAP	(0xFFFFFFFF)
+#define MM_SLAB_HEADER		((sizeof(mm_slab_t) + MM_CFG_ALIGNMENT - 1) & \
+				 ~(MM_CFG_ALIGNMENT - 1))
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint32_t		mm_slab_bytes			(uint32_t slot_size);
+static uint8_t *	mm_slab_slots			(mm_slab_t *this);
+static mm_slab_t *	mm_slab_find			(void *ptr);
+static void		mm_slab_insert			(mm_slab_t *this);
+static void		mm_slab_remove			(mm_slab_t *this);
+static void		mm_slab_unlink			(mm_slab_t *this);
+static mm_slab_t *	mm_slab_carve			(uint32_t slot_size,
+							 void *lr);
+static void		mm_slab_lock			(void);
+static void		mm_slab_unlock			(void);
+
+/* Variables -----------------------------------------------------------------*/
+static mm_slab_t	*gs_slabs[MM_CFG_SLAB_COUNT];
+static uint32_t		gs_slab_count = 0;
+static uintptr_t	gs_slab_lo = 0;
+static uintptr_t	gs_slab_hi = 0;
+static mm_slab_t	*gs_partial[MM_SLAB_CLASSES];
+static bool		gs_slab_lock = false;
+
+/* Private functions definitions ---------------------------------------------*/
+static uint32_t mm_slab_bytes(uint32_t slot_size)
+{
+	return MM_SLAB_HEADER + (MM_SLAB_SLOTS * slot_size);
+}
+
+static uint8_t *mm_slab_slots(mm_slab_t *this)
+{
+	return (uint8_t *)this + MM_SLAB_HEADER;
+}
+
+static mm_slab_t *mm_slab_find(void *ptr)
+{
+	uintptr_t p = (uintptr_t)ptr;
+	if ((p < gs_slab_lo) || (p >= gs_slab_hi)) {
+		return NULL;
+	}
+
+	// last slab starting at or below ptr
+	uint32_t lo = 0, hi = gs_slab_count;
+	while (hi - lo > 1) {
+		uint32_t mid = (lo + hi) / 2;
+		if ((uintptr_t)gs_slabs[mid] <= p) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	mm_slab_t *slab = gs_slabs[lo];
+	uint8_t *slots = mm_slab_slots(slab);
+	if (((uint8_t *)ptr < slots) ||
+	    ((uint8_t *)ptr >= slots + (MM_SLAB_SLOTS * slab->slot_size))) {
+		return NULL;
+	}
+	return slab;
+}
+
+static void mm_slab_insert(mm_slab_t *this)
+{
+	uint32_t i = gs_slab_count;
+	while ((i > 0) && (gs_slabs[i - 1] > this)) {
+		gs_slabs[i] = gs_slabs[i - 1];
+		i--;
+	}
+	gs_slabs[i] = this;
+	gs_slab_count++;
+
+	mm_slab_t *last = gs_slabs[gs_slab_count - 1];
+	gs_slab_lo = (uintptr_t)gs_slabs[0];
+	gs_slab_hi = (uintptr_t)last + mm_slab_bytes(last->slot_size);
+}
+
+static void mm_slab_remove(mm_slab_t *this)
+{
+	uint32_t i = 0;
+	while ((i < gs_slab_count) && (gs_slabs[i] != this)) {
+		i++;
+	}
+	for (; i + 1 < gs_slab_count; i++) {
+		gs_slabs[i] = gs_slabs[i + 1];
+	}
+	gs_slab_count--;
+
+	if (gs_slab_count == 0) {
+		gs_slab_lo = 0;
+		gs_slab_hi = 0;
+	} else {
+		mm_slab_t *last = gs_slabs[gs_slab_count - 1];
+		gs_slab_lo = (uintptr_t)gs_slabs[0];
+		gs_slab_hi = (uintptr_t)last + mm_slab_bytes(last->slot_size);
+	}
+}
+
+/* take a slab out of the list of its class */
+static void mm_slab_unlink(mm_slab_t *this)
+{
+	mm_slab_t **it = &gs_partial[this->slot_size / MM_CFG_ALIGNMENT - 1];
+	while ((*it != NULL) && (*it != this)) {
+		it = &(*it)->next;
+	}
+	if (*it != NULL) {
+		*it = this->next;
+	}
+	this->next = NULL;
+}
+
+static void mm_slab_lock(void)
+{
+	while (__atomic_test_and_set(&gs_slab_lock, __ATOMIC_ACQUIRE)) {
+		while (__atomic_load_n(&gs_slab_lock, __ATOMIC_RELAXED)) {
+		}
+	}
+}
+
+static void mm_slab_unlock(void)
+{
+	__atomic_clear(&gs_slab_lock, __ATOMIC_RELEASE);
+}
+
+/* called without the slab lock, returns with it held on success */
+static mm_slab_t *mm_slab_carve(uint32_t slot_size, void *lr)
+{
+	if (gs_slab_count == MM_CFG_SLAB_COUNT) {
+		return NULL;
+	}
+	mm_slab_t *slab = mm_alloc_uncached(mm_slab_bytes(slot_size), lr);
+	if (slab == NULL) {
+		return NULL;
+	}
+
+	slab->magic = MM_SLAB_MAGIC;
+	slab->slot_size = slot_size;
+	slab->free_map = MM_SLAB_FULL_MAP;
+
+	mm_slab_lock();
+	// another task may have filled the registry meanwhile
+	if (gs_slab_count == MM_CFG_SLAB_COUNT) {
+		mm_slab_unlock();
+		mm_free_uncached(slab);
+		return NULL;
+	}
+	mm_slab_t **partial = &gs_partial[slot_size / MM_CFG_ALIGNMENT - 1];
+	slab->next = *partial;
+	*partial = slab;
+	mm_slab_insert(slab);
+	return slab;
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void *mm_slab_alloc(uint32_t size, void *lr)
+{
+	if ((size == 0) || (size > MM_CFG_SLAB_MAX_PAYLOAD)) {
+		return NULL;
+	}
+	uint32_t cls = (size - 1) / MM_CFG_ALIGNMENT;
+
+	mm_slab_lock();
+	mm_slab_t *slab = gs_partial[cls];
+	if (slab == NULL) {
+		mm_slab_unlock();
+		slab = mm_slab_carve((cls + 1) * MM_CFG_ALIGNMENT, lr);
+		if (slab == NULL) {
+			return NULL;
+		}
+		slab = gs_partial[cls];
+	}
+
+	uint32_t slot = __builtin_ctz(slab->free_map);
+	slab->free_map &= ~(1U << slot);
+	if (slab->free_map == 0) {
+		gs_partial[cls] = slab->next;
+		slab->next = NULL;
+	}
+	void *ptr = mm_slab_slots(slab) + (slot * slab->slot_size);
+	mm_slab_unlock();
+	return ptr;
+}
+
+bool mm_slab_free(void *ptr)
+{
+	if (((uintptr_t)ptr < gs_slab_lo) || ((uintptr_t)ptr >= gs_slab_hi)) {
+		return false;
+	}
+
+	mm_slab_lock();
+	mm_slab_t *slab = mm_slab_find(ptr);
+	if (slab == NULL) {
+		mm_slab_unlock();
+		return false;
+	}
+
+	uint32_t offset = (uint8_t *)ptr - mm_slab_slots(slab);
+	if ((offset % slab->slot_size) != 0) {
+		mm_slab_unlock();
+		die("MM: slab misaligned free");
+	}
+	uint32_t bit = 1U << (offset / slab->slot_size);
+	if ((slab->free_map & bit) != 0) {
+		mm_slab_unlock();
+		die("MM: double free");
+	}
+
+	mm_slab_t **partial = &gs_partial[slab->slot_size / MM_CFG_ALIGNMENT - 1];
+	if (slab->free_map == 0) {
+		slab->next = *partial;
+		*partial = slab;
+	}
+	slab->free_map |= bit;
+
+	// keep one slab with free slots per class to avoid carving back and forth
+	if ((slab->free_map == MM_SLAB_FULL_MAP) &&
+	    ((*partial != slab) || (slab->next != NULL))) {
+		mm_slab_unlink(slab);
+		mm_slab_remove(slab);
+		mm_slab_unlock();
+		mm_free_uncached(slab);
+		return true;
+	}
+	mm_slab_unlock();
+	return true;
+}
+
+uint32_t mm_slab_size(void *ptr)
+{
+	if (((uintptr_t)ptr < gs_slab_lo) || ((uintptr_t)ptr >= gs_slab_hi)) {
+		return 0;
+	}
+
+	mm_slab_lock();
+	mm_slab_t *slab = mm_slab_find(ptr);
+	uint32_t size = (slab != NULL) ? slab->slot_size : 0;
+	mm_slab_unlock();
+	return size;
+}
+
+void mm_slab_forget_all(void)
+{
+	gs_slab_lock = false;
+	gs_slab_count = 0;
+	gs_slab_lo = 0;
+	gs_slab_hi = 0;
+	memset(gs_partial, 0, sizeof(gs_partial));
+}
+
+void mm_slab_adopt_all(void)
+{
+	mm_slab_forget_all();
+	mm_slab_lock();
+
+	mm_chunk_t *chnk = mm_chunk_ctx_get()->boundary.first;
+	for (; chnk != NULL; chnk = mm_chunk_walk_next(chnk)) {
+		mm_slab_t *slab = mm_toptr(chnk);
+		// a slab chunk was allocated with the exact size of its class
+		if (!chnk->allocated || (gs_slab_count == MM_CFG_SLAB_COUNT) ||
+		    (chnk->guard_offset < MM_SLAB_HEADER) ||
+		    (slab->magic != MM_SLAB_MAGIC) ||
+		    (slab->slot_size == 0) ||
+		    (slab->slot_size > MM_CFG_SLAB_MAX_PAYLOAD) ||
+		    ((slab->slot_size % MM_CFG_ALIGNMENT) != 0) ||
+		    (chnk->guard_offset != mm_slab_bytes(slab->slot_size))) {
+			continue;
+		}
+
+		slab->next = NULL;
+		if (slab->free_map != 0) {
+			mm_slab_t **partial = &gs_partial[slab->slot_size / MM_CFG_ALIGNMENT - 1];
+			slab->next = *partial;
+			*partial = slab;
+		}
+		mm_slab_insert(slab);
+	}
+	mm_slab_unlock();
+}
@@ -0,0 +1,229 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "memmgr/chunk.h"
+#include "memmgr/heap.h"
+#include "memmgr/slab.h"
+#include "os/memmgr.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			HEAP_SIZE		(16*1024)
+
+static uint8_t gs_buf[2][HEAP_SIZE] __attribute__((aligned(8)));
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_slab);
+
+TEST_GROUP_RUNNER(mm_slab)
+{
+	RUN_TEST_CASE(mm_slab, alloc_too_big_is_not_a_slot);
+	RUN_TEST_CASE(mm_slab, alloc_carves_a_slab_per_class);
+	RUN_TEST_CASE(mm_slab, free_reuses_lowest_slot);
+	RUN_TEST_CASE(mm_slab, full_slab_carves_another);
+	RUN_TEST_CASE(mm_slab, empty_slab_goes_back_unless_last);
+	RUN_TEST_CASE(mm_slab, free_rejects_other_pointers);
+	RUN_TEST_CASE(mm_slab, misaligned_free_leads_to_death);
+	RUN_TEST_CASE(mm_slab, double_free_leads_to_death);
+	RUN_TEST_CASE(mm_slab, adopt_finds_slabs_again);
+	RUN_TEST_CASE(mm_slab, attach_keeps_slots);
+#if MM_CFG_SLAB && !MM_CFG_PROFILE
+	RUN_TEST_CASE(mm_slab, growing_realloc_moves_into_a_slot);
+#endif
+}
+
+TEST_SETUP(mm_slab)
+{
+	mm_init(gs_buf[0], HEAP_SIZE);
+}
+
+TEST_TEAR_DOWN(mm_slab)
+{
+	mm_slab_forget_all();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_slab, alloc_too_big_is_not_a_slot)
+{
+	uint32_t count = mm_chunk_count();
+
+	TEST_ASSERT_NULL(mm_slab_alloc(0, NULL));
+	TEST_ASSERT_NULL(mm_slab_alloc(MM_CFG_SLAB_MAX_PAYLOAD + 1, NULL));
+	TEST_ASSERT_EQUAL_UINT32(count, mm_chunk_count());
+}
+
+TEST(mm_slab, alloc_carves_a_slab_per_class)
+{
+	uint32_t count = mm_chunk_count();
+	uint8_t *a = mm_slab_alloc(11, NULL);
+	uint8_t *b = mm_slab_alloc(9, NULL);
+	uint8_t *c = mm_slab_alloc(1, NULL);
+
+	uint32_t size = (11 + MM_CFG_ALIGNMENT - 1) & ~(MM_CFG_ALIGNMENT - 1);
+	TEST_ASSERT_EQUAL_UINT32(size, mm_slab_size(a));
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_ALIGNMENT, mm_slab_size(c));
+	TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)a % MM_CFG_ALIGNMENT);
+	if (mm_slab_size(b) == size) {
+		TEST_ASSERT_EQUAL_PTR(a + size, b);
+	}
+	TEST_ASSERT_EQUAL_UINT32(count + 1 + (mm_slab_size(b) != size) + 1, mm_chunk_count());
+	mm_check();
+}
+
+TEST(mm_slab, free_reuses_lowest_slot)
+{
+	uint8_t *a = mm_slab_alloc(8, NULL);
+	uint8_t *b = mm_slab_alloc(8, NULL);
+	uint8_t *c = mm_slab_alloc(8, NULL);
+
+	TEST_ASSERT_TRUE(mm_slab_free(b));
+	TEST_ASSERT_TRUE(mm_slab_free(a));
+	TEST_ASSERT_EQUAL_PTR(a, mm_slab_alloc(8, NULL));
+	TEST_ASSERT_EQUAL_PTR(b, mm_slab_alloc(8, NULL));
+	TEST_ASSERT_TRUE(c != mm_slab_alloc(8, NULL));
+}
+
+TEST(mm_slab, full_slab_carves_another)
+{
+	uint8_t *slots[MM_SLAB_SLOTS + 1];
+	uint32_t count = mm_chunk_count();
+
+	for (uint32_t i = 0; i < MM_SLAB_SLOTS; i++) {
+		slots[i] = mm_slab_alloc(16, NULL);
+		TEST_ASSERT_EQUAL_PTR(slots[0] + (i * 16), slots[i]);
+	}
+	TEST_ASSERT_EQUAL_UINT32(count + 1, mm_chunk_count());
+
+	slots[MM_SLAB_SLOTS] = mm_slab_alloc(16, NULL);
+	TEST_ASSERT_EQUAL_UINT32(16, mm_slab_size(slots[MM_SLAB_SLOTS]));
+	TEST_ASSERT_EQUAL_UINT32(count + 2, mm_chunk_count());
+	mm_check();
+}
+
+TEST(mm_slab, empty_slab_goes_back_unless_last)
+{
+	uint8_t *slots[MM_SLAB_SLOTS + 1];
+
+	for (uint32_t i = 0; i < MM_SLAB_SLOTS + 1; i++) {
+		slots[i] = mm_slab_alloc(16, NULL);
+	}
+	for (uint32_t i = 0; i < MM_SLAB_SLOTS + 1; i++) {
+		TEST_ASSERT_TRUE(mm_slab_free(slots[i]));
+	}
+	/* one empty slab is kept for the class */
+	TEST_ASSERT_EQUAL_UINT32(0, mm_slab_size(slots[0]));
+	TEST_ASSERT_EQUAL_UINT32(16, mm_slab_size(slots[MM_SLAB_SLOTS]));
+	TEST_ASSERT_EQUAL_PTR(slots[MM_SLAB_SLOTS], mm_slab_alloc(16, NULL));
+	mm_check();
+}
+
+TEST(mm_slab, free_rejects_other_pointers)
+{
+	uint32_t local = 0;
+	uint8_t *slot = mm_slab_alloc(8, NULL);
+	void *ptr = mm_alloc_uncached(8, NULL);
+
+	TEST_ASSERT_FALSE(mm_slab_free(NULL));
+	TEST_ASSERT_FALSE(mm_slab_free(&local));
+	TEST_ASSERT_FALSE(mm_slab_free(ptr));
+	TEST_ASSERT_EQUAL_UINT32(0, mm_slab_size(ptr));
+	/* the slab header is not a slot */
+	TEST_ASSERT_FALSE(mm_slab_free(slot - MM_CFG_ALIGNMENT));
+	mm_free_uncached(ptr);
+	TEST_ASSERT_TRUE(mm_slab_free(slot));
+}
+
+TEST(mm_slab, misaligned_free_leads_to_death)
+{
+	uint8_t *slot = mm_slab_alloc(8, NULL);
+
+	EXPECT_ABORT_BEGIN
+	mm_slab_free(slot + 1);
+	VERIFY_FAILS_END("MM: slab misaligned free");
+	mm_heap_unlock(mm_heap_default());
+}
+
+TEST(mm_slab, double_free_leads_to_death)
+{
+	uint8_t *slot = mm_slab_alloc(8, NULL);
+	mm_slab_alloc(8, NULL);
+	mm_slab_free(slot);
+
+	EXPECT_ABORT_BEGIN
+	mm_slab_free(slot);
+	VERIFY_FAILS_END("MM: double free");
+	mm_heap_unlock(mm_heap_default());
+}
+
+TEST(mm_slab, adopt_finds_slabs_again)
+{
+	uint8_t *a = mm_slab_alloc(4, NULL);
+	uint8_t *b = mm_slab_alloc(16, NULL);
+	void *ptr = mm_alloc_uncached(8, NULL);
+
+	mm_slab_forget_all();
+	TEST_ASSERT_EQUAL_UINT32(0, mm_slab_size(a));
+
+	mm_lock();
+	mm_slab_adopt_all();
+	mm_unlock();
+	TEST_ASSERT_EQUAL_UINT32(4, mm_slab_size(a));
+	TEST_ASSERT_EQUAL_UINT32(16, mm_slab_size(b));
+	TEST_ASSERT_EQUAL_UINT32(0, mm_slab_size(ptr));
+	/* occupancy survived */
+	TEST_ASSERT_EQUAL_PTR(a + 4, mm_slab_alloc(4, NULL));
+	TEST_ASSERT_TRUE(mm_slab_free(a));
+}
+
+TEST(mm_slab, attach_keeps_slots)
+{
+	char *a = mm_slab_alloc(6, NULL);
+	strcpy(a, "slot");
+	memcpy(gs_buf[1], gs_buf[0], HEAP_SIZE);
+
+	TEST_ASSERT_TRUE(mm_attach(gs_buf[1], HEAP_SIZE, gs_buf[0]));
+	a = (char *)gs_buf[1] + (a - (char *)gs_buf[0]);
+	TEST_ASSERT_EQUAL_STRING("slot", a);
+	TEST_ASSERT_EQUAL_UINT32(8, mm_slab_size(a));
+	TEST_ASSERT_EQUAL_PTR(a + 8, mm_slab_alloc(6, NULL));
+	TEST_ASSERT_TRUE(mm_slab_free(a));
+	mm_check();
+}
+
+#if MM_CFG_SLAB && !MM_CFG_PROFILE
+TEST(mm_slab, growing_realloc_moves_into_a_slot)
+{
+	uint8_t *ptr = mm_alloc_uncached(4, NULL);
+	void *wall = mm_alloc_uncached(4, NULL);
+	memset(ptr, 0x5A, 4);
+
+	// the chunk cannot grow in place, mm_alloc hands out a slot instead
+	uint8_t *moved = mm_realloc(ptr, MM_CFG_SLAB_MAX_PAYLOAD);
+	TEST_ASSERT_TRUE(moved != ptr);
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_SLAB_MAX_PAYLOAD, mm_slab_size(moved));
+	for (uint32_t i = 0; i < 4; i++) {
+		TEST_ASSERT_EQUAL_UINT32(0x5A, moved[i]);
+	}
+	mm_check();
+
+	mm_free(moved);
+	mm_free_uncached(wall);
+}
+#endif
@@ -0,0 +1,114 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "os/system.h"
+#include "os/task.h"
+#include "memmgr/chunk.h"
+#include "memmgr/trace.h"
+
+#include "memmgr_conf.h"
+
+#if MM_CFG_TRACE
+/* Prototypes ----------------------------------------------------------------*/
+static uintptr_t	mm_trace_heap		(void);
+static uint32_t		mm_trace_offset		(void *ptr);
+
+/* Variables -----------------------------------------------------------------*/
+static mm_trace_record_t	gs_ring[MM_CFG_TRACE_DEPTH];
+static uint32_t			gs_head = 0;
+static bool			gs_enabled = false;
+
+/* Private functions definitions ---------------------------------------------*/
+/* regions lie above the first one, within 2^31 units of it */
+static uintptr_t mm_trace_heap(void)
+{
+	return (uintptr_t)mm_chunk_ctx_get()->boundary.regions[0].first;
+}
+
+/* a block never starts at the heap, 0 is left for NULL */
+static uint32_t mm_trace_offset(void *ptr)
+{
+	if (ptr == NULL) {
+		return 0;
+	}
+	return (uint32_t)(((uintptr_t)ptr - mm_trace_heap()) / MM_CFG_ALIGNMENT);
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_trace_start(void)
+{
+	__atomic_store_n(&gs_enabled, true, __ATOMIC_RELEASE);
+}
+
+void mm_trace_stop(void)
+{
+	__atomic_store_n(&gs_enabled, false, __ATOMIC_RELEASE);
+}
+
+void mm_trace_record(uint8_t op, void *ptr, void *old_ptr, uint32_t size,
+		     void *caller)
+{
+	if (!__atomic_load_n(&gs_enabled, __ATOMIC_ACQUIRE) ||
+	    ((op == MM_TRACE_FREE) && (ptr == NULL))) {
+		return;
+	}
+
+	// each writer owns its slot, no lock on the allocation path
+	uint32_t idx = __atomic_fetch_add(&gs_head, 1, __ATOMIC_RELAXED);
+	mm_trace_record_t *rec = &gs_ring[idx % MM_CFG_TRACE_DEPTH];
+
+	memset(rec, 0, sizeof(mm_trace_record_t));
+	rec->caller = (uintptr_t)caller;
+	rec->task = (uintptr_t)task_self();
+	rec->time_op = (system_time_us() & 0x3FFFFFFF) | ((uint32_t)op << 30);
+	rec->size = size;
+	rec->ptr = mm_trace_offset(ptr);
+	rec->old_ptr = mm_trace_offset(old_ptr);
+}
+
+uint32_t mm_trace_flush(mm_trace_write_f write, void *arg)
+{
+	uint32_t head = __atomic_exchange_n(&gs_head, 0, __ATOMIC_ACQ_REL);
+	uint32_t count = (head < MM_CFG_TRACE_DEPTH) ? head : MM_CFG_TRACE_DEPTH;
+
+	mm_trace_header_t hdr = {
+		.magic = MM_TRACE_MAGIC,
+		.version = MM_TRACE_VERSION,
+		.record_size = sizeof(mm_trace_record_t),
+		.count = count,
+		.dropped = head - count,
+		.heap = mm_trace_heap()
+	};
+	if (!write(arg, &hdr, sizeof(hdr))) {
+		return 0;
+	}
+
+	uint32_t i = 0;
+	for (; i < count; i++) {
+		uint32_t idx = (head - count + i) % MM_CFG_TRACE_DEPTH;
+		if (!write(arg, &gs_ring[idx], sizeof(mm_trace_record_t))) {
+			break;
+		}
+	}
+	return i;
+}
+#endif
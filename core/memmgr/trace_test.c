@@ -0,0 +1,223 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/chunk.h"
+#include "memmgr/trace.h"
+#include "os/memmgr.h"
+#include "os/task.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+#define			OUT_SIZE		(sizeof(mm_trace_header_t) + \
+					 (MM_CFG_TRACE_DEPTH * sizeof(mm_trace_record_t)))
+
+static uint8_t gs_out[OUT_SIZE];
+static uint32_t gs_out_len = 0;
+static uint32_t gs_out_limit = 0;
+
+static bool		write_out		(void *arg,
+						 const void *data,
+						 uint32_t len);
+static mm_trace_header_t *header		(void);
+static mm_trace_record_t *record		(uint32_t i);
+static void *		address			(uint32_t offset);
+
+static bool write_out(void *arg, const void *data, uint32_t len)
+{
+	if (gs_out_len + len > gs_out_limit) {
+		return false;
+	}
+	memcpy(gs_out + gs_out_len, data, len);
+	gs_out_len += len;
+	return true;
+}
+
+static mm_trace_header_t *header(void)
+{
+	return (mm_trace_header_t *)gs_out;
+}
+
+static mm_trace_record_t *record(uint32_t i)
+{
+	return (mm_trace_record_t *)(gs_out + sizeof(mm_trace_header_t)) + i;
+}
+
+static void *address(uint32_t offset)
+{
+	if (offset == 0) {
+		return NULL;
+	}
+	return (void *)(uintptr_t)(header()->heap + (offset * MM_CFG_ALIGNMENT));
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_trace);
+
+TEST_GROUP_RUNNER(mm_trace)
+{
+	RUN_TEST_CASE(mm_trace, records_alloc_realloc_free);
+	RUN_TEST_CASE(mm_trace, moving_realloc_is_one_record);
+	RUN_TEST_CASE(mm_trace, nothing_recorded_when_stopped);
+	RUN_TEST_CASE(mm_trace, free_of_null_is_not_recorded);
+	RUN_TEST_CASE(mm_trace, batch_records_each_block);
+	RUN_TEST_CASE(mm_trace, ring_keeps_the_newest);
+	RUN_TEST_CASE(mm_trace, flush_empties_the_ring);
+	RUN_TEST_CASE(mm_trace, flush_stops_on_write_failure);
+}
+
+TEST_SETUP(mm_trace)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+	memset(gs_out, 0, sizeof(gs_out));
+	gs_out_len = 0;
+	gs_out_limit = OUT_SIZE;
+	mm_trace_start();
+}
+
+TEST_TEAR_DOWN(mm_trace)
+{
+	mm_trace_stop();
+	gs_out_len = 0;
+	gs_out_limit = OUT_SIZE;
+	mm_trace_flush(write_out, NULL);
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_trace, records_alloc_realloc_free)
+{
+	void *a = mm_alloc(10);
+	void *b = mm_realloc(a, 20);
+	mm_free(b);
+	mm_trace_stop();
+
+	TEST_ASSERT_EQUAL_UINT32(3, mm_trace_flush(write_out, NULL));
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_MAGIC, header()->magic);
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_VERSION, header()->version);
+	TEST_ASSERT_EQUAL_UINT32(sizeof(mm_trace_record_t), header()->record_size);
+	TEST_ASSERT_EQUAL_UINT32(3, header()->count);
+	TEST_ASSERT_EQUAL_UINT32(0, header()->dropped);
+
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_ALLOC, MM_TRACE_OP(record(0)));
+	TEST_ASSERT_EQUAL_UINT32(10, record(0)->size);
+	TEST_ASSERT_EQUAL_PTR(a, address(record(0)->ptr));
+	TEST_ASSERT_EQUAL_PTR(task_self(), (void *)(uintptr_t)record(0)->task);
+
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_REALLOC, MM_TRACE_OP(record(1)));
+	TEST_ASSERT_EQUAL_UINT32(20, record(1)->size);
+	TEST_ASSERT_EQUAL_PTR(a, address(record(1)->old_ptr));
+	TEST_ASSERT_EQUAL_PTR(b, address(record(1)->ptr));
+
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_FREE, MM_TRACE_OP(record(2)));
+	TEST_ASSERT_EQUAL_PTR(b, address(record(2)->ptr));
+	TEST_ASSERT_TRUE(((MM_TRACE_TIME_US(record(2)) - MM_TRACE_TIME_US(record(0))) &
+			  0x3FFFFFFF) < 1000000);
+}
+
+TEST(mm_trace, moving_realloc_is_one_record)
+{
+	mm_trace_stop();
+	void *a = mm_alloc(10);
+	void *c = mm_alloc(10);
+	mm_trace_start();
+
+	void *b = mm_realloc(a, 100);
+	TEST_ASSERT_NOT_NULL(b);
+	TEST_ASSERT_TRUE(a != b);
+
+	TEST_ASSERT_EQUAL_UINT32(1, mm_trace_flush(write_out, NULL));
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_REALLOC, MM_TRACE_OP(record(0)));
+	TEST_ASSERT_EQUAL_PTR(a, address(record(0)->old_ptr));
+	TEST_ASSERT_EQUAL_PTR(b, address(record(0)->ptr));
+	mm_free(b);
+	mm_free(c);
+}
+
+TEST(mm_trace, nothing_recorded_when_stopped)
+{
+	mm_trace_stop();
+	mm_free(mm_alloc(10));
+
+	TEST_ASSERT_EQUAL_UINT32(0, mm_trace_flush(write_out, NULL));
+	TEST_ASSERT_EQUAL_UINT32(0, header()->count);
+}
+
+TEST(mm_trace, free_of_null_is_not_recorded)
+{
+	mm_free(NULL);
+	TEST_ASSERT_EQUAL_UINT32(0, mm_trace_flush(write_out, NULL));
+}
+
+TEST(mm_trace, batch_records_each_block)
+{
+	uint32_t sizes[] = {10, 0, 20};
+	void *out[3];
+
+	mm_alloc_batch(3, sizes, out);
+	void *a = out[0];
+	void *c = out[2];
+	mm_free_batch(out, 3);
+
+	TEST_ASSERT_EQUAL_UINT32(4, mm_trace_flush(write_out, NULL));
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_ALLOC, MM_TRACE_OP(record(0)));
+	TEST_ASSERT_EQUAL_UINT32(10, record(0)->size);
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_ALLOC, MM_TRACE_OP(record(1)));
+	TEST_ASSERT_EQUAL_UINT32(20, record(1)->size);
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_FREE, MM_TRACE_OP(record(2)));
+	TEST_ASSERT_EQUAL_PTR(a, address(record(2)->ptr));
+	TEST_ASSERT_EQUAL_UINT32(MM_TRACE_FREE, MM_TRACE_OP(record(3)));
+	TEST_ASSERT_EQUAL_PTR(c, address(record(3)->ptr));
+}
+
+TEST(mm_trace, ring_keeps_the_newest)
+{
+	for (uint32_t i = 0; i < MM_CFG_TRACE_DEPTH + 5; i++) {
+		mm_trace_record(MM_TRACE_ALLOC, (void *)0x10, NULL, i, NULL);
+	}
+
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_TRACE_DEPTH, mm_trace_flush(write_out, NULL));
+	TEST_ASSERT_EQUAL_UINT32(5, header()->dropped);
+	TEST_ASSERT_EQUAL_UINT32(5, record(0)->size);
+	TEST_ASSERT_EQUAL_UINT32(MM_CFG_TRACE_DEPTH + 4,
+				 record(MM_CFG_TRACE_DEPTH - 1)->size);
+}
+
+TEST(mm_trace, flush_empties_the_ring)
+{
+	mm_trace_record(MM_TRACE_ALLOC, (void *)0x10, NULL, 1, NULL);
+	TEST_ASSERT_EQUAL_UINT32(1, mm_trace_flush(write_out, NULL));
+
+	gs_out_len = 0;
+	TEST_ASSERT_EQUAL_UINT32(0, mm_trace_flush(write_out, NULL));
+	TEST_ASSERT_EQUAL_UINT32(0, header()->count);
+}
+
+TEST(mm_trace, flush_stops_on_write_failure)
+{
+	for (uint32_t i = 0; i < 4; i++) {
+		mm_trace_record(MM_TRACE_ALLOC, (void *)0x10, NULL, i, NULL);
+	}
+
+	gs_out_limit = sizeof(mm_trace_header_t) + 2 * sizeof(mm_trace_record_t);
+	TEST_ASSERT_EQUAL_UINT32(2, mm_trace_flush(write_out, NULL));
+	TEST_ASSERT_EQUAL_UINT32(4, header()->count);
+}
@@ -0,0 +1,281 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "os/memmgr.h"
+#include "os/task.h"
+#include "memmgr/zone.h"
+
+#include "memmgr_conf.h"
+
+#if MM_CFG_ZONE
+/*
+ * Zoned blocks are found back by address in an open addressing table, linear
+ * probing with backward shift deletion. Every charged block holds a slot from
+ * the moment it is charged, so tagging never runs out of room and one slot
+ * is always left empty to end the probes. The zones and the table share a
+ * spinning lock, held for a few instructions at a time.
+ */
+
+/* Macro definitions ---------------------------------------------------------*/
+#if (MM_CFG_ZONE_BLOCKS & (MM_CFG_ZONE_BLOCKS - 1)) != 0
+#error "MM_CFG_ZONE_BLOCKS must be a power of two"
+#endif
+
+#define MM_ZONE_MASK		(MM_CFG_ZONE_BLOCKS - 1)
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct
+{
+	/* NULL when the slot is empty */
+	void *		ptr;
+	mm_zone_t *	zone;
+	uint32_t	size;
+} mm_zone_block_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint32_t		mm_zone_home		(void *ptr);
+static mm_zone_block_t *mm_zone_find		(void *ptr,
+						 bool insert);
+static void		mm_zone_remove		(uint32_t i);
+static void		mm_zone_uncharge	(mm_zone_t *zone,
+						 uint32_t bytes,
+						 uint32_t count);
+static mm_zone_t **	mm_zone_slot		(void);
+static void		mm_zone_lock		(void);
+static void		mm_zone_unlock		(void);
+
+/* Variables -----------------------------------------------------------------*/
+static mm_zone_block_t	gs_blocks[MM_CFG_ZONE_BLOCKS];
+/* blocks charged to a zone, tagged or about to be */
+static uint32_t		gs_reserved = 0;
+static mm_zone_t	*gs_outside = NULL;
+static bool		gs_zone_lock = false;
+
+/* Private functions definitions ---------------------------------------------*/
+static uint32_t mm_zone_home(void *ptr)
+{
+	return (((uintptr_t)ptr >> 2) * 2654435761u) & MM_ZONE_MASK;
+}
+
+static mm_zone_block_t *mm_zone_find(void *ptr, bool insert)
+{
+	uint32_t i = mm_zone_home(ptr);
+	for (uint32_t n = 0; n < MM_CFG_ZONE_BLOCKS; n++, i = (i + 1) & MM_ZONE_MASK) {
+		mm_zone_block_t *slot = &gs_blocks[i];
+		if (slot->ptr == ptr) {
+			return slot;
+		}
+		if (slot->ptr == NULL) {
+			return insert ? slot : NULL;
+		}
+	}
+	return NULL;
+}
+
+static void mm_zone_remove(uint32_t i)
+{
+	uint32_t j = i;
+	for (;;) {
+		j = (j + 1) & MM_ZONE_MASK;
+		if (gs_blocks[j].ptr == NULL) {
+			break;
+		}
+		// the hole is on the probe sequence of j, j moves into it
+		uint32_t home = mm_zone_home(gs_blocks[j].ptr);
+		if (((j - home) & MM_ZONE_MASK) >= ((j - i) & MM_ZONE_MASK)) {
+			gs_blocks[i] = gs_blocks[j];
+			i = j;
+		}
+	}
+	gs_blocks[i].ptr = NULL;
+}
+
+/* called with the lock held */
+static void mm_zone_uncharge(mm_zone_t *zone, uint32_t bytes, uint32_t count)
+{
+	zone->bytes -= (bytes < zone->bytes) ? bytes : zone->bytes;
+	zone->count -= (count < zone->count) ? count : zone->count;
+	gs_reserved -= (count < gs_reserved) ? count : gs_reserved;
+}
+
+static mm_zone_t **mm_zone_slot(void)
+{
+	mm_zone_t **slot = task_mm_zone_get();
+	return (slot != NULL) ? slot : &gs_outside;
+}
+
+static void mm_zone_lock(void)
+{
+	while (__atomic_test_and_set(&gs_zone_lock, __ATOMIC_ACQUIRE)) {
+		while (__atomic_load_n(&gs_zone_lock, __ATOMIC_RELAXED)) {
+		}
+	}
+}
+
+static void mm_zone_unlock(void)
+{
+	__atomic_clear(&gs_zone_lock, __ATOMIC_RELEASE);
+}
+
+/* Functions definitions -----------------------------------------------------*/
+void mm_zone_init(mm_zone_t *this, const char *name, uint32_t byte_quota,
+		  uint32_t count_quota)
+{
+	memset(this, 0, sizeof(mm_zone_t));
+	this->name = name;
+	this->byte_quota = byte_quota;
+	this->count_quota = count_quota;
+}
+
+void mm_zone_quota_set(mm_zone_t *this, uint32_t byte_quota,
+		       uint32_t count_quota)
+{
+	mm_zone_lock();
+	this->byte_quota = byte_quota;
+	this->count_quota = count_quota;
+	mm_zone_unlock();
+}
+
+void mm_zone_stats_get(mm_zone_t *this, mm_zone_t *stats)
+{
+	mm_zone_lock();
+	*stats = *this;
+	mm_zone_unlock();
+}
+
+mm_zone_t *mm_zone_enter(mm_zone_t *zone)
+{
+	mm_zone_t **slot = mm_zone_slot();
+	mm_zone_t *prev = *slot;
+	*slot = zone;
+	return prev;
+}
+
+mm_zone_t *mm_zone_current(void)
+{
+	return *mm_zone_slot();
+}
+
+void *mm_zone_alloc(mm_zone_t *zone, uint32_t size)
+{
+	mm_zone_t *prev = mm_zone_enter(zone);
+	void *ptr = mm_alloc(size);
+	mm_zone_enter(prev);
+	mm_allocator_update(ptr);
+	return ptr;
+}
+
+mm_zone_t *mm_zone_of(void *ptr)
+{
+	if (ptr == NULL) {
+		return NULL;
+	}
+	mm_zone_lock();
+	mm_zone_block_t *block = mm_zone_find(ptr, false);
+	mm_zone_t *zone = (block != NULL) ? block->zone : NULL;
+	mm_zone_unlock();
+	return zone;
+}
+
+void mm_zone_reset(void)
+{
+	gs_zone_lock = false;
+	memset(gs_blocks, 0, sizeof(gs_blocks));
+	gs_reserved = 0;
+	gs_outside = NULL;
+}
+
+bool mm_zone_charge(mm_zone_t *zone, uint32_t bytes, uint32_t count)
+{
+	mm_zone_lock();
+	bool fits = ((zone->byte_quota == 0) ||
+		     ((uint64_t)zone->bytes + bytes <= zone->byte_quota)) &&
+		    ((zone->count_quota == 0) ||
+		     ((uint64_t)zone->count + count <= zone->count_quota)) &&
+		    (gs_reserved + count < MM_CFG_ZONE_BLOCKS);
+	if (fits) {
+		zone->bytes += bytes;
+		zone->count += count;
+		gs_reserved += count;
+		if (zone->bytes > zone->peak_bytes) {
+			zone->peak_bytes = zone->bytes;
+		}
+		if (zone->count > zone->peak_count) {
+			zone->peak_count = zone->count;
+		}
+	} else {
+		zone->failures++;
+	}
+	mm_zone_unlock();
+	return fits;
+}
+
+void mm_zone_cancel(mm_zone_t *zone, uint32_t bytes, uint32_t count)
+{
+	mm_zone_lock();
+	mm_zone_uncharge(zone, bytes, count);
+	mm_zone_unlock();
+}
+
+void mm_zone_tag(mm_zone_t *zone, void *ptr, uint32_t size)
+{
+	mm_zone_lock();
+	mm_zone_block_t *block = mm_zone_find(ptr, true);
+	if (block != NULL) {
+		// freed behind the back of the mm_alloc family, then handed out again
+		if (block->ptr != NULL) {
+			mm_zone_uncharge(block->zone, block->size, 1);
+		}
+		block->ptr = ptr;
+		block->zone = zone;
+		block->size = size;
+	}
+	mm_zone_unlock();
+}
+
+mm_zone_t *mm_zone_untag(void *ptr, uint32_t *size)
+{
+	if (ptr == NULL) {
+		return NULL;
+	}
+	mm_zone_lock();
+	mm_zone_t *zone = NULL;
+	mm_zone_block_t *block = mm_zone_find(ptr, false);
+	if (block != NULL) {
+		zone = block->zone;
+		*size = block->size;
+		mm_zone_remove(block - gs_blocks);
+	}
+	mm_zone_unlock();
+	return zone;
+}
+
+void mm_zone_release(void *ptr)
+{
+	uint32_t size = 0;
+	mm_zone_t *zone = mm_zone_untag(ptr, &size);
+	if (zone != NULL) {
+		mm_zone_cancel(zone, size, 1);
+	}
+}
+#endif
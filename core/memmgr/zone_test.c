@@ -0,0 +1,252 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+
+#include "unity_fixture.h"
+#include "tests/chunk_test_tools.h"
+#include "memmgr/chunk.h"
+#include "memmgr/zone.h"
+#include "os/memmgr.h"
+#include "os/task.h"
+#include "memmgr_conf.h"
+
+/* helpers -------------------------------------------------------------------*/
+static mm_zone_t gs_zone;
+static mm_zone_t *gs_seen = NULL;
+static void *gs_ptr = NULL;
+
+static void		alloc_in_zone		(void *arg);
+
+static void alloc_in_zone(void *arg)
+{
+	mm_zone_enter(arg);
+	gs_ptr = mm_alloc(12);
+	gs_seen = mm_zone_of(gs_ptr);
+}
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(mm_zone);
+
+TEST_GROUP_RUNNER(mm_zone)
+{
+	RUN_TEST_CASE(mm_zone, byte_quota_fails_fast);
+	RUN_TEST_CASE(mm_zone, count_quota_fails_fast);
+	RUN_TEST_CASE(mm_zone, free_gives_budget_back);
+	RUN_TEST_CASE(mm_zone, zone_per_call);
+	RUN_TEST_CASE(mm_zone, no_zone_is_not_accounted);
+	RUN_TEST_CASE(mm_zone, zalloc_and_calloc_count_once);
+	RUN_TEST_CASE(mm_zone, realloc_stays_in_its_zone);
+	RUN_TEST_CASE(mm_zone, realloc_of_null_uses_the_current_zone);
+	RUN_TEST_CASE(mm_zone, batch_gives_back_what_is_over);
+	RUN_TEST_CASE(mm_zone, full_table_fails_fast);
+	RUN_TEST_CASE(mm_zone, task_keeps_its_own_zone);
+}
+
+TEST_SETUP(mm_zone)
+{
+	chunk_test_state_t a_state[] = {{256, false}};
+	chunk_test_prepare(a_state, 1);
+	mm_zone_reset();
+	mm_zone_init(&gs_zone, "test", 100, 0);
+}
+
+TEST_TEAR_DOWN(mm_zone)
+{
+	mm_zone_reset();
+	chunk_test_clear();
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(mm_zone, byte_quota_fails_fast)
+{
+	mm_zone_t stats;
+	TEST_ASSERT_NULL(mm_zone_enter(&gs_zone));
+	void *a = mm_alloc(60);
+	void *b = mm_alloc(50);
+	void *c = mm_alloc(40);
+	mm_zone_enter(NULL);
+
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NULL(b);
+	TEST_ASSERT_NOT_NULL(c);
+	mm_zone_stats_get(&gs_zone, &stats);
+	TEST_ASSERT_EQUAL_STRING("test", stats.name);
+	TEST_ASSERT_EQUAL_UINT32(100, stats.bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, stats.count);
+	TEST_ASSERT_EQUAL_UINT32(1, stats.failures);
+
+	mm_free(a);
+	mm_free(c);
+}
+
+TEST(mm_zone, count_quota_fails_fast)
+{
+	mm_zone_quota_set(&gs_zone, 0, 2);
+	mm_zone_enter(&gs_zone);
+	void *a = mm_alloc(200);
+	void *b = mm_alloc(200);
+	void *c = mm_alloc(1);
+	mm_zone_enter(NULL);
+
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NOT_NULL(b);
+	TEST_ASSERT_NULL(c);
+	TEST_ASSERT_EQUAL_UINT32(400, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_zone.failures);
+
+	mm_free(a);
+	mm_free(b);
+}
+
+TEST(mm_zone, free_gives_budget_back)
+{
+	mm_zone_enter(&gs_zone);
+	void *a = mm_alloc(70);
+	mm_free(a);
+	a = mm_alloc(80);
+	void *b = mm_alloc(20);
+	mm_zone_enter(NULL);
+
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NOT_NULL(b);
+	mm_free(a);
+	mm_free(b);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.count);
+	TEST_ASSERT_EQUAL_UINT32(100, gs_zone.peak_bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, gs_zone.peak_count);
+}
+
+TEST(mm_zone, zone_per_call)
+{
+	void *a = mm_zone_alloc(&gs_zone, 10);
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_EQUAL_PTR(&gs_zone, mm_zone_of(a));
+	TEST_ASSERT_NULL(mm_zone_current());
+	TEST_ASSERT_NULL(mm_zone_alloc(&gs_zone, 91));
+
+	mm_free(a);
+	TEST_ASSERT_NULL(mm_zone_of(a));
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.bytes);
+}
+
+TEST(mm_zone, no_zone_is_not_accounted)
+{
+	void *a = mm_alloc(500);
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NULL(mm_zone_of(a));
+	mm_free(a);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.peak_bytes);
+}
+
+TEST(mm_zone, zalloc_and_calloc_count_once)
+{
+	mm_zone_enter(&gs_zone);
+	void *a = mm_zalloc(10);
+	void *b = mm_calloc(2, 5);
+	mm_zone_enter(NULL);
+
+	TEST_ASSERT_EQUAL_UINT32(20, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, gs_zone.count);
+	mm_free(a);
+	mm_free(b);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.count);
+}
+
+TEST(mm_zone, realloc_stays_in_its_zone)
+{
+	void *a = mm_zone_alloc(&gs_zone, 40);
+	void *b = mm_realloc(a, 90);
+	TEST_ASSERT_NOT_NULL(b);
+	TEST_ASSERT_EQUAL_UINT32(90, gs_zone.bytes);
+
+	TEST_ASSERT_NULL(mm_realloc(b, 120));
+	TEST_ASSERT_EQUAL_PTR(&gs_zone, mm_zone_of(b));
+	TEST_ASSERT_EQUAL_UINT32(90, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_zone.failures);
+
+	b = mm_realloc(b, 10);
+	TEST_ASSERT_EQUAL_UINT32(10, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_zone.count);
+
+	TEST_ASSERT_NULL(mm_realloc(b, 0));
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.count);
+}
+
+TEST(mm_zone, realloc_of_null_uses_the_current_zone)
+{
+	mm_zone_enter(&gs_zone);
+	void *a = mm_realloc(NULL, 30);
+	TEST_ASSERT_NULL(mm_realloc(NULL, 80));
+	mm_zone_enter(NULL);
+
+	TEST_ASSERT_EQUAL_PTR(&gs_zone, mm_zone_of(a));
+	TEST_ASSERT_EQUAL_UINT32(30, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, gs_zone.count);
+	mm_free(a);
+}
+
+TEST(mm_zone, batch_gives_back_what_is_over)
+{
+	uint32_t sizes[3] = {40, 40, 40};
+	void *ptrs[3];
+	mm_zone_enter(&gs_zone);
+	TEST_ASSERT_EQUAL_UINT32(2, mm_alloc_batch(3, sizes, ptrs));
+	mm_zone_enter(NULL);
+
+	TEST_ASSERT_NOT_NULL(ptrs[0]);
+	TEST_ASSERT_NOT_NULL(ptrs[1]);
+	TEST_ASSERT_NULL(ptrs[2]);
+	TEST_ASSERT_EQUAL_UINT32(80, gs_zone.bytes);
+
+	mm_free_batch(ptrs, 2);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.bytes);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.count);
+}
+
+TEST(mm_zone, full_table_fails_fast)
+{
+	mm_zone_t other;
+	mm_zone_init(&other, "other", 0, 0);
+	TEST_ASSERT_TRUE(mm_zone_charge(&other, 0, MM_CFG_ZONE_BLOCKS - 2));
+
+	void *a = mm_zone_alloc(&gs_zone, 1);
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NULL(mm_zone_alloc(&gs_zone, 1));
+	TEST_ASSERT_EQUAL_UINT32(1, gs_zone.failures);
+
+	mm_zone_cancel(&other, 0, MM_CFG_ZONE_BLOCKS - 2);
+	mm_free(a);
+}
+
+TEST(mm_zone, task_keeps_its_own_zone)
+{
+	task_t *t = task_create(alloc_in_zone, &gs_zone, 0, 0, "test_zone");
+	TEST_ASSERT_NOT_NULL(t);
+	TEST_ASSERT_TRUE(task_start(t));
+	task_stop(t);
+
+	TEST_ASSERT_EQUAL_PTR(&gs_zone, gs_seen);
+	TEST_ASSERT_NULL(mm_zone_current());
+	TEST_ASSERT_EQUAL_UINT32(12, gs_zone.bytes);
+	mm_free(gs_ptr);
+	TEST_ASSERT_EQUAL_UINT32(0, gs_zone.bytes);
+	object_delete(&t->base);
+}
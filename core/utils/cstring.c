@@ -38,3 +38,19 @@ char *cstring_dup(const char *str)
 	}
 	return res;
 }
+
+char *cstring_dup_arena(const char *str, mm_arena_t *arena)
+{
+	char *res = NULL;
+	if (str == NULL) {
+		return NULL;
+	}
+	uint32_t len = strlen(str);
+	res = mm_arena_alloc(arena, len + 1);
+
+	if (res != NULL) {
+		memcpy(res, str, len);
+		res[len] = '\0';
+	}
+	return res;
+}
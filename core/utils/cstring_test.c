@@ -18,6 +18,7 @@
 #include "unity_fixture.h"
 #include "tests/memmgr_unity.h"
 #include "os/memmgr.h"
+#include "memmgr/arena.h"
 #include "utils/cstring.h"
 
 
@@ -28,6 +29,8 @@ TEST_GROUP_RUNNER(cstring)
 {
 	RUN_TEST_CASE(cstring, dup_null_is_ok);
 	RUN_TEST_CASE(cstring, dup_can_be_freed);
+	RUN_TEST_CASE(cstring, dup_arena_null_is_ok);
+	RUN_TEST_CASE(cstring, dup_arena);
 }
 
 TEST_SETUP(cstring)
@@ -52,3 +55,19 @@ TEST(cstring, dup_can_be_freed)
 	TEST_ASSERT_EQUAL_STRING("Bonjour", s);
 	mm_free(s);
 }
+
+TEST(cstring, dup_arena_null_is_ok)
+{
+	mm_arena_declare(arena, 32);
+	TEST_ASSERT_NULL(cstring_dup_arena(NULL, &arena));
+	TEST_ASSERT_NULL(arena.current);
+}
+
+TEST(cstring, dup_arena)
+{
+	mm_arena_declare(arena, 32);
+	char *s = cstring_dup_arena("Bonjour", &arena);
+	TEST_ASSERT_EQUAL_STRING("Bonjour", s);
+	TEST_ASSERT_NOT_NULL(arena.current);
+	mm_arena_reset(&arena);
+}
@@ -0,0 +1,172 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "os/heap_file.h"
+#include "os/memmgr.h"
+#include "memmgr/chunk.h"
+#include "memmgr_conf.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+#define HEAP_FILE_MAGIC		"MMHF"
+#define HEAP_FILE_VERSION	(1)
+/* the heap follows the header, aligned for any MM_CFG_ALIGNMENT up to it */
+#define HEAP_FILE_HEADER_SIZE	(64)
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct
+{
+	char		magic[4];
+	uint32_t	version;
+	/* fingerprint of the chunk layout the heap was formatted with */
+	uint32_t	layout;
+	uint32_t	size;
+	/* address of the heap when it was last mapped */
+	uint64_t	origin;
+	/* offset of the root block in the heap plus one, 0 if none */
+	uint64_t	root;
+} heap_file_header_t;
+
+typedef struct
+{
+	uint8_t			*map;
+	size_t			len;
+	bool			reopened;
+} heap_file_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint32_t		heap_file_layout	(void);
+static uint8_t *	heap_file_heap		(void);
+
+/* Variables -----------------------------------------------------------------*/
+static heap_file_t gs_file = { NULL, 0, false };
+
+/* Private functions definitions ---------------------------------------------*/
+static uint32_t heap_file_layout(void)
+{
+	const uint32_t layout[] = {
+		MM_CFG_ALIGNMENT, sizeof(mm_chunk_t), MM_CFG_MIN_PAYLOAD,
+		MM_CFG_INTEGRITY, MM_CFG_GUARD_SIZE, MM_CFG_CRC32C,
+		MM_CFG_WIDE_HEADER, MM_CFG_COMPACT_HEADER
+	};
+	return mm_crc32c(layout, sizeof(layout));
+}
+
+static uint8_t *heap_file_heap(void)
+{
+	return gs_file.map + HEAP_FILE_HEADER_SIZE;
+}
+
+/* Functions definitions -----------------------------------------------------*/
+bool heap_file_open(const char *path, uint32_t size)
+{
+	if (gs_file.map != NULL) {
+		return false;
+	}
+	int fd = open(path, O_RDWR | O_CREAT, 0600);
+	if (fd < 0) {
+		return false;
+	}
+
+	heap_file_header_t prev;
+	size_t len = HEAP_FILE_HEADER_SIZE + size;
+	bool warm = (pread(fd, &prev, sizeof(prev), 0) == sizeof(prev)) &&
+		    (memcmp(prev.magic, HEAP_FILE_MAGIC, sizeof(prev.magic)) == 0) &&
+		    (prev.version == HEAP_FILE_VERSION) &&
+		    (prev.layout == heap_file_layout()) &&
+		    (prev.size == size);
+	// mapped at the same place, pointers the blocks hold stay valid
+	void *hint = warm ? (void *)(uintptr_t)(prev.origin - HEAP_FILE_HEADER_SIZE) : NULL;
+
+	uint8_t *map = MAP_FAILED;
+	if (ftruncate(fd, len) == 0) {
+		map = mmap(hint, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+
+	gs_file.map = map;
+	gs_file.len = len;
+	heap_file_header_t *header = (heap_file_header_t *)map;
+	if (warm) {
+		warm = mm_attach(heap_file_heap(), size,
+				 (const uint8_t *)(uintptr_t)prev.origin);
+	}
+	if (!warm) {
+		// an interrupted format must not look like a heap
+		memset(header, 0, sizeof(heap_file_header_t));
+		mm_init(heap_file_heap(), size);
+		header->version = HEAP_FILE_VERSION;
+		header->layout = heap_file_layout();
+		header->size = size;
+		memcpy(header->magic, HEAP_FILE_MAGIC, sizeof(header->magic));
+	}
+	header->origin = (uintptr_t)heap_file_heap();
+	gs_file.reopened = warm;
+	return true;
+}
+
+bool heap_file_reopened(void)
+{
+	return gs_file.reopened;
+}
+
+void heap_file_root_set(void *ptr)
+{
+	heap_file_header_t *header = (heap_file_header_t *)gs_file.map;
+	if (header == NULL) {
+		return;
+	}
+	header->root = (ptr != NULL) ? ((uint8_t *)ptr - heap_file_heap()) + 1 : 0;
+}
+
+void *heap_file_root_get(void)
+{
+	heap_file_header_t *header = (heap_file_header_t *)gs_file.map;
+	if ((header == NULL) || (header->root == 0) || (header->root > header->size)) {
+		return NULL;
+	}
+	return heap_file_heap() + header->root - 1;
+}
+
+bool heap_file_sync(void)
+{
+	if (gs_file.map == NULL) {
+		return false;
+	}
+	return msync(gs_file.map, gs_file.len, MS_SYNC) == 0;
+}
+
+void heap_file_close(void)
+{
+	if (gs_file.map == NULL) {
+		return;
+	}
+	mm_detach();
+	heap_file_sync();
+	munmap(gs_file.map, gs_file.len);
+	gs_file.map = NULL;
+	gs_file.len = 0;
+	gs_file.reopened = false;
+}
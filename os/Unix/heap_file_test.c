@@ -0,0 +1,132 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity_fixture.h"
+#include "os/heap_file.h"
+#include "os/memmgr.h"
+
+/*----------------------------------------------------------------------------*/
+#define			HEAP_SIZE		(64*1024)
+
+static char gs_path[] = "/tmp/heap_file_test_XXXXXX";
+static uint8_t gs_spare[16*1024] __attribute__((aligned(8)));
+
+/* Test group definitions ----------------------------------------------------*/
+TEST_GROUP(heap_file);
+
+TEST_GROUP_RUNNER(heap_file)
+{
+	RUN_TEST_CASE(heap_file, open_formats_a_new_file);
+	RUN_TEST_CASE(heap_file, open_twice_fails);
+	RUN_TEST_CASE(heap_file, reopen_keeps_the_root_block);
+	RUN_TEST_CASE(heap_file, reopen_with_another_size_formats);
+	RUN_TEST_CASE(heap_file, reopen_corrupted_formats);
+}
+
+TEST_SETUP(heap_file)
+{
+	strcpy(gs_path + strlen(gs_path) - 6, "XXXXXX");
+	int fd = mkstemp(gs_path);
+	TEST_ASSERT_TRUE(fd >= 0);
+	close(fd);
+}
+
+TEST_TEAR_DOWN(heap_file)
+{
+	heap_file_close();
+	unlink(gs_path);
+	/* the default heap must not stay in the unmapped file */
+	mm_init(gs_spare, sizeof(gs_spare));
+}
+
+/* Tests ---------------------------------------------------------------------*/
+TEST(heap_file, open_formats_a_new_file)
+{
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE));
+	TEST_ASSERT_FALSE(heap_file_reopened());
+	TEST_ASSERT_NULL(heap_file_root_get());
+
+	void *ptr = mm_alloc(HEAP_SIZE / 2);
+	TEST_ASSERT_NOT_NULL(ptr);
+	mm_free(ptr);
+	mm_check();
+}
+
+TEST(heap_file, open_twice_fails)
+{
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE));
+	TEST_ASSERT_FALSE(heap_file_open(gs_path, HEAP_SIZE));
+}
+
+TEST(heap_file, reopen_keeps_the_root_block)
+{
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE));
+	char *root = mm_alloc(32);
+	strcpy(root, "warm cache");
+	heap_file_root_set(root);
+	heap_file_close();
+
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE));
+	TEST_ASSERT_TRUE(heap_file_reopened());
+	root = heap_file_root_get();
+	TEST_ASSERT_NOT_NULL(root);
+	TEST_ASSERT_EQUAL_STRING("warm cache", root);
+	mm_check();
+
+	mm_free(root);
+	heap_file_root_set(NULL);
+	TEST_ASSERT_NULL(heap_file_root_get());
+	mm_check();
+}
+
+TEST(heap_file, reopen_with_another_size_formats)
+{
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE));
+	heap_file_root_set(mm_alloc(32));
+	heap_file_close();
+
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE * 2));
+	TEST_ASSERT_FALSE(heap_file_reopened());
+	TEST_ASSERT_NULL(heap_file_root_get());
+	TEST_ASSERT_NOT_NULL(mm_alloc(HEAP_SIZE + 1));
+}
+
+TEST(heap_file, reopen_corrupted_formats)
+{
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE));
+	char *root = mm_alloc(32);
+	heap_file_root_set(root);
+	heap_file_close();
+
+	/* scribble over the first chunk header, right after the file header */
+	int fd = open(gs_path, O_RDWR);
+	TEST_ASSERT_TRUE(fd >= 0);
+	uint8_t junk[8];
+	memset(junk, 0xA5, sizeof(junk));
+	TEST_ASSERT_EQUAL_UINT32(sizeof(junk), pwrite(fd, junk, sizeof(junk), 64));
+	close(fd);
+
+	TEST_ASSERT_TRUE(heap_file_open(gs_path, HEAP_SIZE));
+	TEST_ASSERT_FALSE(heap_file_reopened());
+	TEST_ASSERT_NULL(heap_file_root_get());
+	mm_check();
+}
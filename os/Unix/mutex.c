@@ -22,8 +22,13 @@
 #include "common/common.h"
 #include "os/memmgr.h"
 #include "os/mutex.h"
+#include "memmgr/arena.h"
+#include "memmgr/pool.h"
 #include "utils/cstring.h"
 
+/* Macro definitions ---------------------------------------------------------*/
+#define MUTEX_POOL_SIZE		(4)
+
 /* Types ---------------------------------------------------------------------*/
 typedef struct
 {
@@ -35,18 +40,22 @@ typedef struct
 /* Prototypes ----------------------------------------------------------------*/
 static void		mutex_obj_delete		(object_t *self);
 static char *		mutex_obj_to_string		(object_t *self);
+static char *		mutex_obj_to_string_arena	(object_t *self,
+							 mm_arena_t *arena);
 
 /* Variables & constants -----------------------------------------------------*/
 static const object_ops_t gs_mutex_object_ops = {
 		.delete = mutex_obj_delete,
-		.to_string = mutex_obj_to_string
+		.to_string = mutex_obj_to_string,
+		.to_string_arena = mutex_obj_to_string_arena
 };
+static mm_pool_declare(gs_mutex_pool, sizeof(unix_mutex_t), MUTEX_POOL_SIZE);
 
 /* Functions definitions -----------------------------------------------------*/
 static void mutex_obj_delete(object_t *self)
 {
 	unix_mutex_t *this = base_of(base_of(self, mutex_t), unix_mutex_t);
-	mm_free(this);
+	mm_pool_free(&gs_mutex_pool, this);
 }
 
 static char *mutex_obj_to_string(object_t *self)
@@ -55,10 +64,16 @@ static char *mutex_obj_to_string(object_t *self)
 	return cstring_dup(this->name);
 }
 
+static char *mutex_obj_to_string_arena(object_t *self, mm_arena_t *arena)
+{
+	unix_mutex_t *this = base_of(base_of(self, mutex_t), unix_mutex_t);
+	return cstring_dup_arena(this->name, arena);
+}
+
 mutex_t *mutex_new(bool locked, const char *name)
 {
 	mutex_t *base = NULL;
-	unix_mutex_t *this = mm_zalloc(sizeof(unix_mutex_t));
+	unix_mutex_t *this = mm_pool_zalloc(&gs_mutex_pool);
 	if (this != NULL) {
 		this->base.base.ops = &gs_mutex_object_ops;
 		this->name = name;
@@ -79,9 +94,19 @@ bool mutex_lock(mutex_t *self, int32_t ms)
 	}
 	unix_mutex_t *this = base_of(self, unix_mutex_t);
 
+	if (ms < 0) {
+		return (pthread_mutex_lock(&this->mtx) == 0);
+	}
+
+	/* pthread_mutex_timedlock expects an absolute deadline */
 	struct timespec t = {0};
-	t.tv_sec = ms/1000;
-	t.tv_nsec = (ms - 1000*t.tv_sec) * 1000000;
+	clock_gettime(CLOCK_REALTIME, &t);
+	t.tv_sec += ms/1000;
+	t.tv_nsec += (ms % 1000) * 1000000;
+	if (t.tv_nsec >= 1000000000) {
+		t.tv_sec++;
+		t.tv_nsec -= 1000000000;
+	}
 
 	return (pthread_mutex_timedlock(&this->mtx, &t) == 0);
 }
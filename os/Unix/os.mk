@@ -16,13 +16,23 @@ OS_DIR = os/Unix
 
 OS_SRCS = \
 	$(OS_DIR)/task.c \
-	$(OS_DIR)/task_test.c \
 	$(OS_DIR)/mutex.c \
+	$(OS_DIR)/system.c \
+	$(OS_DIR)/heap_file.c
+
+OS_TESTS_SRCS = \
+	$(OS_DIR)/task_test.c \
 	$(OS_DIR)/mutex_test.c \
-	$(OS_DIR)/system.c
-	
+	$(OS_DIR)/heap_file_test.c
+
+# dladdr
+OS_CFLAGS += -D_GNU_SOURCE
+
+ifeq ($(TESTS),yes)
+OS_SRCS += $(OS_TESTS_SRCS)
 OS_CFLAGS += -include "unity_fixture.h"
-LDFLAGS += -pthread
+endif
+LDFLAGS += -pthread -ldl
 
 DEPS += $(call src_to_dep,$(OS_SRCS))
 OBJS += $(call src_to_obj,$(OS_SRCS))
@@ -15,11 +15,24 @@
 */
 
 /* Includes ------------------------------------------------------------------*/
+#include <dlfcn.h>
+#include <stdint.h>
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <sys/mman.h>
 #include "os/system.h"
 #include "os/task.h"
 
+/* macros --------------------------------------------------------------------*/
+#ifndef MAP_FIXED_NOREPLACE
+/* older headers, older kernels take it as a hint and the result is checked */
+#define MAP_FIXED_NOREPLACE	(0x100000)
+#endif
+/* tries, and distance between them, to map a region close to the hint */
+#define REGION_TRIES		(16)
+#define REGION_STEP		(64 * 1024 * 1024)
+
 /* function's prototypes -----------------------------------------------------*/
 static void system_entry_wrapper(void *v)
 {
@@ -40,3 +53,60 @@ void system_boot(system_entry_t *entry)
 		task_delay_ms(10);
 	}
 }
+
+uint32_t system_time_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000));
+}
+
+uint32_t system_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec);
+}
+
+void *system_region_get(void *hint, uint32_t *size)
+{
+	uintptr_t page = sysconf(_SC_PAGESIZE);
+	uintptr_t len = (*size + page - 1) & ~(page - 1);
+	uintptr_t want = ((uintptr_t)hint + page - 1) & ~(page - 1);
+	if ((len == 0) || (len > UINT32_MAX)) {
+		return NULL;
+	}
+
+	// anywhere far away would be refused by the memory manager
+	for (uint32_t i = 0; i < REGION_TRIES; i++, want += REGION_STEP) {
+		void *region = mmap((void *)want, len, PROT_READ | PROT_WRITE,
+				    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+				    -1, 0);
+		if (region == MAP_FAILED) {
+			continue;
+		}
+		if ((uintptr_t)region == want) {
+			*size = len;
+			return region;
+		}
+		munmap(region, len);
+	}
+	return NULL;
+}
+
+void system_region_put(void *region, uint32_t size)
+{
+	munmap(region, size);
+}
+
+bool system_symbol_get(const void *addr, const char **name, uintptr_t *offset)
+{
+	// only symbols of the dynamic table, link with -rdynamic to see them all
+	Dl_info info;
+	if ((dladdr(addr, &info) == 0) || (info.dli_sname == NULL)) {
+		return false;
+	}
+	*name = info.dli_sname;
+	*offset = (uintptr_t)addr - (uintptr_t)info.dli_saddr;
+	return true;
+}
@@ -21,7 +21,11 @@
 #include <pthread.h>
 #include <unistd.h>
 #include "common/common.h"
+#include "os/memmgr.h"
 #include "os/task.h"
+#include "memmgr/arena.h"
+#include "memmgr/leak.h"
+#include "memmgr_conf.h"
 
 /* Types ---------------------------------------------------------------------*/
 typedef struct
@@ -34,21 +38,36 @@ typedef struct
 	uint32_t	priority;
 	char *		name;
 	bool		must_stop;
+#if MM_CFG_TASK_CACHE
+	mm_cache_t	cache;
+#endif
+#if MM_CFG_LATENCY
+	mm_latency_t	latency;
+#endif
+#if MM_CFG_ZONE
+	struct mm_zone	*zone;
+#endif
 }	task_internal_t;
 
 /* Prototypes ----------------------------------------------------------------*/
 static void *		task_wrapper		(void *arg);
 static void		task_delete		(object_t *base);
+static char *		task_to_string_fill	(task_internal_t *self,
+						 char *string);
 static char *		task_to_string		(object_t *base);
+static char *		task_to_string_arena	(object_t *base,
+						 mm_arena_t *arena);
 static void		task_delay_ms_internal	(int32_t ms);
 
 /* Variables -----------------------------------------------------------------*/
 static cexcept_ctx_t *gs_ctx = NULL;
 static object_ops_t gs_obj_ops = {
 	.delete = task_delete,
-	.to_string = task_to_string
+	.to_string = task_to_string,
+	.to_string_arena = task_to_string_arena
 };
 static volatile uint32_t gs_task_running_count = 0;
+static __thread task_internal_t *gs_self = NULL;
 
 task_delay_ms_f	task_delay_ms = task_delay_ms_internal;
 
@@ -56,7 +75,15 @@ task_delay_ms_f	task_delay_ms = task_delay_ms_internal;
 static void *task_wrapper(void *arg)
 {
 	task_internal_t *t = arg;
+	gs_self = t;
 	t->routine(t->arg);
+#if MM_CFG_TASK_CACHE
+	mm_cache_drain(&t->cache);
+#endif
+#if MM_CFG_LEAK
+	mm_leak_task_exit(&t->base);
+#endif
+	gs_self = NULL;
 	gs_task_running_count--;
 	return NULL;
 }
@@ -66,28 +93,45 @@ static void task_delete(object_t *base)
 	task_t *this = base_of(base, task_t);
 	task_internal_t *self = base_of(this, task_internal_t);
 	task_stop(this);
+#if MM_CFG_TASK_CACHE
+	mm_cache_drain(&self->cache);
+#endif
 	free(self);
 }
 
-static char *task_to_string(object_t *base)
+/* string holds the length of the description plus one */
+static char *task_to_string_fill(task_internal_t *self, char *string)
 {
-	task_t *this = base_of(base, task_t);
-	task_internal_t *self = base_of(this, task_internal_t);
-
 	const char *prefix = "task: ";
 	uint32_t prefix_len = strlen(prefix);
 	uint32_t name_len = strlen(self->name);
-	uint32_t total = prefix_len + name_len;
 
-	char * string = malloc(total + 1);
 	if (string != NULL) {
 		strncpy(string, prefix, prefix_len);
 		strncpy(string + prefix_len, self->name, name_len);
-		string[total] = '\0';
+		string[prefix_len + name_len] = '\0';
 	}
 	return string;
 }
 
+static char *task_to_string(object_t *base)
+{
+	task_t *this = base_of(base, task_t);
+	task_internal_t *self = base_of(this, task_internal_t);
+
+	uint32_t total = strlen("task: ") + strlen(self->name);
+	return task_to_string_fill(self, mm_alloc(total + 1));
+}
+
+static char *task_to_string_arena(object_t *base, mm_arena_t *arena)
+{
+	task_t *this = base_of(base, task_t);
+	task_internal_t *self = base_of(this, task_internal_t);
+
+	uint32_t total = strlen("task: ") + strlen(self->name);
+	return task_to_string_fill(self, mm_arena_alloc(arena, total + 1));
+}
+
 static void task_delay_ms_internal(int32_t ms)
 {
 	usleep(ms * 1000);
@@ -121,6 +165,15 @@ task_t *task_create(task_method_f routine, void *arg, uint32_t stack_size,
 	self->stack_size = stack_size;
 	self->priority = priority;
 	self->name = name;
+#if MM_CFG_TASK_CACHE
+	mm_cache_init(&self->cache);
+#endif
+#if MM_CFG_LATENCY
+	mm_latency_init(&self->latency);
+#endif
+#if MM_CFG_ZONE
+	self->zone = NULL;
+#endif
 
 	return &self->base;
 }
@@ -159,3 +212,47 @@ uint32_t task_running_count(void)
 {
 	return gs_task_running_count;
 }
+
+task_t *task_self(void)
+{
+	if (gs_self == NULL) {
+		return NULL;
+	}
+	return &gs_self->base;
+}
+
+mm_cache_t *task_mm_cache_get(void)
+{
+#if MM_CFG_TASK_CACHE
+	if (gs_self != NULL) {
+		return &gs_self->cache;
+	}
+#endif
+	return NULL;
+}
+
+mm_latency_t *task_mm_latency_get(task_t *this)
+{
+#if MM_CFG_LATENCY
+	task_internal_t *self = gs_self;
+	if (this != NULL) {
+		self = base_of(this, task_internal_t);
+	}
+	if (self != NULL) {
+		return &self->latency;
+	}
+#else
+	(void)this;
+#endif
+	return NULL;
+}
+
+struct mm_zone **task_mm_zone_get(void)
+{
+#if MM_CFG_ZONE
+	if (gs_self != NULL) {
+		return &gs_self->zone;
+	}
+#endif
+	return NULL;
+}
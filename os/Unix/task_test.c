@@ -17,7 +17,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdlib.h>
 #include "unity_fixture.h"
+#include "os/memmgr.h"
 #include "os/task.h"
+#include "memmgr/arena.h"
 
 static task_t *gs_tsk = NULL;
 static volatile uint32_t gs_counter = 0;
@@ -35,6 +37,7 @@ TEST_GROUP(task);
 TEST_GROUP_RUNNER(task)
 {
 	RUN_TEST_CASE(task, to_string);
+	RUN_TEST_CASE(task, to_string_arena);
 	RUN_TEST_CASE(task, alloc_failure_returns_null);
 	RUN_TEST_CASE(task, delete_cancel_thread);
 	RUN_TEST_CASE(task, count_running_tasks);
@@ -57,7 +60,17 @@ TEST(task, to_string)
 {
 	char *string = object_to_string(&gs_tsk->base);
 	TEST_ASSERT_EQUAL_STRING("task: test_task", string);
-	free(string);
+	mm_free(string);
+}
+
+TEST(task, to_string_arena)
+{
+	mm_arena_t arena;
+	mm_arena_init(&arena, 64);
+
+	char *string = object_to_string_arena(&gs_tsk->base, &arena);
+	TEST_ASSERT_EQUAL_STRING("task: test_task", string);
+	mm_arena_reset(&arena);
 }
 
 TEST(task, alloc_failure_returns_null)
@@ -0,0 +1,35 @@
+#	Copyright 2014 Chauveau Wilfried
+#
+#	Licensed under the Apache License, Version 2.0 (the "License");
+#	you may not use this file except in compliance with the License.
+#	You may obtain a copy of the License at
+#
+#		 http://www.apache.org/licenses/LICENSE-2.0
+#
+#	Unless required by applicable law or agreed to in writing, software
+#	distributed under the License is distributed on an "AS IS" BASIS,
+#	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#	See the License for the specific language governing permissions and
+#	limitations under the License.
+
+PRJ_NAME = bench
+
+OUT_DIR	= build_bench
+
+MSG_BEGIN	= "-------- bench --------"
+
+BOARD	= host
+OS	= Unix
+OPT	= 2
+
+PRJ_SRCS = projects/bench/mcp/mcp.c \
+	projects/bench/bench/bench.c \
+	projects/bench/bench/replay.c \
+	projects/bench/bench/workloads.c
+
+CFLAGS += -I projects/bench/
+
+DEPS += $(call src_to_dep,$(PRJ_SRCS))
+OBJS += $(call src_to_obj,$(PRJ_SRCS))
+
+$(call build, $(PRJ_SRCS), $(PRJ_CFLAGS))
\ No newline at end of file
@@ -0,0 +1,226 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "os/memmgr.h"
+#include "bench/bench.h"
+
+/* Prototypes ----------------------------------------------------------------*/
+static void *		bench_mm_alloc		(uint32_t size);
+static void *		bench_mm_realloc	(void *ptr,
+						 uint32_t size);
+static void		bench_mm_free		(void *ptr);
+static bool		bench_mm_frag		(double *frag);
+static void *		bench_libc_alloc	(uint32_t size);
+static void *		bench_libc_realloc	(void *ptr,
+						 uint32_t size);
+static void		bench_libc_free		(void *ptr);
+static int		bench_u32_cmp		(const void *a,
+						 const void *b);
+static void		bench_report		(const bench_run_t *this,
+						 const char *workload,
+						 uint64_t elapsed_ns);
+
+/* Variables -----------------------------------------------------------------*/
+static const bench_allocator_t gs_allocators[] = {
+	{
+		.name = "memmgr",
+		.alloc = bench_mm_alloc,
+		.realloc = bench_mm_realloc,
+		.free = bench_mm_free,
+		.alloc_batch = mm_alloc_batch,
+		.free_batch = mm_free_batch,
+		.frag = bench_mm_frag
+	},
+	{
+		.name = "libc",
+		.alloc = bench_libc_alloc,
+		.realloc = bench_libc_realloc,
+		.free = bench_libc_free,
+		.alloc_batch = NULL,
+		.free_batch = NULL,
+		.frag = NULL
+	}
+};
+
+static uint32_t gs_samples[BENCH_OPS];
+
+/* Private Functions definitions ---------------------------------------------*/
+static void *bench_mm_alloc(uint32_t size)
+{
+	return mm_alloc(size);
+}
+
+static void *bench_mm_realloc(void *ptr, uint32_t size)
+{
+	return mm_realloc(ptr, size);
+}
+
+static void bench_mm_free(void *ptr)
+{
+	mm_free(ptr);
+}
+
+static bool bench_mm_frag(double *frag)
+{
+	mm_info_t *infos = mm_info_get();
+	if (infos == NULL) {
+		return false;
+	}
+
+	uint32_t total = 0, largest = 0;
+	for (mm_info_t *it = infos; it->csize != 0; it++) {
+		if (!it->allocated) {
+			total += it->csize;
+			if (it->csize > largest) {
+				largest = it->csize;
+			}
+		}
+	}
+	mm_free(infos);
+
+	*frag = (total == 0) ? 0.0 : 1.0 - ((double)largest / total);
+	return true;
+}
+
+static void *bench_libc_alloc(uint32_t size)
+{
+	return malloc(size);
+}
+
+static void *bench_libc_realloc(void *ptr, uint32_t size)
+{
+	return realloc(ptr, size);
+}
+
+static void bench_libc_free(void *ptr)
+{
+	free(ptr);
+}
+
+static int bench_u32_cmp(const void *a, const void *b)
+{
+	uint32_t l = *(const uint32_t *)a, r = *(const uint32_t *)b;
+	return (l > r) - (l < r);
+}
+
+static void bench_report(const bench_run_t *this, const char *workload,
+			 uint64_t elapsed_ns)
+{
+	uint32_t p50 = 0, p99 = 0, max = 0;
+	if (this->ops != 0) {
+		qsort(this->samples, this->ops, sizeof(uint32_t), bench_u32_cmp);
+		p50 = this->samples[this->ops / 2];
+		p99 = this->samples[((uint64_t)this->ops * 99) / 100];
+		max = this->samples[this->ops - 1];
+	}
+	double ops_per_sec = (elapsed_ns == 0) ? 0.0 :
+			     (this->ops * 1e9) / elapsed_ns;
+
+	printf("{\"allocator\":\"%s\",\"workload\":\"%s\",\"ops\":%u,"
+	       "\"ops_per_sec\":%.0f,\"p50_ns\":%u,\"p99_ns\":%u,"
+	       "\"max_ns\":%u,\"fragmentation\":",
+	       this->alloc->name, workload, this->ops, ops_per_sec,
+	       p50, p99, max);
+	if (this->has_frag) {
+		printf("%.4f}\n", this->frag);
+	} else {
+		printf("null}\n");
+	}
+	fflush(stdout);
+}
+
+/* Functions definitions -----------------------------------------------------*/
+uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+uint32_t bench_rand(uint32_t *seed)
+{
+	/* xorshift32: runs are reproducible and identical for each allocator */
+	uint32_t x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return x;
+}
+
+void bench_sample(bench_run_t *this, uint64_t t0)
+{
+	uint64_t dt = bench_now_ns() - t0;
+	if (this->ops < this->max_ops) {
+		this->samples[this->ops++] = (dt > UINT32_MAX) ? UINT32_MAX : dt;
+	}
+}
+
+void bench_sample_n(bench_run_t *this, uint64_t t0, uint32_t n)
+{
+	if (n == 0) {
+		return;
+	}
+	uint64_t dt = (bench_now_ns() - t0) / n;
+	while ((n-- != 0) && (this->ops < this->max_ops)) {
+		this->samples[this->ops++] = (dt > UINT32_MAX) ? UINT32_MAX : dt;
+	}
+}
+
+void bench_frag_sample(bench_run_t *this)
+{
+	uint64_t t0 = bench_now_ns();
+	if ((this->alloc->frag != NULL) && this->alloc->frag(&this->frag)) {
+		this->has_frag = true;
+	}
+	this->paused_ns += bench_now_ns() - t0;
+}
+
+void bench_run(const bench_workload_t *workload, uint32_t *samples,
+	       uint32_t max_ops)
+{
+	uint32_t count = sizeof(gs_allocators) / sizeof(gs_allocators[0]);
+	for (uint32_t a = 0; a < count; a++) {
+		bench_run_t run = {
+			.alloc = &gs_allocators[a],
+			.seed = 0x2545F491,
+			.samples = samples,
+			.ops = 0,
+			.max_ops = max_ops,
+			.paused_ns = 0,
+			.has_frag = false,
+			.frag = 0.0
+		};
+
+		uint64_t t0 = bench_now_ns();
+		workload->run(&run);
+		uint64_t elapsed = bench_now_ns() - t0 - run.paused_ns;
+
+		bench_report(&run, workload->name, elapsed);
+	}
+}
+
+void bench_run_all(void)
+{
+	for (uint32_t w = 0; w < g_bench_workload_count; w++) {
+		bench_run(&g_bench_workloads[w], gs_samples, BENCH_OPS);
+	}
+}
@@ -0,0 +1,116 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define		BENCH_OPS		(200000)
+#define		BENCH_SLOTS		(256)
+#define		BENCH_TASKS		(4)
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct
+{
+	const char	*name;
+	void *		(*alloc)	(uint32_t size);
+	void *		(*realloc)	(void *ptr,
+					 uint32_t size);
+	void		(*free)		(void *ptr);
+	/**
+	 * Allocate or free n blocks in a single call, NULL when the allocator
+	 * has no such entry point.
+	 * @return	Number of blocks allocated, out is NULL for the others.
+	 */
+	uint32_t	(*alloc_batch)	(uint32_t n,
+					 const uint32_t *sizes,
+					 void **out);
+	void		(*free_batch)	(void **ptrs,
+					 uint32_t n);
+	/**
+	 * 1 - largest free block / total free space.
+	 * @return	false if the allocator cannot tell.
+	 */
+	bool		(*frag)		(double *frag);
+} bench_allocator_t;
+
+typedef struct
+{
+	const bench_allocator_t	*alloc;
+	uint32_t		seed;
+
+	/* one latency sample per operation, in ns */
+	uint32_t		*samples;
+	uint32_t		ops;
+	uint32_t		max_ops;
+	/* time spent out of the workload, not accounted in ops_per_sec */
+	uint64_t		paused_ns;
+
+	bool			has_frag;
+	double			frag;
+} bench_run_t;
+
+typedef struct
+{
+	const char	*name;
+	void		(*run)		(bench_run_t *run);
+} bench_workload_t;
+
+/* Functions prototypes ------------------------------------------------------*/
+uint64_t		bench_now_ns		(void);
+uint32_t		bench_rand		(uint32_t *seed);
+/**
+ * Record the latency of one operation started at t0.
+ */
+void			bench_sample		(bench_run_t *this,
+						 uint64_t t0);
+/**
+ * Record n operations done by a single call started at t0, each at the
+ * average latency.
+ */
+void			bench_sample_n		(bench_run_t *this,
+						 uint64_t t0,
+						 uint32_t n);
+/**
+ * Sample the allocator fragmentation, workloads call it with their live set
+ * still allocated.
+ */
+void			bench_frag_sample	(bench_run_t *this);
+/**
+ * Run a workload against every allocator, one JSON line per run.
+ * @param	samples	Room for max_ops latency samples.
+ */
+void			bench_run		(const bench_workload_t *workload,
+						 uint32_t *samples,
+						 uint32_t max_ops);
+/**
+ * Run every workload against every allocator.
+ */
+void			bench_run_all		(void);
+/**
+ * Replay a trace flushed by mm_trace_flush() against every allocator.
+ * @return	false if the trace cannot be loaded.
+ */
+bool			bench_replay		(const char *path);
+
+extern const bench_workload_t	g_bench_workloads[];
+extern const uint32_t		g_bench_workload_count;
+
+#endif
@@ -0,0 +1,226 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memmgr/trace.h"
+#include "bench/bench.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+#define		BENCH_MAP_EMPTY		((uintptr_t)0)
+/* traced blocks are 32-bit offsets */
+#define		BENCH_MAP_TOMB		(UINTPTR_MAX)
+
+/* Type definitions ----------------------------------------------------------*/
+/* a trace record, with its recorded pointer turned into a live block index */
+typedef struct
+{
+	uint8_t		op;
+	uint32_t	size;
+	uint32_t	id;
+} bench_replay_op_t;
+
+typedef struct
+{
+	uintptr_t	key;
+	uint32_t	id;
+} bench_map_entry_t;
+
+typedef struct
+{
+	bench_map_entry_t	*entries;
+	uint32_t		mask;
+} bench_map_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+static bench_map_entry_t *bench_map_find	(bench_map_t *this,
+						 uintptr_t key,
+						 bool insert);
+static bool		bench_replay_load	(const char *path);
+static void		bench_replay_run	(bench_run_t *run);
+
+/* Variables -----------------------------------------------------------------*/
+static bench_replay_op_t	*gs_ops = NULL;
+static uint32_t			gs_count = 0;
+static void			**gs_live = NULL;
+static uint32_t			gs_ids = 0;
+
+static const bench_workload_t	gs_replay = {
+	.name = "replay",
+	.run = bench_replay_run
+};
+
+/* Private Functions definitions ---------------------------------------------*/
+static bench_map_entry_t *bench_map_find(bench_map_t *this, uintptr_t key,
+					 bool insert)
+{
+	bench_map_entry_t *tomb = NULL;
+	uint32_t i = (uint32_t)key * 2654435761u;
+	for (;; i++) {
+		bench_map_entry_t *e = &this->entries[i & this->mask];
+		if (e->key == key) {
+			return e;
+		}
+		if ((e->key == BENCH_MAP_TOMB) && (tomb == NULL)) {
+			tomb = e;
+		} else if (e->key == BENCH_MAP_EMPTY) {
+			if (!insert) {
+				return NULL;
+			}
+			e = (tomb != NULL) ? tomb : e;
+			e->key = key;
+			return e;
+		}
+	}
+}
+
+/**
+ * Load a trace and number the blocks it works on, so that replaying it does
+ * not involve any lookup.
+ */
+static bool bench_replay_load(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "bench: cannot open %s\n", path);
+		return false;
+	}
+
+	mm_trace_header_t hdr;
+	if ((fread(&hdr, sizeof(hdr), 1, f) != 1) ||
+	    (hdr.magic != MM_TRACE_MAGIC) ||
+	    (hdr.version != MM_TRACE_VERSION) ||
+	    (hdr.record_size != sizeof(mm_trace_record_t))) {
+		fprintf(stderr, "bench: %s is not a trace of this target\n", path);
+		fclose(f);
+		return false;
+	}
+
+	uint32_t size = 1;
+	while (size < (hdr.count * 2) + 1) {
+		size <<= 1;
+	}
+	bench_map_t map = {
+		.entries = calloc(size, sizeof(bench_map_entry_t)),
+		.mask = size - 1
+	};
+	gs_ops = malloc((hdr.count + 1) * sizeof(bench_replay_op_t));
+	gs_count = 0;
+	gs_ids = 0;
+
+	mm_trace_record_t rec;
+	for (uint32_t i = 0; i < hdr.count; i++) {
+		if (fread(&rec, sizeof(rec), 1, f) != 1) {
+			break;
+		}
+		// failed allocations and frees of NULL leave nothing to replay
+		if (rec.ptr == BENCH_MAP_EMPTY) {
+			continue;
+		}
+
+		bench_replay_op_t *op = &gs_ops[gs_count];
+		bench_map_entry_t *e = NULL;
+		op->op = MM_TRACE_OP(&rec);
+		op->size = rec.size;
+
+		if (op->op == MM_TRACE_FREE) {
+			// blocks allocated before the trace started are unknown
+			e = bench_map_find(&map, rec.ptr, false);
+			if (e == NULL) {
+				continue;
+			}
+			op->id = e->id;
+			e->key = BENCH_MAP_TOMB;
+		} else {
+			uint32_t id = gs_ids;
+			// a realloc of NULL starts a new block
+			if ((op->op == MM_TRACE_REALLOC) &&
+			    (rec.old_ptr != BENCH_MAP_EMPTY)) {
+				e = bench_map_find(&map, rec.old_ptr, false);
+				if (e != NULL) {
+					id = e->id;
+					e->key = BENCH_MAP_TOMB;
+				}
+			}
+			if (id == gs_ids) {
+				gs_ids++;
+			}
+			op->id = id;
+			bench_map_find(&map, rec.ptr, true)->id = id;
+		}
+		gs_count++;
+	}
+
+	fclose(f);
+	free(map.entries);
+	gs_live = calloc(gs_ids + 1, sizeof(void *));
+	return true;
+}
+
+static void bench_replay_run(bench_run_t *run)
+{
+	const bench_allocator_t *a = run->alloc;
+	memset(gs_live, 0, gs_ids * sizeof(void *));
+
+	for (uint32_t i = 0; i < gs_count; i++) {
+		const bench_replay_op_t *op = &gs_ops[i];
+		void **live = &gs_live[op->id];
+		uint64_t t0 = bench_now_ns();
+
+		switch (op->op) {
+		case MM_TRACE_ALLOC:
+			*live = a->alloc(op->size);
+			break;
+		case MM_TRACE_REALLOC: {
+			// the old block may have failed to allocate here
+			void *ptr = a->realloc(*live, op->size);
+			*live = (ptr != NULL) ? ptr : *live;
+			break;
+		}
+		case MM_TRACE_FREE:
+			a->free(*live);
+			*live = NULL;
+			break;
+		default:
+			continue;
+		}
+		bench_sample(run, t0);
+	}
+
+	bench_frag_sample(run);
+	for (uint32_t i = 0; i < gs_ids; i++) {
+		a->free(gs_live[i]);
+	}
+}
+
+/* Functions definitions -----------------------------------------------------*/
+bool bench_replay(const char *path)
+{
+	if (!bench_replay_load(path)) {
+		return false;
+	}
+
+	uint32_t *samples = malloc((gs_count + 1) * sizeof(uint32_t));
+	bench_run(&gs_replay, samples, gs_count);
+
+	free(samples);
+	free(gs_live);
+	free(gs_ops);
+	return true;
+}
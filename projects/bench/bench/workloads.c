@@ -0,0 +1,327 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+
+#include "common/object.h"
+#include "os/task.h"
+#include "bench/bench.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+#define		BENCH_REALLOC_SLOTS	(64)
+#define		BENCH_REALLOC_MAX	(4096)
+#define		BENCH_BATCH_COUNT	(32)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef uint32_t	(*bench_size_f)		(uint32_t *seed);
+
+typedef struct
+{
+	bench_run_t	run;
+	void		*slots[BENCH_SLOTS / BENCH_TASKS];
+} bench_worker_t;
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint32_t		bench_size_uniform	(uint32_t *seed);
+static uint32_t		bench_size_small	(uint32_t *seed);
+static uint32_t		bench_size_power	(uint32_t *seed);
+static void		bench_churn		(bench_run_t *run,
+						 bench_size_f size,
+						 void **slots,
+						 uint32_t count);
+static void		bench_worker		(void *arg);
+static void		bench_batch_rounds	(bench_run_t *run,
+						 bool batched);
+
+static void		bench_uniform		(bench_run_t *run);
+static void		bench_power_law		(bench_run_t *run);
+static void		bench_lifo		(bench_run_t *run);
+static void		bench_fifo		(bench_run_t *run);
+static void		bench_realloc_growth	(bench_run_t *run);
+static void		bench_contention	(bench_run_t *run);
+static void		bench_batch		(bench_run_t *run);
+static void		bench_batch_loop	(bench_run_t *run);
+
+/* Variables -----------------------------------------------------------------*/
+const bench_workload_t g_bench_workloads[] = {
+	{ .name = "uniform",		.run = bench_uniform },
+	{ .name = "power_law",		.run = bench_power_law },
+	{ .name = "lifo",		.run = bench_lifo },
+	{ .name = "fifo",		.run = bench_fifo },
+	{ .name = "realloc_growth",	.run = bench_realloc_growth },
+	{ .name = "contention",		.run = bench_contention },
+	{ .name = "batch",		.run = bench_batch },
+	{ .name = "batch_loop",		.run = bench_batch_loop }
+};
+const uint32_t g_bench_workload_count =
+	sizeof(g_bench_workloads) / sizeof(g_bench_workloads[0]);
+
+/* Private Functions definitions ---------------------------------------------*/
+static uint32_t bench_size_uniform(uint32_t *seed)
+{
+	return 1 + (bench_rand(seed) % 512);
+}
+
+static uint32_t bench_size_small(uint32_t *seed)
+{
+	return 16 + (bench_rand(seed) % 241);
+}
+
+static uint32_t bench_size_power(uint32_t *seed)
+{
+	/* size class k is picked with probability 2^-(k+1): mostly tiny blocks
+	 * and a long tail up to 8KiB */
+	uint32_t k = __builtin_ctz(bench_rand(seed) | (1 << 9));
+	uint32_t base = 8 << k;
+	return base + (bench_rand(seed) % base);
+}
+
+/**
+ * Randomly allocate or free one of the slots, until run->max_ops operations
+ * were timed. Everything left is freed untimed.
+ */
+static void bench_churn(bench_run_t *run, bench_size_f size, void **slots,
+			uint32_t count)
+{
+	const bench_allocator_t *a = run->alloc;
+	memset(slots, 0, count * sizeof(void *));
+
+	while (run->ops < run->max_ops) {
+		uint32_t i = bench_rand(&run->seed) % count;
+		if (slots[i] != NULL) {
+			uint64_t t0 = bench_now_ns();
+			a->free(slots[i]);
+			bench_sample(run, t0);
+			slots[i] = NULL;
+		} else {
+			uint32_t s = size(&run->seed);
+			uint64_t t0 = bench_now_ns();
+			slots[i] = a->alloc(s);
+			bench_sample(run, t0);
+		}
+	}
+
+	bench_frag_sample(run);
+	for (uint32_t i = 0; i < count; i++) {
+		a->free(slots[i]);
+	}
+}
+
+static void bench_worker(void *arg)
+{
+	bench_worker_t *this = arg;
+	bench_churn(&this->run, bench_size_small, this->slots,
+		    BENCH_SLOTS / BENCH_TASKS);
+}
+
+/**
+ * Allocate BENCH_BATCH_COUNT small blocks then free them all, with the batch
+ * entry points of the allocator when it has them and batched is set.
+ */
+static void bench_batch_rounds(bench_run_t *run, bool batched)
+{
+	const bench_allocator_t *a = run->alloc;
+	uint32_t sizes[BENCH_BATCH_COUNT];
+	void *ptrs[BENCH_BATCH_COUNT];
+
+	while (run->ops < run->max_ops) {
+		for (uint32_t i = 0; i < BENCH_BATCH_COUNT; i++) {
+			sizes[i] = bench_size_small(&run->seed);
+		}
+
+		if (batched && (a->alloc_batch != NULL)) {
+			uint64_t t0 = bench_now_ns();
+			a->alloc_batch(BENCH_BATCH_COUNT, sizes, ptrs);
+			bench_sample_n(run, t0, BENCH_BATCH_COUNT);
+		} else {
+			for (uint32_t i = 0; i < BENCH_BATCH_COUNT; i++) {
+				uint64_t t0 = bench_now_ns();
+				ptrs[i] = a->alloc(sizes[i]);
+				bench_sample(run, t0);
+			}
+		}
+		if (!run->has_frag) {
+			bench_frag_sample(run);
+		}
+
+		if (batched && (a->free_batch != NULL)) {
+			uint64_t t0 = bench_now_ns();
+			a->free_batch(ptrs, BENCH_BATCH_COUNT);
+			bench_sample_n(run, t0, BENCH_BATCH_COUNT);
+		} else {
+			for (uint32_t i = 0; i < BENCH_BATCH_COUNT; i++) {
+				uint64_t t0 = bench_now_ns();
+				a->free(ptrs[i]);
+				bench_sample(run, t0);
+			}
+		}
+	}
+}
+
+static void bench_uniform(bench_run_t *run)
+{
+	void *slots[BENCH_SLOTS];
+	bench_churn(run, bench_size_uniform, slots, BENCH_SLOTS);
+}
+
+static void bench_power_law(bench_run_t *run)
+{
+	void *slots[BENCH_SLOTS];
+	bench_churn(run, bench_size_power, slots, BENCH_SLOTS);
+}
+
+static void bench_lifo(bench_run_t *run)
+{
+	const bench_allocator_t *a = run->alloc;
+	void *stack[BENCH_SLOTS];
+
+	while (run->ops < run->max_ops) {
+		uint32_t depth = 1 + (bench_rand(&run->seed) % BENCH_SLOTS);
+		for (uint32_t i = 0; i < depth; i++) {
+			uint32_t s = bench_size_small(&run->seed);
+			uint64_t t0 = bench_now_ns();
+			stack[i] = a->alloc(s);
+			bench_sample(run, t0);
+		}
+		if (!run->has_frag) {
+			bench_frag_sample(run);
+		}
+		while (depth-- != 0) {
+			uint64_t t0 = bench_now_ns();
+			a->free(stack[depth]);
+			bench_sample(run, t0);
+		}
+	}
+}
+
+static void bench_fifo(bench_run_t *run)
+{
+	const bench_allocator_t *a = run->alloc;
+	void *ring[BENCH_SLOTS];
+	uint32_t head = 0;
+
+	for (uint32_t i = 0; i < BENCH_SLOTS; i++) {
+		uint32_t s = bench_size_small(&run->seed);
+		uint64_t t0 = bench_now_ns();
+		ring[i] = a->alloc(s);
+		bench_sample(run, t0);
+	}
+	while (run->ops < run->max_ops) {
+		uint64_t t0 = bench_now_ns();
+		a->free(ring[head]);
+		bench_sample(run, t0);
+
+		uint32_t s = bench_size_small(&run->seed);
+		t0 = bench_now_ns();
+		ring[head] = a->alloc(s);
+		bench_sample(run, t0);
+
+		head = (head + 1) % BENCH_SLOTS;
+	}
+
+	bench_frag_sample(run);
+	for (uint32_t i = 0; i < BENCH_SLOTS; i++) {
+		a->free(ring[i]);
+	}
+}
+
+static void bench_realloc_growth(bench_run_t *run)
+{
+	const bench_allocator_t *a = run->alloc;
+	void *slots[BENCH_REALLOC_SLOTS];
+	uint32_t sizes[BENCH_REALLOC_SLOTS];
+	memset(slots, 0, sizeof(slots));
+	memset(sizes, 0, sizeof(sizes));
+
+	while (run->ops < run->max_ops) {
+		uint32_t i = bench_rand(&run->seed) % BENCH_REALLOC_SLOTS;
+		uint32_t s = sizes[i] + 16 + (bench_rand(&run->seed) % 64);
+		if (s > BENCH_REALLOC_MAX) {
+			uint64_t t0 = bench_now_ns();
+			a->free(slots[i]);
+			bench_sample(run, t0);
+			slots[i] = NULL;
+			sizes[i] = 0;
+			continue;
+		}
+
+		uint64_t t0 = bench_now_ns();
+		void *ptr = a->realloc(slots[i], s);
+		bench_sample(run, t0);
+		if (ptr != NULL) {
+			slots[i] = ptr;
+			sizes[i] = s;
+		}
+	}
+
+	bench_frag_sample(run);
+	for (uint32_t i = 0; i < BENCH_REALLOC_SLOTS; i++) {
+		a->free(slots[i]);
+	}
+}
+
+static void bench_contention(bench_run_t *run)
+{
+	static bench_worker_t workers[BENCH_TASKS];
+	task_t *tasks[BENCH_TASKS];
+
+	for (uint32_t i = 0; i < BENCH_TASKS; i++) {
+		bench_run_t *w = &workers[i].run;
+		w->alloc = run->alloc;
+		w->seed = run->seed + i;
+		w->samples = run->samples + (i * (run->max_ops / BENCH_TASKS));
+		w->ops = 0;
+		w->max_ops = run->max_ops / BENCH_TASKS;
+		w->paused_ns = 0;
+		w->has_frag = false;
+
+		tasks[i] = task_create(bench_worker, &workers[i], 0, 1,
+				       "bench worker");
+	}
+	for (uint32_t i = 0; i < BENCH_TASKS; i++) {
+		if (tasks[i] != NULL) {
+			task_start(tasks[i]);
+		}
+	}
+
+	/* deleting a task waits for it to complete */
+	for (uint32_t i = 0; i < BENCH_TASKS; i++) {
+		if (tasks[i] != NULL) {
+			object_delete(&tasks[i]->base);
+		}
+		/* workers fill contiguous slices, the last one is full */
+		memmove(run->samples + run->ops, workers[i].run.samples,
+			workers[i].run.ops * sizeof(uint32_t));
+		run->ops += workers[i].run.ops;
+	}
+
+	/* workers sampled concurrently, the first one stands for all */
+	run->paused_ns = workers[0].run.paused_ns;
+	run->has_frag = workers[0].run.has_frag;
+	run->frag = workers[0].run.frag;
+}
+
+static void bench_batch(bench_run_t *run)
+{
+	bench_batch_rounds(run, true);
+}
+
+static void bench_batch_loop(bench_run_t *run)
+{
+	bench_batch_rounds(run, false);
+}
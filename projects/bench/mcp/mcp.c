@@ -0,0 +1,46 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "os/memmgr.h"
+#include "bench/bench.h"
+#include "mcp/mcp.h"
+
+static void mcp_entry(void);
+
+system_entry_t g_mcp_entry  =
+{
+	.entry = mcp_entry,
+	.stack_size = 512,
+	.priority = 1
+};
+
+static uint8_t gs_heap[MM_CFG_HEAP_SIZE] __attribute__((aligned(8)));
+
+static void mcp_entry(void)
+{
+	mm_init(gs_heap, sizeof(gs_heap));
+
+	// BENCH_TRACE names a file flushed by mm_trace_flush() to replay
+	const char *trace = getenv("BENCH_TRACE");
+	if (trace != NULL) {
+		bench_replay(trace);
+	} else {
+		bench_run_all();
+	}
+}
@@ -0,0 +1,7 @@
+
+
+#include "os/system.h"
+/* function's definitions ----------------------------------------------------*/
+
+extern system_entry_t g_mcp_entry;
+
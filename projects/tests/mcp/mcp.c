@@ -45,6 +45,7 @@ static void runAllTests()
 	RUN_TEST_GROUP(stream);
 	RUN_TEST_GROUP(task);
 	RUN_TEST_GROUP(list);
+	RUN_TEST_GROUP(heap_file);
 }
 
 static void mcp_entry(void)
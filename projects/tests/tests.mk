@@ -16,10 +16,18 @@ PRJ_NAME = unit\ tests
 
 OUT_DIR	= build_tests
 
+# a variant builds the same tests in its own directory, with the
+# configuration headers of projects/tests/variants/$(VARIANT) found first
+ifneq ($(VARIANT),)
+OUT_DIR	= build_tests_$(VARIANT)
+CFLAGS += -I projects/tests/variants/$(VARIANT)
+endif
+
 MSG_BEGIN	= "-------- tests --------"
 
 BOARD	= unity
 OS	= Unix
+TESTS	= yes
 
 PRJ_SRCS = projects/tests/mcp/mcp.c
 
@@ -0,0 +1,28 @@
+/*
+	Copyright 2014 Chauveau Wilfried
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+		 http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+*/
+
+#ifndef __TESTS_VARIANT_MEMMGR_CONF_H__
+#define __TESTS_VARIANT_MEMMGR_CONF_H__
+
+/* the unit tests configuration, with guard canaries and 16 bits xorsums */
+#include "../../../../boards/unity/configs/memmgr_conf.h"
+
+#undef		MM_CFG_INTEGRITY
+#define		MM_CFG_INTEGRITY	(2)
+#undef		MM_CFG_CRC32C
+#define		MM_CFG_CRC32C		(0)
+
+#endif